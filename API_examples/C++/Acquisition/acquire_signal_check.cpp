@@ -7,6 +7,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "common/counter.h"
 #include "rp.h"
 #include "rp_hw-profiles.h"
 
@@ -22,7 +23,6 @@ uint32_t getADCRate() {
 }
 
 #define c_osc_fpga_smpl_freq getADCRate()
-#define c_meas_time_thr (ADC_BUFFER_SIZE / (1000000000 / getADCRate()))
 const float c_meas_freq_thr = 0.05;
 const float c_min_period = 19.6e-9; // 51 MHz
 
@@ -43,9 +43,6 @@ void filterBuffer(float *_buffer, int _size) {
 
 bool checkAmplitudeAndFreq(float *_buff, uint32_t _size, float _nominal,
                            float *min, float *max, float *frequency) {
-  int trig_t[2] = {0, 0};
-  int trig_cnt = 0;
-  int state = 0;
   if (_size > 0) {
     *min = _buff[0];
     *max = _buff[0];
@@ -59,36 +56,20 @@ bool checkAmplitudeAndFreq(float *_buff, uint32_t _size, float _nominal,
     uint32_t dec_factor = 1;
     rp_AcqGetDecimationFactor(&dec_factor);
 
-    float acq_dur =
-        (float)(_size) / ((float)c_osc_fpga_smpl_freq) * (float)dec_factor;
     float cen = (*max + *min) / 2;
     float thr1 = cen + 0.2 * (*min - cen);
     float thr2 = cen + 0.2 * (*max - cen);
     float res_period = 0;
-    for (uint32_t i = 0; i < _size; i++) {
-      float sa = _buff[i];
-      if ((state == 0) && (sa < thr1)) {
-        state = 1;
-      }
-      if ((state == 1) && (sa >= thr2)) {
-        state = 0;
-        if (trig_cnt++ == 0) {
-          trig_t[0] = i;
-        } else {
-          trig_t[1] = i;
-        }
-      }
-      if ((trig_t[1] - trig_t[0]) > (int)c_meas_time_thr) {
-        break;
-      }
-    }
-    if (trig_cnt >= 2) {
-      res_period = (float)(trig_t[1] - trig_t[0]) /
-                   ((float)c_osc_fpga_smpl_freq * (trig_cnt - 1)) * dec_factor;
+    /* Reciprocal count over every edge in the buffer, any period with two
+     * rising edges in the buffer is measured */
+    EdgeCounter counter((double)c_osc_fpga_smpl_freq / dec_factor, thr1, thr2);
+    counter.process(_buff, _size);
+    CounterResult result = counter.result();
+    if (result.frequency > 0) {
+      res_period = 1.0 / result.frequency;
     }
 
-    if (((thr2 - thr1) < c_meas_freq_thr) || (res_period * 3 >= acq_dur) ||
-        (res_period < c_min_period)) {
+    if (((thr2 - thr1) < c_meas_freq_thr) || (res_period < c_min_period)) {
       res_period = 0;
     }
     float period = res_period * 1000.f;
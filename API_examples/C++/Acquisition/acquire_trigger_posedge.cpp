@@ -1,12 +1,50 @@
 /* Red Pitaya C++ API example Acquiring a signal from a buffer
- * This application acquires a signal on a specific channel */
+ * This application acquires a signal on a specific channel.
+ * The capture is written to stdout as text by default; -f selects csv, tsv,
+ * ssv, raw or rpcap and -o a file, a FIFO or tcp:host:port. */
 
+#include "common/capture_writer.h"
 #include "rp.h"
+#include "rp_hw-profiles.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-f format] [-o output]\n"
+          "\t-f : csv, tsv, ssv, raw or rpcap (default tsv)\n"
+          "\t-o : File, FIFO, tcp:host:port or - for stdout (default -)\n",
+          prog);
+}
+
 int main(int argc, char **argv) {
+  CaptureFormat format = CaptureFormat::TSV;
+  const char *target = "-";
+  int opt;
+  while ((opt = getopt(argc, argv, "f:o:")) != -1) {
+    switch (opt) {
+    case 'f':
+      if (!captureParseFormat(optarg, &format)) {
+        printHelp(argv[0]);
+        return 1;
+      }
+      break;
+    case 'o':
+      target = optarg;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  int fd = captureOpenOutput(target);
+  if (fd < 0) {
+    fprintf(stderr, "Can't open %s\n", target);
+    return 1;
+  }
 
   /* Print error, if rp_Init() function failed */
   if (rp_Init() != RP_OK) {
@@ -54,11 +92,26 @@ int main(int argc, char **argv) {
   }
 
   rp_AcqGetOldestDataV(RP_CH_1, &buff_size, buff);
-  uint32_t i;
-  for (i = 0; i < buff_size; i++) {
-    printf("%f\n", buff[i]);
+
+  /* One buffered write instead of a printf per sample */
+  CaptureInfo info;
+  info.channels = 1;
+  info.samples = buff_size;
+  info.decimation = 8;
+  info.sampleRate = rp_HPGetBaseFastADCSpeedHzOrDefault() / 8.0;
+  CaptureWriter writer(fd, format);
+  writer.setPrecision(6);
+  writer.begin(info, CaptureSampleType::FLOAT32);
+  writer.write(&buff, buff_size);
+  /* A reader that stopped early, such as head, is not an error */
+  if (!writer.flush() && writer.error() != EPIPE) {
+    fprintf(stderr, "Writing %s failed: %s\n", target,
+            strerror(writer.error()));
   }
   /* Releasing resources */
+  if (fd != STDOUT_FILENO) {
+    close(fd);
+  }
   free(buff);
   rp_Release();
   return 0;
@@ -0,0 +1,134 @@
+/* Red Pitaya C++ API example Capture output benchmark
+ * This application compares writing a 4 channel capture with one printf per
+ * sample, as the acquisition examples used to, against the buffered capture
+ * writer in every output format. No hardware is needed; the samples are
+ * synthesized. Output goes to /dev/null unless -o names a file or FIFO, so
+ * the numbers show formatting cost rather than storage speed. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/capture_writer.h"
+#include "common/timing.h"
+
+#define CHANNELS 4
+
+struct Result {
+  double ms;
+  uint64_t bytes;
+};
+
+auto report(const char *name, uint32_t samples, const Result &r) -> void {
+  printf("%-22s %9.1f ms %8.1f Msamples/s %8.1f MB/s\n", name, r.ms,
+         samples * CHANNELS / r.ms / 1000.0, r.bytes / r.ms / 1000.0);
+}
+
+auto runPrintf(const char *target, const float *const *ch, uint32_t n)
+    -> Result {
+  FILE *f = fopen(target, "w");
+  if (!f) {
+    return {0, 0};
+  }
+  int64_t t = nowNs();
+  for (uint32_t i = 0; i < n; i++) {
+    fprintf(f, "%f %f %f %f\n", ch[0][i], ch[1][i], ch[2][i], ch[3][i]);
+  }
+  fclose(f);
+  double ms = elapsedMs(t);
+  /* Same text as the tsv writer with 6 digits */
+  return {ms, 0};
+}
+
+template <typename T>
+auto runWriter(const char *target, CaptureFormat format, int precision,
+               const T *const *ch, uint32_t n, CaptureSampleType type)
+    -> Result {
+  int fd = captureOpenOutput(target);
+  if (fd < 0) {
+    return {0, 0};
+  }
+  CaptureInfo info;
+  info.channels = CHANNELS;
+  info.samples = n;
+  info.sampleRate = 125e6;
+  int64_t t = nowNs();
+  uint64_t bytes = 0;
+  {
+    CaptureWriter writer(fd, format);
+    writer.setPrecision(precision);
+    writer.begin(info, type);
+    writer.write(ch, n);
+    writer.flush();
+    bytes = writer.bytes();
+  }
+  close(fd);
+  return {elapsedMs(t), bytes};
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-n samples] [-o output]\n"
+          "\t-n : Samples per channel (default 1048576)\n"
+          "\t-o : Output file or FIFO (default /dev/null)\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  uint32_t samples = 1 << 20;
+  const char *target = "/dev/null";
+  int opt;
+  while ((opt = getopt(argc, argv, "n:o:h")) != -1) {
+    switch (opt) {
+    case 'n':
+      samples = atoi(optarg);
+      break;
+    case 'o':
+      target = optarg;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<float> volts[CHANNELS];
+  std::vector<int16_t> codes[CHANNELS];
+  const float *vp[CHANNELS];
+  const int16_t *cp[CHANNELS];
+  for (int c = 0; c < CHANNELS; c++) {
+    volts[c].resize(samples);
+    codes[c].resize(samples);
+    for (uint32_t i = 0; i < samples; i++) {
+      float v = 0.9f * sinf(2 * (float)M_PI * (i + 100 * c) / 1000.0f);
+      volts[c][i] = v;
+      codes[c][i] = (int16_t)lrintf(v * 8191);
+    }
+    vp[c] = volts[c].data();
+    cp[c] = codes[c].data();
+  }
+
+  printf("%u samples x %d channels to %s\n", samples, CHANNELS, target);
+  Result printfResult = runPrintf(target, vp, samples);
+  Result tsv6 = runWriter(target, CaptureFormat::TSV, 6, vp, samples,
+                          CaptureSampleType::FLOAT32);
+  /* The printf loop writes the same number of bytes */
+  printfResult.bytes = tsv6.bytes;
+  report("printf %f", samples, printfResult);
+  report("tsv float, 6 digits", samples, tsv6);
+  report("csv float, shortest", samples,
+         runWriter(target, CaptureFormat::CSV, -1, vp, samples,
+                   CaptureSampleType::FLOAT32));
+  report("csv int16", samples,
+         runWriter(target, CaptureFormat::CSV, -1, cp, samples,
+                   CaptureSampleType::INT16));
+  report("raw float", samples,
+         runWriter(target, CaptureFormat::RAW, -1, vp, samples,
+                   CaptureSampleType::FLOAT32));
+  report("rpcap int16", samples,
+         runWriter(target, CaptureFormat::RPCAP, -1, cp, samples,
+                   CaptureSampleType::INT16));
+  return 0;
+}
@@ -1,20 +1,60 @@
 /* Red Pitaya C++ API example Acquiring a signal from a buffer
- * This application acquires a signal on a specific channel */
+ * This application acquires a signal on a specific channel.
+ * Usage: axi [-f format] [-o output] [samples decimation]
+ * The capture is written to stdout as text by default; -f selects csv, tsv,
+ * ssv, raw or rpcap and -o a file, a FIFO or tcp:host:port. */
 
+#include "common/capture_writer.h"
 #include "rp.h"
+#include "rp_hw-profiles.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #define DATA_SIZE 64
 
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-f format] [-o output]%s\n"
+          "\t-f : csv, tsv, ssv, raw or rpcap (default tsv)\n"
+          "\t-o : File, FIFO, tcp:host:port or - for stdout (default -)\n",
+          prog, " [samples decimation]");
+}
+
 int main(int argc, char **argv) {
+  CaptureFormat format = CaptureFormat::TSV;
+  const char *target = "-";
+  int opt;
+  while ((opt = getopt(argc, argv, "f:o:")) != -1) {
+    switch (opt) {
+    case 'f':
+      if (!captureParseFormat(optarg, &format)) {
+        printHelp(argv[0]);
+        return 1;
+      }
+      break;
+    case 'o':
+      target = optarg;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
   int dsize = DATA_SIZE;
   uint32_t dec = 1;
-  if (argc >= 3) {
-    dsize = atoi(argv[1]);
-    dec = atoi(argv[2]);
+  if (argc - optind >= 2) {
+    dsize = atoi(argv[optind]);
+    dec = atoi(argv[optind + 1]);
+  }
+  int fd = captureOpenOutput(target);
+  if (fd < 0) {
+    fprintf(stderr, "Can't open %s\n", target);
+    return 1;
   }
+
   /* Print error, if rp_Init() function failed */
   if (rp_InitReset(false) != RP_OK) {
     fprintf(stderr, "Rp api init failed!\n");
@@ -33,8 +73,8 @@ int main(int argc, char **argv) {
   uint32_t g_adc_axi_start, g_adc_axi_size;
   rp_AcqAxiGetMemoryRegion(&g_adc_axi_start, &g_adc_axi_size);
 
-  printf("Reserved memory start 0x%X size 0x%X\n", g_adc_axi_start,
-         g_adc_axi_size);
+  fprintf(stderr, "Reserved memory start 0x%X size 0x%X\n", g_adc_axi_start,
+          g_adc_axi_size);
   //    rp_AcqResetFpga();
 
   if (rp_AcqAxiSetDecimationFactor(dec) != RP_OK) {
@@ -108,8 +148,30 @@ int main(int argc, char **argv) {
   rp_AcqAxiGetDataRaw(RP_CH_1, posChA, &size1, buff1);
   rp_AcqAxiGetDataRaw(RP_CH_2, posChB, &size2, buff2);
 
-  for (int i = 0; i < dsize; i++) {
-    printf("[%d]\t%d\t%d\n", i, buff1[i], buff2[i]);
+  /* One buffered write instead of a printf per sample, text rows start
+   * with the sample index. Raw codes are calibrated in the FPGA, the gain
+   * assumes the +-1 V range. */
+  uint8_t bits = 14;
+  rp_HPGetFastADCBits(&bits);
+  CaptureInfo info;
+  info.channels = 2;
+  info.samples = dsize;
+  info.decimation = dec;
+  info.triggerPos = posChA;
+  info.sampleRate = rp_HPGetBaseFastADCSpeedHzOrDefault() / (double)dec;
+  info.gain[0] = info.gain[1] = 1.0f / (1 << (bits - 1));
+  const int16_t *channels[2] = {buff1, buff2};
+  CaptureWriter writer(fd, format);
+  writer.setIndex(true);
+  writer.begin(info, CaptureSampleType::INT16);
+  writer.write(channels, dsize);
+  /* A reader that stopped early, such as head, is not an error */
+  if (!writer.flush() && writer.error() != EPIPE) {
+    fprintf(stderr, "Writing %s failed: %s\n", target,
+            strerror(writer.error()));
+  }
+  if (fd != STDOUT_FILENO) {
+    close(fd);
   }
 
   /* Releasing resources */
@@ -1,14 +1,53 @@
 /* Red Pitaya C++ API example Acquiring a signal from a buffer
- * This application acquires a signal on a specific channel */
+ * This application acquires a signal on a specific channel.
+ * The capture is written to stdout as text by default; -f selects csv, tsv,
+ * ssv, raw or rpcap and -o a file, a FIFO or tcp:host:port. */
 
+#include "common/capture_writer.h"
 #include "rp.h"
+#include "rp_hw-profiles.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #define DATA_SIZE 1024
 
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-f format] [-o output]\n"
+          "\t-f : csv, tsv, ssv, raw or rpcap (default tsv)\n"
+          "\t-o : File, FIFO, tcp:host:port or - for stdout (default -)\n",
+          prog);
+}
+
 int main(int argc, char **argv) {
+  CaptureFormat format = CaptureFormat::TSV;
+  const char *target = "-";
+  int opt;
+  while ((opt = getopt(argc, argv, "f:o:")) != -1) {
+    switch (opt) {
+    case 'f':
+      if (!captureParseFormat(optarg, &format)) {
+        printHelp(argv[0]);
+        return 1;
+      }
+      break;
+    case 'o':
+      target = optarg;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  int fd = captureOpenOutput(target);
+  if (fd < 0) {
+    fprintf(stderr, "Can't open %s\n", target);
+    return 1;
+  }
+
   /* Print error, if rp_Init() function failed */
   if (rp_InitReset(false) != RP_OK) {
     fprintf(stderr, "Rp api init failed!\n");
@@ -29,8 +68,8 @@ application "calib -u"
   uint32_t g_adc_axi_start, g_adc_axi_size;
   rp_AcqAxiGetMemoryRegion(&g_adc_axi_start, &g_adc_axi_size);
 
-  printf("Reserved memory start 0x%X size 0x%X\n", g_adc_axi_start,
-         g_adc_axi_size);
+  fprintf(stderr, "Reserved memory start 0x%X size 0x%X\n", g_adc_axi_start,
+          g_adc_axi_size);
   //    rp_AcqResetFpga();
 
   if (rp_AcqAxiSetDecimationFactor(RP_DEC_1) != RP_OK) {
@@ -148,8 +187,30 @@ application "calib -u"
   rp_AcqAxiGetDataRaw(RP_CH_3, posChC, &size3, buff3);
   rp_AcqAxiGetDataRaw(RP_CH_4, posChD, &size4, buff4);
 
-  for (int i = 0; i < DATA_SIZE; i++) {
-    printf("%d\t%d\t%d\t%d\n", buff1[i], buff2[i], buff3[i], buff4[i]);
+  /* One buffered write instead of a printf per sample. Raw codes are
+   * calibrated in the FPGA, the gain assumes the +-1 V range. */
+  uint8_t bits = 14;
+  rp_HPGetFastADCBits(&bits);
+  CaptureInfo info;
+  info.channels = 4;
+  info.samples = DATA_SIZE;
+  info.decimation = RP_DEC_1;
+  info.triggerPos = posChA;
+  info.sampleRate = rp_HPGetBaseFastADCSpeedHzOrDefault();
+  for (int i = 0; i < 4; i++) {
+    info.gain[i] = 1.0f / (1 << (bits - 1));
+  }
+  const int16_t *channels[4] = {buff1, buff2, buff3, buff4};
+  CaptureWriter writer(fd, format);
+  writer.begin(info, CaptureSampleType::INT16);
+  writer.write(channels, DATA_SIZE);
+  /* A reader that stopped early, such as head, is not an error */
+  if (!writer.flush() && writer.error() != EPIPE) {
+    fprintf(stderr, "Writing %s failed: %s\n", target,
+            strerror(writer.error()));
+  }
+  if (fd != STDOUT_FILENO) {
+    close(fd);
   }
 
   /* Releasing resources */
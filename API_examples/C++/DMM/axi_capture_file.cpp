@@ -0,0 +1,307 @@
+/* Red Pitaya C++ API example Recording AXI captures to a chunked file
+ * This application records an AXI capture of IN1 and IN2 (or a simulated
+ * stream with -s) into a chunked capture file, and reads such files back.
+ *
+ * Record: axi_capture_file -o file [-n samples] [-d decimation] [-k chunk]
+ *         [-z] [-s]
+ * Read:   axi_capture_file -r file [-t seconds] [-p samples]
+ *
+ * The reader maps the file, prints the per-chunk min/max summary from the
+ * index and, with -t, seeks to a time through the index and prints samples
+ * from there. */
+
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/capture_file.h"
+#include "common/timing.h"
+#include "rp.h"
+#include "rp_hw-profiles.h"
+
+#define CHANNELS 2
+#define READ_SIZE (64 * 1024)
+
+auto realtimeNs() -> int64_t {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+auto recordAxi(CaptureFileWriter *writer, uint32_t decimation,
+               uint32_t samples) -> bool {
+  const rp_channel_t ch[CHANNELS] = {RP_CH_1, RP_CH_2};
+  uint32_t start, size;
+  rp_AcqAxiGetMemoryRegion(&start, &size);
+  uint32_t region = size / CHANNELS;
+  if (samples * sizeof(int16_t) > region) {
+    samples = region / sizeof(int16_t);
+  }
+  if (rp_AcqAxiSetDecimationFactor(decimation) != RP_OK) {
+    fprintf(stderr, "rp_AcqAxiSetDecimationFactor failed!\n");
+    return false;
+  }
+  for (int i = 0; i < CHANNELS; i++) {
+    rp_AcqSetCalibInFPGA(ch[i]);
+    if (rp_AcqAxiSetTriggerDelay(ch[i], samples) != RP_OK ||
+        rp_AcqAxiSetBufferSamples(ch[i], start + region * i, samples) !=
+            RP_OK ||
+        rp_AcqAxiEnable(ch[i], true) != RP_OK) {
+      fprintf(stderr, "AXI setup of channel %d failed!\n", i + 1);
+      return false;
+    }
+  }
+  rp_AcqStart();
+  rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+  for (int i = 0; i < CHANNELS; i++) {
+    bool fillState = false;
+    while (!fillState) {
+      rp_AcqAxiGetBufferFillState(ch[i], &fillState);
+    }
+  }
+  rp_AcqStop();
+
+  uint32_t pos[CHANNELS];
+  for (int i = 0; i < CHANNELS; i++) {
+    rp_AcqAxiGetWritePointerAtTrig(ch[i], &pos[i]);
+  }
+  std::vector<int16_t> buff[CHANNELS];
+  const int16_t *ptr[CHANNELS];
+  for (int i = 0; i < CHANNELS; i++) {
+    buff[i].resize(READ_SIZE);
+    ptr[i] = buff[i].data();
+  }
+  bool ok = true;
+  for (uint32_t done = 0; ok && done < samples;) {
+    uint32_t n = samples - done < READ_SIZE ? samples - done : READ_SIZE;
+    for (int i = 0; ok && i < CHANNELS; i++) {
+      uint32_t size = n;
+      ok = rp_AcqAxiGetDataRaw(ch[i], pos[i], &size, buff[i].data()) ==
+           RP_OK;
+      pos[i] += n;
+    }
+    ok = ok && writer->write(ptr, n);
+    done += n;
+  }
+  for (int i = 0; i < CHANNELS; i++) {
+    rp_AcqAxiEnable(ch[i], false);
+  }
+  return ok;
+}
+
+/* Two noisy sines, with a one second gap in the middle of the stream */
+auto recordSim(CaptureFileWriter *writer, double sampleRate,
+               uint32_t samples, int64_t startNs) -> bool {
+  std::minstd_rand rng;
+  std::normal_distribution<float> noise(0, 8);
+  std::vector<int16_t> buff[CHANNELS];
+  const int16_t *ptr[CHANNELS];
+  for (int i = 0; i < CHANNELS; i++) {
+    buff[i].resize(READ_SIZE);
+    ptr[i] = buff[i].data();
+  }
+  uint32_t gapAt = samples / 2 / READ_SIZE * READ_SIZE;
+  for (uint32_t done = 0; done < samples;) {
+    uint32_t n = samples - done < READ_SIZE ? samples - done : READ_SIZE;
+    for (uint32_t k = 0; k < n; k++) {
+      double t = (done + k) / sampleRate;
+      buff[0][k] = (int16_t)(4000 * sin(2 * M_PI * 1e3 * t) + noise(rng));
+      buff[1][k] = (int16_t)(2000 * sin(2 * M_PI * 3e3 * t) + noise(rng));
+    }
+    int64_t timeNs = -1;
+    if (done == gapAt) {
+      timeNs = startNs + (int64_t)(done / sampleRate * 1e9) + 1000000000LL;
+    }
+    if (!writer->write(ptr, n, timeNs)) {
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+auto readFile(const char *path, double seekSeconds, uint32_t printSamples)
+    -> int {
+  CaptureFileReader reader;
+  int64_t t = nowNs();
+  if (!reader.open(path)) {
+    fprintf(stderr, "Can't read %s\n", path);
+    return 1;
+  }
+  double openMs = elapsedMs(t);
+  const CaptureFileHeader &h = reader.header();
+  printf("%s: %u channels, %s, %llu samples at %.1f Hz in %llu chunks%s\n",
+         path, h.channels,
+         h.sampleType == CaptureSampleType::INT16 ? "int16" : "float32",
+         (unsigned long long)reader.samples(), h.sampleRate,
+         (unsigned long long)reader.chunks(),
+         reader.complete() ? "" : " (index rebuilt)");
+  printf("Opened in %.3f ms\n", openMs);
+
+  /* Overview from the index only */
+  uint64_t step = reader.chunks() > 16 ? reader.chunks() / 16 : 1;
+  for (uint64_t i = 0; i < reader.chunks(); i += step) {
+    const CaptureChunkHeader &c = reader.chunk(i);
+    printf("\tchunk %6llu sample %10llu t %+.6f s", (unsigned long long)i,
+           (unsigned long long)c.firstSample,
+           (c.timeNs - h.startTimeNs) / 1e9);
+    for (int ch = 0; ch < h.channels; ch++) {
+      printf("  IN%d [%.3f, %.3f] V%s", ch + 1,
+             c.min[ch] * h.gain[ch] + h.offset[ch],
+             c.max[ch] * h.gain[ch] + h.offset[ch],
+             c.compressed & (1u << ch) ? "*" : "");
+    }
+    printf("\n");
+  }
+
+  if (seekSeconds >= 0) {
+    int64_t target = h.startTimeNs + (int64_t)(seekSeconds * 1e9);
+    t = nowNs();
+    uint64_t first = reader.sampleAtTime(target);
+    std::vector<float> volts[CAPTURE_MAX_CHANNELS];
+    uint32_t n = 0;
+    for (int ch = 0; ch < h.channels; ch++) {
+      volts[ch].resize(printSamples);
+      n = reader.readVolts(ch, first, printSamples, volts[ch].data());
+    }
+    double seekMs = elapsedMs(t);
+    printf("Sample %llu at %+.6f s, found and read in %.3f ms\n",
+           (unsigned long long)first, seekSeconds, seekMs);
+    for (uint32_t i = 0; i < n; i++) {
+      printf("%llu", (unsigned long long)(first + i));
+      for (int ch = 0; ch < h.channels; ch++) {
+        printf("\t%.5f", volts[ch][i]);
+      }
+      printf("\n");
+    }
+  }
+  return 0;
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s -o file [-n samples] [-d decimation] [-k chunk] [-z] "
+          "[-s]\n"
+          "       %s -r file [-t seconds] [-p samples]\n"
+          "\t-o : Record into a capture file\n"
+          "\t-n : Samples per channel (default 4M, limited by AXI memory)\n"
+          "\t-d : Decimation (default 1)\n"
+          "\t-k : Samples per chunk (default 65536)\n"
+          "\t-z : Compress the columns\n"
+          "\t-s : Record a simulated stream instead of AXI\n"
+          "\t-r : Read a capture file\n"
+          "\t-t : Seek to this time from the start and print samples\n"
+          "\t-p : Samples printed after the seek (default 8)\n",
+          prog, prog);
+}
+
+int main(int argc, char **argv) {
+  const char *output = NULL;
+  const char *input = NULL;
+  uint32_t samples = 4 * 1024 * 1024;
+  uint32_t decimation = 1;
+  uint32_t chunk = 64 * 1024;
+  bool compress = false;
+  bool sim = false;
+  double seek = -1;
+  uint32_t printSamples = 8;
+  int opt;
+  while ((opt = getopt(argc, argv, "o:n:d:k:zsr:t:p:h")) != -1) {
+    switch (opt) {
+    case 'o':
+      output = optarg;
+      break;
+    case 'n':
+      samples = atoi(optarg);
+      break;
+    case 'd':
+      decimation = atoi(optarg);
+      break;
+    case 'k':
+      chunk = atoi(optarg);
+      break;
+    case 'z':
+      compress = true;
+      break;
+    case 's':
+      sim = true;
+      break;
+    case 'r':
+      input = optarg;
+      break;
+    case 't':
+      seek = atof(optarg);
+      break;
+    case 'p':
+      printSamples = atoi(optarg);
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  if (input) {
+    return readFile(input, seek, printSamples);
+  }
+  if (!output) {
+    printHelp(argv[0]);
+    return 1;
+  }
+
+  CaptureFileInfo info;
+  info.channels = CHANNELS;
+  info.sampleType = CaptureSampleType::INT16;
+  info.chunkSamples = chunk;
+  info.decimation = decimation;
+  info.sampleRate = 125e6 / decimation;
+  info.startTimeNs = realtimeNs();
+  info.compress = compress;
+  /* Raw codes calibrated in the FPGA, +-1 V range */
+  uint8_t bits = 14;
+  if (!sim) {
+    if (rp_InitReset(false) != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return 1;
+    }
+    rp_HPGetFastADCBits(&bits);
+    info.sampleRate =
+        rp_HPGetBaseFastADCSpeedHzOrDefault() / (double)decimation;
+  }
+  for (int i = 0; i < CHANNELS; i++) {
+    info.gain[i] = 1.0f / (1 << (bits - 1));
+  }
+
+  CaptureFileWriter writer;
+  if (!writer.open(output, info)) {
+    fprintf(stderr, "Can't create %s\n", output);
+    if (!sim) {
+      rp_Release();
+    }
+    return 1;
+  }
+  int64_t t = nowNs();
+  bool ok = sim ? recordSim(&writer, info.sampleRate, samples,
+                            info.startTimeNs)
+                : recordAxi(&writer, decimation, samples);
+  ok = writer.close() && ok;
+  double ms = elapsedMs(t);
+  if (!sim) {
+    rp_Release();
+  }
+  if (!ok) {
+    fprintf(stderr, "Recording %s failed\n", output);
+    return 1;
+  }
+  uint64_t rawBytes = writer.samples() * CHANNELS * sizeof(int16_t);
+  printf("%llu samples x %d channels in %llu chunks, %llu bytes "
+         "(%.1f %% of raw) in %.1f ms\n",
+         (unsigned long long)writer.samples(), CHANNELS,
+         (unsigned long long)writer.chunks(),
+         (unsigned long long)writer.bytes(),
+         100.0 * writer.bytes() / (rawBytes ? rawBytes : 1), ms);
+  return 0;
+}
@@ -0,0 +1,350 @@
+/* Red Pitaya C++ API example Real-time ADC to DAC loopback
+ * This application feeds IN1 back to OUT1 through a processing stage
+ * (gain, second order low pass, delay) without leaving the board. The ADC
+ * captures continuously into one half of the AXI region and the generator
+ * loops over the other half; a SCHED_FIFO thread moves each block from
+ * one to the other. The output lags the input by a fixed number of blocks,
+ * so the block size sets the latency.
+ *
+ * Once a second the turnaround percentiles, the smallest margin before the
+ * DAC and the underrun and overrun counters are printed, and at the end
+ * the turnaround histogram. -s runs against a simulated ADC (a tone) and
+ * DAC driven by the system clock; -w adds busy work per block to see
+ * where underruns start.
+ *
+ * The loopback takes the DAC position from the ADC write pointer, so the
+ * generator backend is set up without its own ADC clock. */
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/loopback.h"
+#include "common/realtime.h"
+#include "common/synth.h"
+#include "common/timing.h"
+#include "rp.h"
+#include "rp_hw-profiles.h"
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void onSignal(int) { g_stop = 1; }
+
+/* Continuous capture of IN1: never triggered, the ADC keeps wrapping its
+ * ring and the write pointer tells how far it got */
+class RpAdcStreamBackend : public AdcStreamBackend {
+public:
+  auto init(uint32_t decimation, uint32_t start, uint32_t samples) -> bool {
+    m_ring = samples;
+    m_rate = rp_HPGetBaseFastADCSpeedHzOrDefault() / (double)decimation;
+    rp_AcqSetCalibInFPGA(RP_CH_1);
+    if (rp_AcqAxiSetDecimationFactor(decimation) != RP_OK ||
+        rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED) != RP_OK ||
+        rp_AcqAxiSetBufferSamples(RP_CH_1, start, samples) != RP_OK ||
+        rp_AcqAxiEnable(RP_CH_1, true) != RP_OK) {
+      fprintf(stderr, "AXI capture setup failed!\n");
+      return false;
+    }
+    return true;
+  }
+
+  auto adcRate() -> double override { return m_rate; }
+  auto ringSamples() -> uint32_t override { return m_ring; }
+
+  auto start() -> bool override {
+    m_captured = 0;
+    m_last = 0;
+    return rp_AcqStart() == RP_OK;
+  }
+
+  auto stop() -> void override {
+    rp_AcqStop();
+    rp_AcqAxiEnable(RP_CH_1, false);
+  }
+
+  /* Unwraps the write pointer, called at least once per block so it can't
+   * lap unseen */
+  auto captured() -> uint64_t override {
+    uint32_t pos;
+    if (rp_AcqAxiGetWritePointer(RP_CH_1, &pos) == RP_OK) {
+      m_captured += (pos + m_ring - m_last) % m_ring;
+      m_last = pos;
+    }
+    return m_captured;
+  }
+
+  auto read(uint64_t position, float *data, uint32_t n) -> bool override {
+    uint32_t size = n;
+    return rp_AcqAxiGetDataV(RP_CH_1, position % m_ring, &size, data) ==
+               RP_OK &&
+           size == n;
+  }
+
+private:
+  uint32_t m_ring = 0;
+  double m_rate = 0;
+  uint64_t m_captured = 0;
+  uint32_t m_last = 0;
+};
+
+/* A tone at every position, captured at the rate of the system clock */
+class SimAdcStreamBackend : public AdcStreamBackend {
+public:
+  SimAdcStreamBackend(double rate, uint32_t ringSamples, double freq)
+      : m_rate(rate), m_ring(ringSamples), m_step(synthStep(freq, rate)) {}
+
+  auto adcRate() -> double override { return m_rate; }
+  auto ringSamples() -> uint32_t override { return m_ring; }
+
+  auto start() -> bool override {
+    m_startNs = nowNs();
+    return true;
+  }
+
+  auto stop() -> void override {}
+
+  auto captured() -> uint64_t override {
+    return (uint64_t)((nowNs() - m_startNs) * 1e-9 * m_rate);
+  }
+
+  auto read(uint64_t position, float *data, uint32_t n) -> bool override {
+    SynthOsc osc{(uint32_t)(position * m_step), m_step};
+    Wavetable::sine().render(data, n, &osc, 0.5f);
+    return true;
+  }
+
+private:
+  double m_rate;
+  uint32_t m_ring;
+  uint32_t m_step;
+  int64_t m_startNs = 0;
+};
+
+/* gain * lowpass(x) delayed by delay samples. The low pass is an RBJ
+ * biquad, skipped when cutoff is 0. workUs of busy waiting per block
+ * stands in for heavier processing. */
+class GainFilterDelay : public LoopbackStage {
+public:
+  GainFilterDelay(double rate, float gain, double cutoff, uint32_t delay,
+                  double workUs)
+      : m_gain(gain), m_line(delay + 1), m_workNs(workUs * 1e3) {
+    if (cutoff > 0 && cutoff < rate / 2) {
+      double w = 2 * M_PI * cutoff / rate;
+      double alpha = sin(w) / (2 * M_SQRT1_2);
+      double a0 = 1 + alpha;
+      m_b0 = (1 - cos(w)) / 2 / a0;
+      m_b1 = (1 - cos(w)) / a0;
+      m_b2 = m_b0;
+      m_a1 = -2 * cos(w) / a0;
+      m_a2 = (1 - alpha) / a0;
+      m_filter = true;
+    }
+  }
+
+  auto process(const float *in, float *out, uint32_t n) -> void override {
+    uint32_t size = m_line.size();
+    for (uint32_t i = 0; i < n; i++) {
+      float x = in[i];
+      if (m_filter) {
+        float y = m_b0 * x + m_z1;
+        m_z1 = m_b1 * x - m_a1 * y + m_z2;
+        m_z2 = m_b2 * x - m_a2 * y;
+        x = y;
+      }
+      m_line[m_head] = x * m_gain;
+      m_head = m_head + 1 == size ? 0 : m_head + 1;
+      /* The oldest entry is delay samples back */
+      out[i] = m_line[m_head];
+    }
+    if (m_workNs) {
+      int64_t end = nowNs() + m_workNs;
+      while (nowNs() < end) {
+      }
+    }
+  }
+
+private:
+  float m_gain;
+  bool m_filter = false;
+  float m_b0 = 1, m_b1 = 0, m_b2 = 0, m_a1 = 0, m_a2 = 0;
+  float m_z1 = 0, m_z2 = 0;
+  std::vector<float> m_line;
+  uint32_t m_head = 0;
+  int64_t m_workNs;
+};
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-d decimation] [-b block] [-k blocks] [-g gain] "
+          "[-f cutoff] [-D delay] [-t seconds] [-P priority] [-c cpu] "
+          "[-w us] [-s]\n"
+          "\t-d : ADC and DAC decimation (default 64)\n"
+          "\t-b : Block size in samples (default 1024)\n"
+          "\t-k : Output lags input by this many blocks, at least 2 "
+          "(default 2)\n"
+          "\t-g : Gain (default 1)\n"
+          "\t-f : Low pass cutoff in Hz, 0 for none (default 0)\n"
+          "\t-D : Extra delay in samples (default 0)\n"
+          "\t-t : Seconds to run, 0 until Ctrl-C (default 10)\n"
+          "\t-P : SCHED_FIFO priority, 0 for none (default 80)\n"
+          "\t-c : CPU of the loopback thread (default any)\n"
+          "\t-w : Busy work per block in us (default 0)\n"
+          "\t-s : Simulated ADC and DAC\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  uint32_t decimation = 64;
+  LoopbackSettings settings;
+  float gain = 1;
+  double cutoff = 0;
+  uint32_t delay = 0;
+  double seconds = 10;
+  double workUs = 0;
+  bool sim = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:b:k:g:f:D:t:P:c:w:sh")) != -1) {
+    switch (opt) {
+    case 'd':
+      decimation = atoi(optarg);
+      break;
+    case 'b':
+      settings.blockSamples = atoi(optarg);
+      break;
+    case 'k':
+      settings.delayBlocks = atoi(optarg);
+      break;
+    case 'g':
+      gain = atof(optarg);
+      break;
+    case 'f':
+      cutoff = atof(optarg);
+      break;
+    case 'D':
+      delay = atoi(optarg);
+      break;
+    case 't':
+      seconds = atof(optarg);
+      break;
+    case 'P':
+      settings.priority = atoi(optarg);
+      break;
+    case 'c':
+      settings.cpu = atoi(optarg);
+      break;
+    case 'w':
+      workUs = atof(optarg);
+      break;
+    case 's':
+      sim = true;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  if (decimation < 1 || settings.blockSamples < 1 ||
+      settings.delayBlocks < 2) {
+    printHelp(argv[0]);
+    return 1;
+  }
+  settings.histogramBinUs = 10;
+
+  /* Rings of whole blocks with room for the delay and two more blocks */
+  uint32_t block = settings.blockSamples;
+  uint32_t ring = (settings.delayBlocks + 4) * block;
+
+  RpAdcStreamBackend rpAdc;
+  RpDacStreamBackend rpDac;
+  SimAdcStreamBackend *simAdc = NULL;
+  SimDacStreamBackend *simDac = NULL;
+  AdcStreamBackend *adc = &rpAdc;
+  DacStreamBackend *dac = &rpDac;
+  if (sim) {
+    simAdc = new SimAdcStreamBackend(
+        rp_HPGetBaseFastADCSpeedHzOrDefault() / (double)decimation, ring, 1000);
+    simDac = new SimDacStreamBackend(
+        rp_HPGetBaseSpeedHzOrDefault() / (double)decimation, ring);
+    adc = simAdc;
+    dac = simDac;
+  } else {
+    if (rp_Init() != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return 1;
+    }
+    uint32_t start, size;
+    rp_AcqAxiGetMemoryRegion(&start, &size);
+    uint32_t half = size / 2;
+    if (ring * sizeof(int16_t) > half) {
+      fprintf(stderr, "Rings of %u samples don't fit the AXI region\n", ring);
+      rp_Release();
+      return 1;
+    }
+    if (!rpAdc.init(decimation, start, ring) ||
+        !rpDac.init(decimation, start + half, ring, false)) {
+      rp_Release();
+      return 1;
+    }
+  }
+
+  lockMemory();
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  GainFilterDelay stage(adc->adcRate(), gain, cutoff, delay, workUs);
+  int ret = 0;
+  {
+    Loopback loop(adc, dac, &stage, settings);
+    if (!loop.start()) {
+      fprintf(stderr, "Can't start the loopback\n");
+      ret = 1;
+    }
+    LoopbackStats s = loop.stats();
+    printf("%.3f MS/s, blocks of %u samples (%.1f us), latency %.3f ms\n",
+           adc->adcRate() / 1e6, block, block / adc->adcRate() * 1e6,
+           s.latencyMs);
+    int64_t t = nowNs();
+    while (ret == 0 && !g_stop && loop.isRunning() &&
+           (seconds <= 0 || elapsedMs(t) < seconds * 1e3)) {
+      usleep(1000000);
+      s = loop.stats();
+      const LatencyHistogram &h = s.turnaround;
+      printf("%5.1f s: %llu blocks, turnaround p50 %.0f p99 %.0f max %.0f "
+             "us, min margin %.0f us, underruns %llu, overruns %llu\n",
+             elapsedMs(t) / 1e3, (unsigned long long)s.blocks,
+             h.percentile(50), h.percentile(99), h.max(), s.minMarginUs,
+             (unsigned long long)s.underruns, (unsigned long long)s.overruns);
+    }
+    if (loop.failed()) {
+      fprintf(stderr, "ADC read or DAC write failed\n");
+      ret = 1;
+    }
+    loop.stop();
+    s = loop.stats();
+    if (settings.priority > 0 && !s.realtime) {
+      fprintf(stderr, "No SCHED_FIFO for the loopback thread\n");
+    }
+    printf("Latency %.3f ms, %llu blocks, %llu underruns, %llu overruns, "
+           "%llu samples skipped\nTurnaround, block at the ADC to written "
+           "to the DAC ring (mean %.1f us):\n",
+           s.latencyMs, (unsigned long long)s.blocks,
+           (unsigned long long)s.underruns, (unsigned long long)s.overruns,
+           (unsigned long long)s.skippedSamples, s.turnaround.mean());
+    s.turnaround.print(stdout);
+  }
+
+  if (sim) {
+    printf("Simulated DAC played %llu stale samples\n",
+           (unsigned long long)simDac->stale());
+    delete simAdc;
+    delete simDac;
+  } else {
+    rpDac.release();
+    rp_Release();
+  }
+  return ret;
+}
@@ -1,12 +1,12 @@
 /* Red Pitaya C++ API example Generating continuous signal via DMA
  * This application generates a specific signal */
 
-#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "common/synth.h"
 #include "rp.h"
 #include "rp_asg_axi.h"
 
@@ -46,16 +46,12 @@ int main(int argc, char **argv) {
 
   bufferSize /= 2;
 
-  float *t = (float *)malloc(bufferSize * sizeof(float));
   float *x = (float *)malloc(bufferSize * sizeof(float));
 
-  for (uint32_t i = 1; i < bufferSize; i++) {
-    t[i] = (2 * M_PI) / bufferSize * i;
-  }
-
-  for (uint32_t i = 0; i < bufferSize; ++i) {
-    x[i] = sin(t[i]) + ((1.0 / 3.0) * sin(t[i] * 3));
-  }
+  /* One period of sin(t) + 1/3 sin(3t) over the whole buffer */
+  SynthOsc osc;
+  osc.step = synthCyclesStep(1, bufferSize);
+  Wavetable::harmonics({1.0f, 0.0f, 1.0f / 3}).render(x, bufferSize, &osc, 1);
 
   rp_GenSetAmplitudeAndOffsetOrigin(RP_CH_1);
   rp_GenMode(RP_CH_1, RP_GEN_MODE_BURST);
@@ -66,7 +62,6 @@ int main(int argc, char **argv) {
   rp_GenOutEnable(RP_CH_1);
   rp_GenTriggerOnly(RP_CH_1);
 
-  free(t);
   free(x);
 
   rp_Release();
@@ -0,0 +1,336 @@
+/* Red Pitaya C++ API example Timeline burst sequencer
+ * This application fires generator bursts on OUT1 and OUT2 at planned
+ * times. The burst configuration of each event is written ahead of time by
+ * a staging thread, and a high priority thread sleeps to each absolute
+ * deadline and only calls the trigger, instead of sleep() between
+ * configuring and triggering as in generate_two_burst_trigger_software.
+ * The achieved minus planned trigger times are printed as a histogram.
+ *
+ * The timeline is read from a file (-t) with one event per line:
+ *   time_s channel waveform frequency amplitude count repetitions period_us
+ * with an optional trailing "config" for events that only configure.
+ * Waveforms are sine, square, triangle, rampup, rampdown or dc. Without a
+ * file a built-in pattern is repeated. -n runs the same timeline the old
+ * way (sleep, configure, trigger) for comparison, -s uses a simulated
+ * generator whose configuration takes a few milliseconds. */
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "common/burst_sequencer.h"
+#include "common/realtime.h"
+#include "common/timing.h"
+#include "rp.h"
+
+class RpBurstBackend : public BurstBackend {
+public:
+  auto init() -> bool {
+    if (rp_Init() != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return false;
+    }
+    m_init = true;
+    return rp_GenReset() == RP_OK;
+  }
+
+  ~RpBurstBackend() {
+    if (m_init) {
+      rp_GenOutDisable(RP_CH_1);
+      rp_GenOutDisable(RP_CH_2);
+      rp_Release();
+    }
+  }
+
+  auto stage(uint8_t channel, const BurstParams &p) -> bool override {
+    rp_channel_t ch = (rp_channel_t)channel;
+    int ret = rp_GenMode(ch, RP_GEN_MODE_BURST);
+    ret |= rp_GenWaveform(ch, (rp_waveform_t)p.waveform);
+    ret |= rp_GenFreq(ch, p.frequency);
+    ret |= rp_GenAmp(ch, p.amplitude);
+    ret |= rp_GenOffset(ch, p.offset);
+    ret |= rp_GenBurstCount(ch, p.count);
+    ret |= rp_GenBurstRepetitions(ch, p.repetitions);
+    /* Always written, or a period staged earlier on this channel would
+     * stay in effect. 0 repeats the bursts back to back. */
+    uint32_t period = p.period;
+    if (period == 0) {
+      double burstUs = p.frequency > 0 ? p.count / p.frequency * 1e6 : 1;
+      period = burstUs > 1 ? (uint32_t)ceil(burstUs) : 1;
+    }
+    ret |= rp_GenBurstPeriod(ch, period);
+    if (!m_enabled[channel]) {
+      ret |= rp_GenOutEnable(ch);
+      m_enabled[channel] = ret == RP_OK;
+    }
+    return ret == RP_OK;
+  }
+
+  auto trigger(uint32_t mask) -> bool override {
+    if (mask == 3) {
+      return rp_GenTriggerOnlyBoth() == RP_OK;
+    }
+    return rp_GenTriggerOnly(mask == 1 ? RP_CH_1 : RP_CH_2) == RP_OK;
+  }
+
+private:
+  bool m_init = false;
+  bool m_enabled[BURST_SEQUENCER_CHANNELS] = {};
+};
+
+/* Configuration costs stageMs, triggers are immediate */
+class SimBurstBackend : public BurstBackend {
+public:
+  explicit SimBurstBackend(double stageMs) : m_stageNs(stageMs * 1e6) {}
+
+  auto stage(uint8_t, const BurstParams &) -> bool override {
+    int64_t end = nowNs() + m_stageNs;
+    while (nowNs() < end) {
+    }
+    return true;
+  }
+
+  auto trigger(uint32_t) -> bool override { return true; }
+
+private:
+  int64_t m_stageNs;
+};
+
+auto parseWaveform(const char *name, int *waveform) -> bool {
+  const struct {
+    const char *name;
+    rp_waveform_t waveform;
+  } names[] = {{"sine", RP_WAVEFORM_SINE},
+               {"square", RP_WAVEFORM_SQUARE},
+               {"triangle", RP_WAVEFORM_TRIANGLE},
+               {"rampup", RP_WAVEFORM_RAMP_UP},
+               {"rampdown", RP_WAVEFORM_RAMP_DOWN},
+               {"dc", RP_WAVEFORM_DC}};
+  for (const auto &n : names) {
+    if (strcmp(name, n.name) == 0) {
+      *waveform = n.waveform;
+      return true;
+    }
+  }
+  return false;
+}
+
+auto readTimeline(const char *path, std::vector<BurstEvent> *events)
+    -> bool {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Can't open %s\n", path);
+    return false;
+  }
+  char line[256];
+  int number = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f)) {
+    number++;
+    char *hash = strchr(line, '#');
+    if (hash) {
+      *hash = 0;
+    }
+    BurstEvent e;
+    unsigned channel;
+    char waveform[32];
+    char flag[32] = "";
+    int fields = sscanf(line, "%lf %u %31s %f %f %u %u %u %31s", &e.time,
+                        &channel, waveform, &e.params.frequency,
+                        &e.params.amplitude, &e.params.count,
+                        &e.params.repetitions, &e.params.period, flag);
+    if (fields <= 0) {
+      continue;
+    }
+    ok = fields >= 8 && channel >= 1 &&
+         channel <= BURST_SEQUENCER_CHANNELS && e.time >= 0 &&
+         parseWaveform(waveform, &e.params.waveform) &&
+         (fields == 8 || strcmp(flag, "config") == 0);
+    if (!ok) {
+      fprintf(stderr, "%s:%d: bad event\n", path, number);
+      break;
+    }
+    e.channel = channel - 1;
+    e.trigger = fields == 8;
+    events->push_back(e);
+  }
+  fclose(f);
+  return ok;
+}
+
+/* OUT1 every period with its frequency alternating, so every event is
+ * staged, OUT2 half a period later, both together every fifth period */
+auto builtinTimeline(uint32_t repeats, double periodMs)
+    -> std::vector<BurstEvent> {
+  std::vector<BurstEvent> events;
+  double period = periodMs * 1e-3;
+  for (uint32_t k = 0; k < repeats; k++) {
+    BurstEvent e;
+    e.time = k * period;
+    e.channel = 0;
+    e.params.waveform = RP_WAVEFORM_SINE;
+    e.params.frequency = k % 2 ? 2000 : 1000;
+    e.params.count = 2;
+    events.push_back(e);
+
+    e.time = k * period + (k % 5 == 4 ? 0 : period / 2);
+    e.channel = 1;
+    e.params.waveform = RP_WAVEFORM_SQUARE;
+    e.params.frequency = 4000;
+    e.params.count = 3;
+    events.push_back(e);
+  }
+  return events;
+}
+
+/* Sleep for the gap to the next event, configure, trigger */
+auto runNaive(BurstBackend *backend, std::vector<BurstEvent> events,
+              LatencyHistogram *error) -> bool {
+  std::stable_sort(events.begin(), events.end(),
+                   [](const BurstEvent &a, const BurstEvent &b) {
+                     return a.time < b.time;
+                   });
+  bool ok = true;
+  double last = 0;
+  int64_t start = nowNs();
+  for (const BurstEvent &e : events) {
+    usleep((useconds_t)((e.time - last) * 1e6));
+    last = e.time;
+    ok &= backend->stage(e.channel, e.params);
+    if (!e.trigger) {
+      continue;
+    }
+    error->add((nowNs() - start) / 1e3 - e.time * 1e6);
+    ok &= backend->trigger(1u << e.channel);
+  }
+  return ok;
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-t timeline] [-r repeats] [-p period] [-a ahead] "
+          "[-w spin] [-P priority] [-c cpu] [-b bin] [-n] [-s]\n"
+          "\t-t : Timeline file (default built-in pattern)\n"
+          "\t-r : Repeats of the built-in pattern (default 50)\n"
+          "\t-p : Period of the built-in pattern in ms (default 20)\n"
+          "\t-a : Stage configurations this many ms ahead (default 100)\n"
+          "\t-w : Busy wait this many us before each deadline (default "
+          "200)\n"
+          "\t-P : SCHED_FIFO priority of the trigger thread, 0 for none "
+          "(default 80)\n"
+          "\t-c : CPU of the trigger thread (default any)\n"
+          "\t-b : Histogram bin in us (default 10)\n"
+          "\t-n : Sleep, configure and trigger in one thread instead\n"
+          "\t-s : Simulated generator\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  const char *timeline = NULL;
+  uint32_t repeats = 50;
+  double periodMs = 20;
+  BurstSequencerSettings settings;
+  bool naive = false;
+  bool sim = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:r:p:a:w:P:c:b:nsh")) != -1) {
+    switch (opt) {
+    case 't':
+      timeline = optarg;
+      break;
+    case 'r':
+      repeats = atoi(optarg);
+      break;
+    case 'p':
+      periodMs = atof(optarg);
+      break;
+    case 'a':
+      settings.stageAheadMs = atof(optarg);
+      break;
+    case 'w':
+      settings.spinUs = atof(optarg);
+      break;
+    case 'P':
+      settings.priority = atoi(optarg);
+      break;
+    case 'c':
+      settings.cpu = atoi(optarg);
+      break;
+    case 'b':
+      settings.histogramBinUs = atof(optarg);
+      break;
+    case 'n':
+      naive = true;
+      break;
+    case 's':
+      sim = true;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  if (periodMs <= 0 || settings.histogramBinUs <= 0) {
+    printHelp(argv[0]);
+    return 1;
+  }
+
+  std::vector<BurstEvent> events;
+  if (timeline) {
+    if (!readTimeline(timeline, &events)) {
+      return 1;
+    }
+  } else {
+    events = builtinTimeline(repeats, periodMs);
+  }
+
+  RpBurstBackend rpBackend;
+  SimBurstBackend simBackend(3);
+  BurstBackend *backend = &simBackend;
+  if (!sim) {
+    if (!rpBackend.init()) {
+      return 1;
+    }
+    backend = &rpBackend;
+  }
+  lockMemory();
+
+  BurstTimingStats s;
+  bool ok;
+  if (naive) {
+    s.error = LatencyHistogram(settings.histogramBinUs,
+                               settings.histogramBins);
+    ok = runNaive(backend, events, &s.error);
+    s.triggers = s.error.count();
+  } else {
+    BurstSequencer sequencer(backend, settings);
+    ok = sequencer.run(events);
+    s = sequencer.stats();
+    if (settings.priority > 0 && !s.realtime) {
+      fprintf(stderr, "No SCHED_FIFO for the trigger thread\n");
+    }
+  }
+  if (!ok) {
+    fprintf(stderr, "Generator calls failed\n");
+  }
+
+  const LatencyHistogram &e = s.error;
+  printf("%zu events, %llu triggers\n", events.size(),
+         (unsigned long long)s.triggers);
+  printf("Trigger error: min %.1f us, mean %.1f us, max %.1f us, "
+         "p50 <= %.1f us, p99 <= %.1f us\n",
+         e.min(), e.mean(), e.max(), e.percentile(50), e.percentile(99));
+  if (!naive) {
+    printf("Staged %llu, skipped %llu unchanged, %llu late, longest %.2f ms; "
+           "longest trigger call %.1f us\n",
+           (unsigned long long)s.stages, (unsigned long long)s.stagesSkipped,
+           (unsigned long long)s.lateStages, s.maxStageMs, s.maxTriggerUs);
+  }
+  e.print(stdout);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+/* Red Pitaya C++ API example DAC quantize benchmark
+ * This application converts a synthesized tone to 14 bit DAC codes with a
+ * per-sample lrintf() loop and with the DacQuantizer in every dither mode,
+ * and copies an already quantized buffer as a writer taking codes would.
+ * It reports throughput, clipped samples and the quantization error, in
+ * total and after a 16 sample boxcar low pass, which shows how much noise
+ * the shaped dither moves out of the low band. No hardware is needed. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/dac_quantize.h"
+#include "common/synth.h"
+#include "common/timing.h"
+
+#define BOXCAR 16
+
+struct Error {
+  double rms;
+  double lowBand;
+};
+
+/* Error against the exact scaled input, in LSB */
+auto measure(const float *in, const int16_t *codes, uint32_t n,
+             const DacFormat &format) -> Error {
+  double full = (double)(1 << (format.bits - 1));
+  double lo = -full;
+  double hi = full - 1;
+  double sum = 0;
+  double lowSum = 0;
+  double box = 0;
+  uint32_t boxes = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    double x = ((double)in[i] * format.gain + format.offset) * full;
+    x = x < lo ? lo : (x > hi ? hi : x);
+    double e = codes[i] - x;
+    sum += e * e;
+    box += e;
+    if ((i + 1) % BOXCAR == 0) {
+      box /= BOXCAR;
+      lowSum += box * box;
+      box = 0;
+      boxes++;
+    }
+  }
+  return {sqrt(sum / n), boxes ? sqrt(lowSum / boxes) : 0};
+}
+
+auto report(const char *name, uint32_t n, double ms,
+            const DacQuantizeStats *stats, const Error *error) -> void {
+  printf("%-14s %8.2f ms %8.1f Msamples/s", name, ms, n / ms / 1000.0);
+  if (stats) {
+    printf("  clipped %llu/%llu",
+           (unsigned long long)stats->clippedLow,
+           (unsigned long long)stats->clippedHigh);
+  }
+  if (error) {
+    printf("  error %.3f LSB rms, %.3f LSB low band", error->rms,
+           error->lowBand);
+  }
+  printf("\n");
+}
+
+/* The conversion the examples would write by hand */
+auto quantizeScalar(const float *in, int16_t *out, uint32_t n,
+                    const DacFormat &format) -> void {
+  float full = (float)(1 << (format.bits - 1));
+  for (uint32_t i = 0; i < n; i++) {
+    float v = (in[i] * format.gain + format.offset) * full;
+    long c = lrintf(v);
+    if (c > full - 1) {
+      c = full - 1;
+    } else if (c < -full) {
+      c = -full;
+    }
+    out[i] = (int16_t)c;
+  }
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-n samples] [-a amplitude] [-g gain] [-o offset] "
+          "[-r repeats]\n"
+          "\t-n : Samples (default 16777216)\n"
+          "\t-a : Tone amplitude, above 1 clips (default 0.99)\n"
+          "\t-g : Calibration gain (default 1)\n"
+          "\t-o : Calibration offset in full scale units (default 0)\n"
+          "\t-r : Runs per method, the fastest is reported (default 3)\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  uint32_t samples = 1 << 24;
+  float amplitude = 0.99f;
+  DacFormat format;
+  int repeats = 3;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:a:g:o:r:h")) != -1) {
+    switch (opt) {
+    case 'n':
+      samples = atoi(optarg);
+      break;
+    case 'a':
+      amplitude = atof(optarg);
+      break;
+    case 'g':
+      format.gain = atof(optarg);
+      break;
+    case 'o':
+      format.offset = atof(optarg);
+      break;
+    case 'r':
+      repeats = atoi(optarg);
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  if (samples == 0 || repeats < 1) {
+    printHelp(argv[0]);
+    return 1;
+  }
+
+  /* A tone that does not divide the buffer, so the error is not periodic */
+  std::vector<float> in(samples);
+  SynthOsc osc{0, synthStep(1234.567, 125e6)};
+  Wavetable::sine().render(in.data(), samples, &osc, amplitude);
+  std::vector<int16_t> codes(samples);
+  std::vector<int16_t> copy(samples);
+
+  printf("%u samples, %u bit, gain %g, offset %g\n", samples, format.bits,
+         format.gain, format.offset);
+
+  double best = 1e30;
+  for (int r = 0; r < repeats; r++) {
+    int64_t t = nowNs();
+    quantizeScalar(in.data(), codes.data(), samples, format);
+    best = fmin(best, elapsedMs(t));
+  }
+  Error error = measure(in.data(), codes.data(), samples, format);
+  report("scalar lrintf", samples, best, nullptr, &error);
+
+  const struct {
+    const char *name;
+    DacDither dither;
+  } modes[] = {{"none", DacDither::NONE},
+               {"tpdf", DacDither::TPDF},
+               {"shaped", DacDither::SHAPED}};
+  for (const auto &m : modes) {
+    DacQuantizer q(format, m.dither);
+    best = 1e30;
+    for (int r = 0; r < repeats; r++) {
+      q.resetStats();
+      int64_t t = nowNs();
+      q.quantize(in.data(), codes.data(), samples);
+      best = fmin(best, elapsedMs(t));
+    }
+    error = measure(in.data(), codes.data(), samples, format);
+    report(m.name, samples, best, &q.stats(), &error);
+  }
+
+  /* Codes from the last run, already in range */
+  DacQuantizer q(format);
+  best = 1e30;
+  for (int r = 0; r < repeats; r++) {
+    q.resetStats();
+    int64_t t = nowNs();
+    q.copyCodes(codes.data(), copy.data(), samples);
+    best = fmin(best, elapsedMs(t));
+  }
+  report("int16 codes", samples, best, &q.stats(), nullptr);
+  return 0;
+}
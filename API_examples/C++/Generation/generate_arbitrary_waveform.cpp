@@ -1,15 +1,15 @@
+/* Red Pitaya C++ API example Generating an arbitrary waveform
+ * This application loads one period of a sum of harmonics into the
+ * arbitrary waveform buffer of each output and plays it at 4 kHz. */
 
-#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "common/synth.h"
 #include "rp.h"
 
-#define M_PI 3.14159265358979323846
-
 int main(int argc, char **argv) {
 
-  int i;
   int buff_size = 16384;
 
   /* Print error, if rp_Init() function failed */
@@ -17,18 +17,16 @@ int main(int argc, char **argv) {
     fprintf(stderr, "Rp api init failed!\n");
   }
 
-  float *t = (float *)malloc(buff_size * sizeof(float));
   float *x = (float *)malloc(buff_size * sizeof(float));
   float *y = (float *)malloc(buff_size * sizeof(float));
 
-  for (i = 1; i < buff_size; i++) {
-    t[i] = (2 * M_PI) / buff_size * i;
-  }
-
-  for (int i = 0; i < buff_size; ++i) {
-    x[i] = sin(t[i]) + ((1.0 / 3.0) * sin(t[i] * 3));
-    y[i] = (1.0 / 2.0) * sin(t[i]) + (1.0 / 4.0) * sin(t[i] * 4);
-  }
+  /* x = sin(t) + 1/3 sin(3t), y = 1/2 sin(t) + 1/4 sin(4t), one period */
+  SynthOsc osc;
+  osc.step = synthCyclesStep(1, buff_size);
+  Wavetable::harmonics({1.0f, 0.0f, 1.0f / 3}).render(x, buff_size, &osc, 1);
+  osc.phase = 0;
+  Wavetable::harmonics({0.5f, 0.0f, 0.0f, 0.25f})
+      .render(y, buff_size, &osc, 1);
 
   rp_GenWaveform(RP_CH_1, RP_WAVEFORM_ARBITRARY);
   rp_GenWaveform(RP_CH_2, RP_WAVEFORM_ARBITRARY);
@@ -49,6 +47,5 @@ int main(int argc, char **argv) {
   /* Releasing resources */
   free(y);
   free(x);
-  free(t);
   rp_Release();
 }
@@ -0,0 +1,221 @@
+/* Red Pitaya C++ API example Streaming playback via DMA
+ * This application plays an arbitrarily long, non-repeating signal on OUT1.
+ * The DMA region is used as a ring that the generator loops over; a refill
+ * thread rewrites each segment of the ring after it has played, with
+ * samples that a producer thread pushes through a lock-free queue.
+ *
+ * The producer synthesizes a tone with a wandering frequency, or reads raw
+ * float32 samples from a file or pipe (-i, "-" for stdin). Once a second
+ * the queue fill, output latency, refill margin and underruns are printed.
+ * -s plays into a simulated DAC that consumes the ring at the DAC rate and
+ * counts samples it played before they were written.
+ *
+ * The DAC position is counted on the ADC write pointer, which runs on the
+ * same clock, so the refill timing holds for streams of any length. */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "common/dac_stream.h"
+#include "common/synth.h"
+#include "common/timing.h"
+#include "rp.h"
+#include "rp_hw-profiles.h"
+
+#define BLOCK_SIZE 4096
+
+struct ProducerSettings {
+  const char *input = NULL;
+  double rate = 0;
+  double freq = 1000;
+  double seconds = 10;
+  /* Producer pause once per second of output, to provoke underruns */
+  uint32_t stallMs = 0;
+};
+
+/* Tone whose frequency wanders by +-50 % over 10 s, phase continuous */
+auto produceSynth(DacStream *stream, const ProducerSettings &s) -> void {
+  const Wavetable &sine = Wavetable::sine();
+  std::vector<float> block(BLOCK_SIZE);
+  SynthOsc osc;
+  uint64_t total = (uint64_t)(s.seconds * s.rate);
+  uint64_t nextStall = (uint64_t)s.rate;
+  for (uint64_t done = 0; done < total;) {
+    uint32_t n = total - done < BLOCK_SIZE ? total - done : BLOCK_SIZE;
+    double t = done / s.rate;
+    osc.step = synthStep(s.freq * (1 + 0.5 * sin(2 * M_PI * t / 10)), s.rate);
+    sine.render(block.data(), n, &osc, 0.8f);
+    if (!stream->writeAll(block.data(), n)) {
+      return;
+    }
+    done += n;
+    if (s.stallMs && done >= nextStall) {
+      usleep(s.stallMs * 1000);
+      nextStall += (uint64_t)s.rate;
+    }
+  }
+}
+
+auto produceFile(DacStream *stream, const ProducerSettings &s) -> void {
+  FILE *f = strcmp(s.input, "-") ? fopen(s.input, "rb") : stdin;
+  if (!f) {
+    fprintf(stderr, "Can't open %s\n", s.input);
+    return;
+  }
+  std::vector<float> block(BLOCK_SIZE);
+  size_t n;
+  while ((n = fread(block.data(), sizeof(float), BLOCK_SIZE, f)) > 0) {
+    if (!stream->writeAll(block.data(), n)) {
+      break;
+    }
+  }
+  if (f != stdin) {
+    fclose(f);
+  }
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-d decimation] [-m ring] [-k segments] [-q queue] "
+          "[-i input] [-t seconds] [-f freq] [-u ms] [-s]\n"
+          "\t-d : DAC decimation (default 64)\n"
+          "\t-m : Ring size in samples (default 262144)\n"
+          "\t-k : Ring segments, 2 is ping-pong (default 2)\n"
+          "\t-q : Producer queue in samples (default 1048576)\n"
+          "\t-i : Raw float32 input file, - for stdin (default synthesized)\n"
+          "\t-t : Seconds of synthesized signal (default 10)\n"
+          "\t-f : Center frequency of the synthesized tone (default 1000)\n"
+          "\t-u : Stall the producer this many ms every second\n"
+          "\t-s : Simulated DAC\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  uint32_t decimation = 64;
+  uint32_t ring = 256 * 1024;
+  DacStreamSettings settings;
+  ProducerSettings producer;
+  bool sim = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:m:k:q:i:t:f:u:sh")) != -1) {
+    switch (opt) {
+    case 'd':
+      decimation = atoi(optarg);
+      break;
+    case 'm':
+      ring = atoi(optarg);
+      break;
+    case 'k':
+      settings.segments = atoi(optarg);
+      break;
+    case 'q':
+      settings.queueSamples = atoi(optarg);
+      break;
+    case 'i':
+      producer.input = optarg;
+      break;
+    case 't':
+      producer.seconds = atof(optarg);
+      break;
+    case 'f':
+      producer.freq = atof(optarg);
+      break;
+    case 'u':
+      producer.stallMs = atoi(optarg);
+      break;
+    case 's':
+      sim = true;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  if (decimation < 1 || settings.segments < 2) {
+    printHelp(argv[0]);
+    return 1;
+  }
+
+  RpDacStreamBackend rpBackend;
+  SimDacStreamBackend *simBackend = NULL;
+  DacStreamBackend *backend = &rpBackend;
+  /* Whole segments of whole blocks */
+  uint32_t unit = settings.segments * BLOCK_SIZE;
+  if (sim) {
+    uint32_t samples = ring / unit * unit;
+    simBackend = new SimDacStreamBackend(
+        rp_HPGetBaseSpeedHzOrDefault() / (double)decimation,
+        samples ? samples : unit);
+    backend = simBackend;
+  } else {
+    if (rp_Init() != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return 1;
+    }
+    if (!rpBackend.initRegion(decimation, ring, unit)) {
+      rp_Release();
+      return 1;
+    }
+  }
+  producer.rate = backend->dacRate();
+  printf("Ring %u samples in %u segments, %.3f MS/s, %.1f ms per segment\n",
+         backend->ringSamples(), settings.segments, producer.rate / 1e6,
+         backend->ringSamples() / settings.segments / producer.rate * 1e3);
+
+  int ret = 0;
+  {
+    DacStream stream(backend, settings);
+    std::thread worker([&] {
+      if (producer.input) {
+        produceFile(&stream, producer);
+      } else {
+        produceSynth(&stream, producer);
+      }
+      stream.finish();
+    });
+    if (!stream.start()) {
+      fprintf(stderr, "Can't start the stream\n");
+      ret = 1;
+    }
+    int64_t t = nowNs();
+    while (ret == 0 && stream.isRunning()) {
+      usleep(1000000);
+      DacStreamStats s = stream.stats();
+      printf("%5.1f s: played %.2f Ms, queue %.1f ms, latency %.1f ms "
+             "(max %.1f), min lead %.2f ms, underruns %llu, late %llu\n",
+             elapsedMs(t) / 1e3, s.played / 1e6, s.queued / producer.rate * 1e3,
+             s.latencyMs, s.maxLatencyMs, s.minLeadMs,
+             (unsigned long long)s.underruns,
+             (unsigned long long)s.lateRefills);
+    }
+    if (stream.failed()) {
+      fprintf(stderr, "Writing to the generator failed\n");
+      ret = 1;
+    }
+    stream.stop();
+    worker.join();
+    DacStreamStats s = stream.stats();
+    printf("Played %llu samples, %llu refills, %llu underruns (%llu samples "
+           "padded), %llu late refills, %llu samples skipped\n",
+           (unsigned long long)s.played, (unsigned long long)s.refills,
+           (unsigned long long)s.underruns,
+           (unsigned long long)s.underrunSamples,
+           (unsigned long long)s.lateRefills,
+           (unsigned long long)s.skippedSamples);
+  }
+  if (sim) {
+    printf("Simulated DAC played %llu stale samples\n",
+           (unsigned long long)simBackend->stale());
+    delete simBackend;
+  } else {
+    rpBackend.release();
+    rp_Release();
+  }
+  return ret;
+}
@@ -0,0 +1,321 @@
+/* Red Pitaya C++ API example Stepped frequency sweep via DMA
+ * This application plays a stepped frequency sweep on OUT1: a linear or
+ * logarithmic law between two frequencies, or a table of frequencies with
+ * optional per-step dwell (-T, lines "frequency [dwell ms]"). Every step
+ * lasts exactly its dwell in DAC samples and the phase runs on across step
+ * boundaries and from one pass of the sweep to the next.
+ *
+ * The samples are rendered by one DDS accumulator and streamed through the
+ * DMA ring, so a sweep of any length plays without gaps. -m writes the
+ * marker timeline (first sample, length and produced frequency of each
+ * step) as CSV, to cut a capture that starts with the generator into
+ * steps. Once a second the step being played is printed.
+ * -s plays into a simulated DAC and first checks that the rendered sweep
+ * has no phase jump: no sample to sample change beyond what the highest
+ * frequency allows. */
+
+#include <math.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "common/dac_stream.h"
+#include "common/sweep.h"
+#include "common/timing.h"
+#include "rp.h"
+#include "rp_hw-profiles.h"
+
+#define BLOCK_SIZE 4096
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void onSignal(int) { g_stop = 1; }
+
+auto readTable(const char *path, std::vector<SweepPoint> *table) -> bool {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Can't open %s\n", path);
+    return false;
+  }
+  char line[256];
+  int number = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f)) {
+    number++;
+    char *hash = strchr(line, '#');
+    if (hash) {
+      *hash = 0;
+    }
+    SweepPoint p;
+    double dwellMs = 0;
+    int fields = sscanf(line, "%lf %lf", &p.frequency, &dwellMs);
+    if (fields <= 0) {
+      continue;
+    }
+    ok = p.frequency >= 0 && dwellMs >= 0;
+    if (!ok) {
+      fprintf(stderr, "%s:%d: bad step\n", path, number);
+      break;
+    }
+    p.dwell = dwellMs * 1e-3;
+    table->push_back(p);
+  }
+  fclose(f);
+  if (ok && table->empty()) {
+    fprintf(stderr, "%s: no steps\n", path);
+    ok = false;
+  }
+  return ok;
+}
+
+/* Step that pass position pos falls in */
+auto stepAt(const std::vector<SweepStep> &steps, uint64_t pos)
+    -> const SweepStep & {
+  uint32_t lo = 0, hi = steps.size() - 1;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi + 1) / 2;
+    if (steps[mid].start <= pos) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return steps[lo];
+}
+
+/* Renders two passes and looks for a sample step larger than the highest
+ * frequency can make, which a phase reset at a step boundary or at the
+ * wrap would. Returns the render rate in samples per second. */
+auto checkContinuity(Sweep *sweep, float amplitude) -> double {
+  const std::vector<SweepStep> &steps = sweep->steps();
+  double maxFreq = 0;
+  for (const SweepStep &s : steps) {
+    maxFreq = s.frequency > maxFreq ? s.frequency : maxFreq;
+  }
+  double limit = 2 * M_PI * maxFreq / sweep->rate() * amplitude * 1.001 + 1e-5;
+
+  std::vector<float> block(BLOCK_SIZE);
+  uint64_t total = 2 * sweep->samples();
+  double maxJump = 0;
+  uint64_t worst = 0;
+  float last = 0;
+  int64_t t = nowNs();
+  for (uint64_t done = 0; done < total;) {
+    uint32_t n = total - done < BLOCK_SIZE ? total - done : BLOCK_SIZE;
+    sweep->render(block.data(), n);
+    for (uint32_t i = 0; i < n; i++) {
+      double jump = fabs(block[i] - last);
+      if (done + i > 0 && jump > maxJump) {
+        maxJump = jump;
+        worst = done + i;
+      }
+      last = block[i];
+    }
+    done += n;
+  }
+  double seconds = (nowNs() - t) * 1e-9;
+  sweep->rewind();
+
+  const SweepStep &s = stepAt(steps, worst % sweep->samples());
+  printf("Largest sample step %.6f at sample %llu (step %u, %.3f Hz), "
+         "limit %.6f: %s\n",
+         maxJump, (unsigned long long)worst, s.index, s.frequency, limit,
+         maxJump <= limit ? "phase continuous" : "PHASE JUMP");
+  return seconds > 0 ? total / seconds : 0;
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-l lin|log] [-a start] [-b stop] [-n steps] "
+          "[-w dwell] [-T table] [-A amplitude] [-r passes] [-d decimation] "
+          "[-m markers] [-s]\n"
+          "\t-l : Sweep law (default log)\n"
+          "\t-a : Start frequency in Hz (default 100)\n"
+          "\t-b : Stop frequency in Hz (default 100000)\n"
+          "\t-n : Number of steps (default 50)\n"
+          "\t-w : Dwell per step in ms (default 10)\n"
+          "\t-T : Step table, lines \"frequency [dwell ms]\"\n"
+          "\t-A : Amplitude in V (default 0.8)\n"
+          "\t-r : Passes of the sweep, 0 until Ctrl-C (default 1)\n"
+          "\t-d : DAC decimation (default 64)\n"
+          "\t-m : Write the marker timeline as CSV, - for stdout\n"
+          "\t-s : Simulated DAC\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  SweepSettings settings;
+  const char *tablePath = NULL;
+  const char *markers = NULL;
+  uint32_t passes = 1;
+  uint32_t decimation = 64;
+  bool sim = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "l:a:b:n:w:T:A:r:d:m:sh")) != -1) {
+    switch (opt) {
+    case 'l':
+      if (strcmp(optarg, "lin") == 0) {
+        settings.law = SweepLaw::LINEAR;
+      } else if (strcmp(optarg, "log") == 0) {
+        settings.law = SweepLaw::LOG;
+      } else {
+        printHelp(argv[0]);
+        return 1;
+      }
+      break;
+    case 'a':
+      settings.start = atof(optarg);
+      break;
+    case 'b':
+      settings.stop = atof(optarg);
+      break;
+    case 'n':
+      settings.steps = atoi(optarg);
+      break;
+    case 'w':
+      settings.dwell = atof(optarg) * 1e-3;
+      break;
+    case 'T':
+      tablePath = optarg;
+      break;
+    case 'A':
+      settings.amplitude = atof(optarg);
+      break;
+    case 'r':
+      passes = atoi(optarg);
+      break;
+    case 'd':
+      decimation = atoi(optarg);
+      break;
+    case 'm':
+      markers = optarg;
+      break;
+    case 's':
+      sim = true;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  if (decimation < 1 || settings.amplitude <= 0 || settings.amplitude > 1) {
+    printHelp(argv[0]);
+    return 1;
+  }
+  if (tablePath) {
+    settings.law = SweepLaw::TABLE;
+    if (!readTable(tablePath, &settings.table)) {
+      return 1;
+    }
+  }
+
+  DacStreamSettings streamSettings;
+  uint32_t ring = 256 * 1024;
+  RpDacStreamBackend rpBackend;
+  SimDacStreamBackend *simBackend = NULL;
+  DacStreamBackend *backend = &rpBackend;
+  if (sim) {
+    simBackend = new SimDacStreamBackend(
+        rp_HPGetBaseSpeedHzOrDefault() / (double)decimation, ring);
+    backend = simBackend;
+  } else {
+    if (rp_Init() != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return 1;
+    }
+    if (!rpBackend.initRegion(decimation, ring,
+                              streamSettings.segments * BLOCK_SIZE)) {
+      rp_Release();
+      return 1;
+    }
+  }
+  double rate = backend->dacRate();
+
+  int ret = 0;
+  Sweep sweep(settings, rate);
+  if (!sweep.valid()) {
+    ret = 1;
+  }
+  if (ret == 0 && markers) {
+    FILE *f = strcmp(markers, "-") ? fopen(markers, "w") : stdout;
+    if (!f || !sweep.writeTimeline(f)) {
+      fprintf(stderr, "Can't write %s\n", markers);
+      ret = 1;
+    }
+    if (f && f != stdout) {
+      fclose(f);
+    }
+  }
+  if (ret == 0) {
+    printf("%zu steps, %llu samples (%.3f s) per pass at %.3f MS/s\n",
+           sweep.steps().size(), (unsigned long long)sweep.samples(),
+           sweep.samples() / rate, rate / 1e6);
+  }
+  if (ret == 0 && sim) {
+    double renderRate = checkContinuity(&sweep, settings.amplitude);
+    printf("Rendered at %.1f MS/s, %.0fx the DAC rate\n", renderRate / 1e6,
+           renderRate / rate);
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  if (ret == 0) {
+    DacStream stream(backend, streamSettings);
+    std::thread producer([&] {
+      std::vector<float> block(BLOCK_SIZE);
+      uint64_t total = passes ? passes * sweep.samples() : UINT64_MAX;
+      for (uint64_t done = 0; done < total && !g_stop;) {
+        uint32_t n = total - done < BLOCK_SIZE ? total - done : BLOCK_SIZE;
+        sweep.render(block.data(), n);
+        if (!stream.writeAll(block.data(), n)) {
+          break;
+        }
+        done += n;
+      }
+      stream.finish();
+    });
+    if (!stream.start()) {
+      fprintf(stderr, "Can't start the stream\n");
+      ret = 1;
+    }
+    while (ret == 0 && !g_stop && stream.isRunning()) {
+      usleep(1000000);
+      DacStreamStats s = stream.stats();
+      uint64_t pass = s.played / sweep.samples();
+      const SweepStep &step =
+          stepAt(sweep.steps(), s.played % sweep.samples());
+      printf("Pass %llu, step %u of %zu: %.3f Hz, underruns %llu, late "
+             "%llu\n",
+             (unsigned long long)pass + 1, step.index + 1,
+             sweep.steps().size(), step.frequency,
+             (unsigned long long)s.underruns,
+             (unsigned long long)s.lateRefills);
+    }
+    if (stream.failed()) {
+      fprintf(stderr, "Writing to the generator failed\n");
+      ret = 1;
+    }
+    g_stop = 1;
+    stream.stop();
+    producer.join();
+    DacStreamStats s = stream.stats();
+    printf("Played %llu samples, %llu underruns, %llu late refills\n",
+           (unsigned long long)s.played, (unsigned long long)s.underruns,
+           (unsigned long long)s.lateRefills);
+  }
+  if (sim) {
+    printf("Simulated DAC played %llu stale samples\n",
+           (unsigned long long)simBackend->stale());
+    delete simBackend;
+  } else {
+    rpBackend.release();
+    rp_Release();
+  }
+  return ret;
+}
@@ -0,0 +1,372 @@
+/* Red Pitaya C++ API example Switching between arbitrary waveforms
+ * This application steps through a sequence of arbitrary waveforms, as a
+ * test sequencer would. A content-addressed cache remembers what is loaded
+ * in generator memory, so a waveform is only uploaded when it is not there
+ * already:
+ *  - AWG mode: the 16k sample buffer of each output holds one waveform,
+ *    steps that keep an output's waveform skip the upload.
+ *  - AXI mode (-x): the DMA region of OUT1 is split into slots, the
+ *    waveforms of the sequence are preloaded into spare slots before the
+ *    output starts and a switch only moves the DMA start and end addresses.
+ *    librp only writes inside the reserved DMA window, which is the playing
+ *    slot once the output runs, so a waveform that was not preloaded stops
+ *    the output for its upload, like an AWG upload does.
+ * With -s the generator memory is simulated and no hardware is needed, -c
+ * uploads on every step for comparison. */
+
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/synth.h"
+#include "common/timing.h"
+#include "common/waveform_cache.h"
+#include "rp.h"
+#include "rp_asg_axi.h"
+
+#define WAVEFORM_SAMPLES 16384
+#define SCRIPT_STEPS 24
+#define CHANNELS 2
+
+/* Generator memory seen as slots of WAVEFORM_SAMPLES samples. AWG mode has
+ * one slot per output, AXI mode several on OUT1. In AXI mode the DMA window
+ * covers the whole pool while the output is stopped and only the playing
+ * slot while it runs. */
+class Generator {
+public:
+  Generator(bool sim, bool axi) : m_sim(sim), m_axi(axi) {}
+
+  ~Generator() {
+    if (!m_sim) {
+      if (m_axi) {
+        rp_GenAxiSetEnable(RP_CH_1, false);
+        rp_GenAxiReleaseMemory(RP_CH_1);
+      }
+      rp_Release();
+    }
+  }
+
+  auto init(uint32_t maxSlots) -> bool {
+    uint32_t slotBytes = WAVEFORM_SAMPLES * sizeof(int16_t);
+    m_slots = m_axi ? maxSlots : 1;
+    if (m_axi && m_slots < 2) {
+      fprintf(stderr, "AXI mode needs at least two slots\n");
+      return false;
+    }
+    if (!m_sim) {
+      if (rp_Init() != RP_OK) {
+        fprintf(stderr, "Rp api init failed!\n");
+        return false;
+      }
+      if (m_axi) {
+        uint32_t size;
+        if (rp_AcqAxiGetMemoryRegion(&m_start, &size) != RP_OK) {
+          fprintf(stderr, "Error get memory!\n");
+          return false;
+        }
+        if (size / slotBytes < m_slots) {
+          m_slots = size / slotBytes;
+        }
+        if (m_slots < 2) {
+          fprintf(stderr, "AXI region too small for two waveforms\n");
+          return false;
+        }
+        if (rp_GenAxiSetDecimationFactor(RP_CH_1, 1) != RP_OK ||
+            !reserve(0, m_slots * WAVEFORM_SAMPLES) ||
+            rp_GenAxiSetEnable(RP_CH_1, true) != RP_OK) {
+          fprintf(stderr, "Error setting AXI mode for OUT1\n");
+          return false;
+        }
+        rp_GenSetAmplitudeAndOffsetOrigin(RP_CH_1);
+      } else {
+        for (int ch = 0; ch < CHANNELS; ch++) {
+          rp_GenWaveform((rp_channel_t)ch, RP_WAVEFORM_ARBITRARY);
+          rp_GenFreq((rp_channel_t)ch, 4000.0);
+          rp_GenAmp((rp_channel_t)ch, 0.9);
+        }
+      }
+    }
+    m_memory.assign((m_axi ? m_slots : CHANNELS) * WAVEFORM_SAMPLES, 0);
+    return true;
+  }
+
+  auto slots() const -> uint32_t { return m_slots; }
+
+  auto upload(int ch, int slot, const float *data, uint32_t n) -> bool {
+    if (m_axi && !stop()) {
+      return false;
+    }
+    if (m_sim) {
+      /* What the driver does: scale to DAC codes and copy */
+      int16_t *dst = m_memory.data() +
+                     (m_axi ? slot : ch) * (size_t)WAVEFORM_SAMPLES;
+      for (uint32_t i = 0; i < n; i++) {
+        float v = data[i] < -1 ? -1 : (data[i] > 1 ? 1 : data[i]);
+        dst[i] = (int16_t)lrintf(v * 8191);
+      }
+      return true;
+    }
+    if (!m_axi) {
+      return rp_GenArbWaveform((rp_channel_t)ch, (float *)data, n) == RP_OK;
+    }
+    return rp_GenAxiWriteWaveformOffset(RP_CH_1, slot * WAVEFORM_SAMPLES,
+                                        (float *)data, n) == RP_OK;
+  }
+
+  auto play(int ch, int slot, uint32_t n) -> bool {
+    if (!m_axi) {
+      return true;
+    }
+    bool start = !m_running;
+    m_running = true;
+    if (m_sim) {
+      return true;
+    }
+    if (!reserve(slot * WAVEFORM_SAMPLES, n)) {
+      return false;
+    }
+    if (start) {
+      rp_GenOutEnable((rp_channel_t)ch);
+      rp_GenTriggerOnly((rp_channel_t)ch);
+    }
+    return true;
+  }
+
+  /* Times a running AXI output was stopped for an upload */
+  auto stops() const -> uint32_t { return m_stops; }
+
+  auto start() -> void {
+    if (!m_sim && !m_axi) {
+      rp_GenOutEnable(RP_CH_1);
+      rp_GenOutEnable(RP_CH_2);
+      rp_GenSynchronise();
+    }
+  }
+
+private:
+  /* Stops a running AXI output and opens the window over the whole pool */
+  auto stop() -> bool {
+    if (!m_running) {
+      return true;
+    }
+    m_running = false;
+    m_stops++;
+    if (m_sim) {
+      return true;
+    }
+    rp_GenOutDisable(RP_CH_1);
+    return reserve(0, m_slots * WAVEFORM_SAMPLES);
+  }
+
+  auto reserve(uint32_t first, uint32_t n) -> bool {
+    uint32_t start = m_start + first * sizeof(int16_t);
+    return rp_GenAxiReserveMemory(RP_CH_1, start,
+                                  start + n * sizeof(int16_t)) == RP_OK;
+  }
+
+  bool m_sim;
+  bool m_axi;
+  uint32_t m_slots = 1;
+  uint32_t m_start = 0;
+  bool m_running = false;
+  uint32_t m_stops = 0;
+  std::vector<int16_t> m_memory;
+};
+
+/* Random sums of the first 16 harmonics, scaled to a peak of 0.95 */
+auto makeWaveforms(uint32_t count) -> std::vector<std::vector<float>> {
+  std::minstd_rand rng(1);
+  std::uniform_real_distribution<float> amp(-1, 1);
+  std::vector<std::vector<float>> waves(count);
+  for (auto &w : waves) {
+    std::vector<float> amps(16);
+    for (uint32_t h = 0; h < amps.size(); h++) {
+      amps[h] = amp(rng) / (h + 1);
+    }
+    Wavetable table = Wavetable::harmonics(amps);
+    SynthOsc osc;
+    osc.step = synthCyclesStep(1, WAVEFORM_SAMPLES);
+    w.resize(WAVEFORM_SAMPLES);
+    table.render(w.data(), WAVEFORM_SAMPLES, &osc, 0.95f / table.peak());
+  }
+  return waves;
+}
+
+auto printStats(const char *name, const WaveformCacheStats &s) -> void {
+  printf("%s: %llu hits, %llu misses, %llu preloads (%llu used), %llu "
+         "evictions, %llu samples uploaded, %llu skipped\n",
+         name, (unsigned long long)s.hits, (unsigned long long)s.misses,
+         (unsigned long long)s.preloads, (unsigned long long)s.preloadHits,
+         (unsigned long long)s.evictions,
+         (unsigned long long)s.uploadedSamples,
+         (unsigned long long)s.skippedSamples);
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-w waveforms] [-n steps] [-x] [-k slots] [-p depth] "
+          "[-t ms] [-c] [-s]\n"
+          "\t-w : Number of different waveforms (default 32)\n"
+          "\t-n : Sequence steps to play (default 1000)\n"
+          "\t-x : Play from AXI memory on OUT1 with preloading\n"
+          "\t-k : Maximum AXI slots (default 64)\n"
+          "\t-p : Script steps preloaded before the output starts in AXI\n"
+          "\t     mode (default: as many as there are spare slots)\n"
+          "\t-t : Time each step plays in ms (default 0)\n"
+          "\t-c : Upload on every step, no cache\n"
+          "\t-s : Simulated generator memory\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  uint32_t count = 32;
+  uint32_t steps = 1000;
+  bool axi = false;
+  uint32_t maxSlots = 64;
+  uint32_t depth = SCRIPT_STEPS;
+  uint32_t dwellMs = 0;
+  bool useCache = true;
+  bool sim = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "w:n:xk:p:t:csh")) != -1) {
+    switch (opt) {
+    case 'w':
+      count = atoi(optarg);
+      break;
+    case 'n':
+      steps = atoi(optarg);
+      break;
+    case 'x':
+      axi = true;
+      break;
+    case 'k':
+      maxSlots = atoi(optarg);
+      break;
+    case 'p':
+      depth = atoi(optarg);
+      break;
+    case 't':
+      dwellMs = atoi(optarg);
+      break;
+    case 'c':
+      useCache = false;
+      break;
+    case 's':
+      sim = true;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  if (count < 1 || steps < 1) {
+    printHelp(argv[0]);
+    return 1;
+  }
+
+  std::vector<std::vector<float>> waves = makeWaveforms(count);
+  /* A repeating script, OUT2 changes every fourth step */
+  std::minstd_rand rng(2);
+  std::vector<uint32_t> script[CHANNELS];
+  for (int ch = 0; ch < CHANNELS; ch++) {
+    for (uint32_t i = 0; i < SCRIPT_STEPS; i++) {
+      script[ch].push_back(ch == 0 || i % 4 == 0 ? rng() % count
+                                                 : script[ch].back());
+    }
+  }
+
+  Generator gen(sim, axi);
+  if (!gen.init(maxSlots)) {
+    return 1;
+  }
+  int channels = axi ? 1 : CHANNELS;
+  std::vector<WaveformCache> caches;
+  for (int ch = 0; ch < channels; ch++) {
+    caches.emplace_back(gen.slots(), WAVEFORM_SAMPLES);
+  }
+  if (axi && depth > gen.slots() - 1) {
+    depth = gen.slots() - 1;
+  }
+  /* Keys are computed once per waveform, the cache never sees samples */
+  std::vector<WaveformKey> keys(count);
+  int64_t t = nowNs();
+  for (uint32_t i = 0; i < count; i++) {
+    keys[i] = waveformKey(waves[i].data(), WAVEFORM_SAMPLES);
+  }
+  double hashMs = elapsedMs(t);
+
+  /* Fill spare slots with the script while the output is stopped */
+  t = nowNs();
+  bool ok = true;
+  for (int ch = 0; ok && useCache && axi && ch < channels; ch++) {
+    for (uint32_t k = 0; ok && k < depth && k < SCRIPT_STEPS; k++) {
+      uint32_t w = script[ch][k];
+      bool upload = false;
+      int p = caches[ch].preload(keys[w], &upload);
+      if (p >= 0 && upload) {
+        ok = gen.upload(ch, p, waves[w].data(), WAVEFORM_SAMPLES);
+        if (!ok) {
+          caches[ch].invalidate(p);
+        }
+      }
+    }
+  }
+  double preloadMs = elapsedMs(t);
+
+  double uploadMs = 0;
+  t = nowNs();
+  for (uint32_t step = 0; ok && step < steps; step++) {
+    for (int ch = 0; ok && ch < channels; ch++) {
+      const std::vector<uint32_t> &s = script[ch];
+      uint32_t w = s[step % SCRIPT_STEPS];
+      WaveformCache &cache = caches[ch];
+      bool upload = true;
+      int slot = useCache ? cache.select(keys[w], &upload)
+                          : (int)(step % gen.slots());
+      int64_t u = nowNs();
+      if (upload) {
+        ok = gen.upload(ch, slot, waves[w].data(), WAVEFORM_SAMPLES);
+        if (!ok) {
+          cache.invalidate(slot);
+        }
+      }
+      ok = ok && gen.play(ch, slot, WAVEFORM_SAMPLES);
+      cache.setPlaying(slot);
+      uploadMs += elapsedMs(u);
+    }
+    if (step == 0) {
+      gen.start();
+    }
+    if (dwellMs) {
+      usleep(dwellMs * 1000);
+    }
+  }
+  double totalMs = elapsedMs(t);
+  if (!ok) {
+    fprintf(stderr, "Upload failed\n");
+    return 1;
+  }
+
+  printf("%u steps over %u waveforms, %s%s, %u slots%s\n", steps, count,
+         axi ? "AXI" : "AWG", sim ? " (simulated)" : "", gen.slots(),
+         useCache ? "" : ", no cache");
+  printf("Hashing %u waveforms: %.3f ms, switching: %.3f ms per step "
+         "(uploads %.1f ms of %.1f ms)\n",
+         count, hashMs, uploadMs / steps, uploadMs, totalMs);
+  if (axi) {
+    printf("Preloading before the start: %.1f ms, output stopped for %u "
+           "uploads\n",
+           preloadMs, gen.stops());
+  }
+  if (useCache) {
+    for (int ch = 0; ch < channels; ch++) {
+      char name[16];
+      snprintf(name, sizeof(name), "OUT%d", ch + 1);
+      printStats(name, caches[ch].stats());
+    }
+  }
+  return 0;
+}
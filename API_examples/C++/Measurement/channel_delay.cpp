@@ -0,0 +1,336 @@
+/* Red Pitaya C++ API example Inter-channel delay measurement
+ * This application captures the same signal on all inputs and measures the
+ * delay of every channel relative to IN1 with sub-sample resolution using
+ * cross-correlation.
+ *
+ * Capture modes:
+ *   default : common trigger, 16k buffer per channel
+ *   -t      : split trigger, each channel triggers on its own rising edge
+ *   -x N    : AXI capture of N samples per channel
+ * In split trigger and AXI mode every channel is read from its own write
+ * pointer at trigger, and the difference of those pointers is added to the
+ * measured lag. With -s the channels are simulated with known fractional
+ * delays and different read positions. */
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/fft.h"
+#include "common/timing.h"
+#include "common/xcorr.h"
+#include "rp.h"
+#include "rp_hw-profiles.h"
+
+#define MAX_CH 4
+
+struct Capture {
+  int channels = 0;
+  uint32_t samples = 0;
+  /* Circular buffer size the write pointers refer to */
+  uint32_t bufferSize = 0;
+  std::vector<float> data[MAX_CH];
+  uint32_t pos[MAX_CH] = {};
+};
+
+const rp_channel_t g_ch[MAX_CH] = {RP_CH_1, RP_CH_2, RP_CH_3, RP_CH_4};
+
+auto captureCommon(Capture *cap, uint32_t decimation) -> bool {
+  rp_AcqReset();
+  rp_AcqSetDecimationFactor(decimation);
+  rp_AcqSetTriggerDelay(ADC_BUFFER_SIZE / 2);
+  rp_AcqStart();
+  rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+  rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+  while (state != RP_TRIG_STATE_TRIGGERED) {
+    rp_AcqGetTriggerState(&state);
+  }
+  bool fillState = false;
+  while (!fillState) {
+    rp_AcqGetBufferFillState(&fillState);
+  }
+  rp_AcqStop();
+
+  uint32_t pos = 0;
+  rp_AcqGetWritePointerAtTrig(&pos);
+  cap->samples = ADC_BUFFER_SIZE;
+  cap->bufferSize = ADC_BUFFER_SIZE;
+  for (int i = 0; i < cap->channels; i++) {
+    uint32_t size = cap->samples;
+    cap->data[i].resize(size);
+    cap->pos[i] = pos;
+    if (rp_AcqGetDataV(g_ch[i], pos, &size, cap->data[i].data()) != RP_OK) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto captureSplit(Capture *cap, uint32_t decimation, float level) -> bool {
+  const rp_channel_trigger_t trig[MAX_CH] = {RP_T_CH_1, RP_T_CH_2, RP_T_CH_3,
+                                             RP_T_CH_4};
+  const rp_acq_trig_src_t src[MAX_CH] = {
+      RP_TRIG_SRC_CHA_PE, RP_TRIG_SRC_CHB_PE, RP_TRIG_SRC_CHC_PE,
+      RP_TRIG_SRC_CHD_PE};
+
+  rp_AcqReset();
+  rp_AcqSetSplitTrigger(true);
+  /* Same decimation and start on every channel keeps the write pointers in
+   * lockstep, which the offset correction relies on */
+  for (int i = 0; i < cap->channels; i++) {
+    rp_AcqResetCh(g_ch[i]);
+    rp_AcqSetDecimationFactorCh(g_ch[i], decimation);
+    rp_AcqSetTriggerLevel(trig[i], level);
+    rp_AcqSetTriggerDelayCh(g_ch[i], ADC_BUFFER_SIZE / 2);
+  }
+  for (int i = 0; i < cap->channels; i++) {
+    rp_AcqStartCh(g_ch[i]);
+  }
+  for (int i = 0; i < cap->channels; i++) {
+    rp_AcqSetTriggerSrcCh(g_ch[i], src[i]);
+  }
+  for (int i = 0; i < cap->channels; i++) {
+    bool fillState = false;
+    while (!fillState) {
+      rp_AcqGetBufferFillStateCh(g_ch[i], &fillState);
+    }
+  }
+
+  cap->samples = ADC_BUFFER_SIZE / 2;
+  cap->bufferSize = ADC_BUFFER_SIZE;
+  for (int i = 0; i < cap->channels; i++) {
+    uint32_t size = cap->samples;
+    cap->data[i].resize(size);
+    rp_AcqGetWritePointerAtTrigCh(g_ch[i], &cap->pos[i]);
+    if (rp_AcqGetDataV(g_ch[i], cap->pos[i], &size, cap->data[i].data()) !=
+        RP_OK) {
+      return false;
+    }
+  }
+  rp_AcqSetSplitTrigger(false);
+  return true;
+}
+
+auto captureAxi(Capture *cap, uint32_t decimation, uint32_t samples) -> bool {
+  uint32_t start, size;
+  rp_AcqAxiGetMemoryRegion(&start, &size);
+  uint32_t region = size / cap->channels;
+  if (samples * sizeof(int16_t) > region) {
+    samples = region / sizeof(int16_t);
+  }
+
+  if (rp_AcqAxiSetDecimationFactor(decimation) != RP_OK) {
+    fprintf(stderr, "rp_AcqAxiSetDecimationFactor failed!\n");
+    return false;
+  }
+  for (int i = 0; i < cap->channels; i++) {
+    if (rp_AcqAxiSetTriggerDelay(g_ch[i], samples) != RP_OK ||
+        rp_AcqAxiSetBufferSamples(g_ch[i], start + region * i, samples) !=
+            RP_OK ||
+        rp_AcqAxiEnable(g_ch[i], true) != RP_OK) {
+      fprintf(stderr, "AXI setup of channel %d failed!\n", i + 1);
+      return false;
+    }
+  }
+  rp_AcqStart();
+  rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+  for (int i = 0; i < cap->channels; i++) {
+    bool fillState = false;
+    while (!fillState) {
+      rp_AcqAxiGetBufferFillState(g_ch[i], &fillState);
+    }
+  }
+  rp_AcqStop();
+
+  cap->samples = samples;
+  cap->bufferSize = samples;
+  std::vector<int16_t> raw(samples);
+  for (int i = 0; i < cap->channels; i++) {
+    uint32_t n = samples;
+    rp_AcqAxiGetWritePointerAtTrig(g_ch[i], &cap->pos[i]);
+    if (rp_AcqAxiGetDataRaw(g_ch[i], cap->pos[i], &n, raw.data()) != RP_OK) {
+      return false;
+    }
+    /* Raw codes are fine for delay estimation, no need to scale */
+    cap->data[i].resize(samples);
+    for (uint32_t k = 0; k < samples; k++) {
+      cap->data[i][k] = raw[k];
+    }
+    rp_AcqAxiEnable(g_ch[i], false);
+  }
+  return true;
+}
+
+/* Band-limited noise (up to a fifth of the sample rate) delayed per channel
+ * in the frequency domain, so fractional delays are exact. Channel i is read
+ * starting at absolute sample cap->pos[i]. */
+auto simulate(Capture *cap, uint32_t samples, const double *delays) -> void {
+  const uint32_t margin = 4096;
+  Fft fft(Fft::nextPow2((uint64_t)samples + margin));
+  const uint32_t m = fft.size();
+
+  std::minstd_rand rng(1);
+  std::normal_distribution<float> noise(0, 1);
+  std::vector<float> re(m), im(m, 0.0f);
+  for (auto &v : re) {
+    v = noise(rng);
+  }
+  fft.forward(re.data(), im.data());
+
+  cap->samples = samples;
+  cap->bufferSize = margin;
+  std::vector<float> cr(m), ci(m);
+  for (int i = 0; i < cap->channels; i++) {
+    /* s(n + pos - delay) */
+    double shift = cap->pos[i] - delays[i];
+    std::fill(cr.begin(), cr.end(), 0.0f);
+    std::fill(ci.begin(), ci.end(), 0.0f);
+    /* Positive and negative bins up to the band edge, the phase rotates
+     * by a fixed step per bin */
+    uint32_t edge = m / 5;
+    double step = 2 * M_PI * shift / m;
+    double sr = cos(step), si = sin(step);
+    double pr = 1, pi = 0;
+    for (uint32_t k = 0; k <= edge; k++) {
+      uint32_t nk = (m - k) & (m - 1);
+      cr[k] = (float)(re[k] * pr - im[k] * pi);
+      ci[k] = (float)(re[k] * pi + im[k] * pr);
+      /* Bin -k rotates by the conjugate phase */
+      cr[nk] = (float)(re[nk] * pr + im[nk] * pi);
+      ci[nk] = (float)(im[nk] * pr - re[nk] * pi);
+      double t = pr * sr - pi * si;
+      pi = pr * si + pi * sr;
+      pr = t;
+    }
+    fft.inverse(cr.data(), ci.data());
+    cap->data[i].assign(cr.begin(), cr.begin() + samples);
+  }
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-t] [-x samples] [-d decimation] [-l max_lag] "
+          "[-m method] [-r refine] [-s] [-n samples]\n"
+          "\t-t : Split trigger mode (rising edge at -v level)\n"
+          "\t-v : Trigger level for split trigger mode (default 0.1 V)\n"
+          "\t-x : AXI capture of the given number of samples per channel\n"
+          "\t-d : Decimation (default 1)\n"
+          "\t-l : Largest lag searched (default all)\n"
+          "\t-m : auto, direct or fft (default auto)\n"
+          "\t-r : none, parabolic or sinc (default sinc)\n"
+          "\t-s : Simulated channels with known delays\n"
+          "\t-n : Samples per simulated channel (default 1M)\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  XcorrSettings settings;
+  bool split = false;
+  bool sim = false;
+  uint32_t axiSamples = 0;
+  uint32_t simSamples = 1024 * 1024;
+  uint32_t decimation = 1;
+  float level = 0.1;
+  int opt;
+  while ((opt = getopt(argc, argv, "tv:x:d:l:m:r:sn:h")) != -1) {
+    switch (opt) {
+    case 't':
+      split = true;
+      break;
+    case 'v':
+      level = atof(optarg);
+      break;
+    case 'x':
+      axiSamples = atoi(optarg);
+      break;
+    case 'd':
+      decimation = atoi(optarg);
+      break;
+    case 'l':
+      settings.maxLag = atoi(optarg);
+      break;
+    case 'm':
+      settings.method = optarg[0] == 'd'   ? XcorrMethod::DIRECT
+                        : optarg[0] == 'f' ? XcorrMethod::FFT
+                                           : XcorrMethod::AUTO;
+      break;
+    case 'r':
+      settings.refine = optarg[0] == 'n'   ? XcorrRefine::NONE
+                        : optarg[0] == 'p' ? XcorrRefine::PARABOLIC
+                                           : XcorrRefine::SINC;
+      break;
+    case 's':
+      sim = true;
+      break;
+    case 'n':
+      simSamples = atoi(optarg);
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+
+  Capture cap;
+  const double simDelays[MAX_CH] = {0, 3.25, -10.6, 1234.4};
+  bool ok = true;
+  if (sim) {
+    cap.channels = MAX_CH;
+    const uint32_t simPos[MAX_CH] = {100, 350, 100, 90};
+    for (int i = 0; i < MAX_CH; i++) {
+      cap.pos[i] = simPos[i];
+    }
+    int64_t t = nowNs();
+    simulate(&cap, simSamples, simDelays);
+    printf("Simulated %d x %u samples in %.1f ms\n", cap.channels,
+           cap.samples, elapsedMs(t));
+  } else {
+    if (rp_Init() != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return 1;
+    }
+    cap.channels = rp_HPGetFastADCChannelsCountOrDefault();
+    if (cap.channels > MAX_CH) {
+      cap.channels = MAX_CH;
+    }
+    if (axiSamples) {
+      ok = captureAxi(&cap, decimation, axiSamples);
+    } else if (split) {
+      ok = captureSplit(&cap, decimation, level);
+    } else {
+      ok = captureCommon(&cap, decimation);
+    }
+    rp_Release();
+  }
+  if (!ok) {
+    fprintf(stderr, "Capture failed!\n");
+    return 1;
+  }
+
+  double dt = decimation / (double)rp_HPGetBaseFastADCSpeedHzOrDefault();
+  for (int i = 1; i < cap.channels; i++) {
+    XcorrResult res;
+    int64_t t = nowNs();
+    if (!xcorrDelay(cap.data[0].data(), cap.data[i].data(), cap.samples,
+                    settings, &res)) {
+      continue;
+    }
+    double ms = elapsedMs(t);
+    int64_t offset = xcorrStartOffset(cap.pos[0], cap.pos[i], cap.bufferSize);
+    double delay = res.lag + offset;
+    printf("IN%d vs IN1: lag %.4f + start offset %lld = %.4f samples "
+           "(%.3f ns), coefficient %.4f, %s %.1f ms",
+           i + 1, res.lag, (long long)offset, delay, delay * dt * 1e9,
+           res.coefficient, res.usedFft ? "fft" : "direct", ms);
+    if (sim) {
+      printf(", expected %.4f", simDelays[i] - simDelays[0]);
+    }
+    printf("\n");
+  }
+  return 0;
+}
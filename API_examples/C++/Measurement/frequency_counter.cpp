@@ -0,0 +1,331 @@
+/* Red Pitaya C++ API example Reciprocal frequency counter
+ * This application measures frequency, period jitter, pulse widths and duty
+ * cycle on IN1 by timestamping every edge of the capture.
+ *
+ * By default one 16k buffer is evaluated. With -x the given number of
+ * samples is captured through AXI and streamed through the counter in
+ * chunks, so long periods and long gate times can be measured. With -s a
+ * simulated stream is used, -b measures the counter throughput. Thresholds
+ * are set with -l/-u or derived from the first chunk with -H hysteresis. */
+
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/counter.h"
+#include "common/timing.h"
+#include "rp.h"
+#include "rp_hw-profiles.h"
+
+#define CHUNK_SIZE 16384
+
+struct Thresholds {
+  float low = 0;
+  float high = 0;
+  bool set = false;
+  float hysteresis = 0.2;
+};
+
+/* Feeds one chunk, creating the counter from the first chunk if needed */
+auto feed(EdgeCounter **counter, Thresholds *thr, double sampleRate,
+          const float *x, uint32_t n) -> bool {
+  if (!*counter) {
+    if (!thr->set &&
+        !counterThresholds(x, n, thr->hysteresis, &thr->low, &thr->high)) {
+      fprintf(stderr, "Signal is flat, no thresholds\n");
+      return false;
+    }
+    *counter = new EdgeCounter(sampleRate, thr->low, thr->high);
+  }
+  (*counter)->process(x, n);
+  return true;
+}
+
+auto captureBlock(EdgeCounter **counter, Thresholds *thr, double sampleRate,
+                  uint32_t decimation) -> bool {
+  rp_AcqReset();
+  rp_AcqSetDecimationFactor(decimation);
+  rp_AcqSetTriggerDelay(ADC_BUFFER_SIZE / 2);
+  rp_AcqStart();
+  rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+  rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+  while (state != RP_TRIG_STATE_TRIGGERED) {
+    rp_AcqGetTriggerState(&state);
+  }
+  bool fillState = false;
+  while (!fillState) {
+    rp_AcqGetBufferFillState(&fillState);
+  }
+  rp_AcqStop();
+
+  uint32_t pos = 0;
+  rp_AcqGetWritePointerAtTrig(&pos);
+  std::vector<float> buff(ADC_BUFFER_SIZE);
+  uint32_t size = ADC_BUFFER_SIZE;
+  if (rp_AcqGetDataV(RP_CH_1, pos, &size, buff.data()) != RP_OK) {
+    fprintf(stderr, "rp_AcqGetDataV failed!\n");
+    return false;
+  }
+  return feed(counter, thr, sampleRate, buff.data(), size);
+}
+
+auto captureAxi(EdgeCounter **counter, Thresholds *thr, double sampleRate,
+                uint32_t decimation, uint32_t samples) -> bool {
+  uint32_t start, size;
+  rp_AcqAxiGetMemoryRegion(&start, &size);
+  if (samples * sizeof(int16_t) > size) {
+    samples = size / sizeof(int16_t);
+  }
+  if (rp_AcqAxiSetDecimationFactor(decimation) != RP_OK ||
+      rp_AcqAxiSetTriggerDelay(RP_CH_1, samples) != RP_OK ||
+      rp_AcqAxiSetBufferSamples(RP_CH_1, start, samples) != RP_OK ||
+      rp_AcqAxiEnable(RP_CH_1, true) != RP_OK) {
+    fprintf(stderr, "AXI setup failed!\n");
+    return false;
+  }
+  rp_AcqStart();
+  rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+  bool fillState = false;
+  while (!fillState) {
+    rp_AcqAxiGetBufferFillState(RP_CH_1, &fillState);
+  }
+  rp_AcqStop();
+
+  uint32_t pos = 0;
+  rp_AcqAxiGetWritePointerAtTrig(RP_CH_1, &pos);
+  std::vector<float> chunk(CHUNK_SIZE);
+  bool ok = true;
+  for (uint32_t done = 0; ok && done < samples;) {
+    uint32_t n = samples - done < CHUNK_SIZE ? samples - done : CHUNK_SIZE;
+    if (rp_AcqAxiGetDataV(RP_CH_1, pos, &n, chunk.data()) != RP_OK) {
+      fprintf(stderr, "rp_AcqAxiGetDataV failed!\n");
+      ok = false;
+      break;
+    }
+    ok = feed(counter, thr, sampleRate, chunk.data(), n);
+    pos += n;
+    done += n;
+  }
+  rp_AcqAxiEnable(RP_CH_1, false);
+  return ok;
+}
+
+/* Pulse train with finite edges, noise and random period jitter */
+class SimSource {
+public:
+  SimSource(double sampleRate, double freq, double duty, double jitter)
+      : m_rate(sampleRate), m_freq(freq), m_jitter(jitter),
+        m_level(cos(M_PI * duty)), m_noise(0, 0.01f) {
+    newPeriod();
+  }
+
+  auto fill(float *x, uint32_t n) -> void {
+    for (uint32_t i = 0; i < n; i++) {
+      x[i] = (float)tanh(8 * (sin(m_phase) - m_level)) + m_noise(m_rng);
+      m_phase += m_step;
+      if (m_phase >= 2 * M_PI) {
+        m_phase -= 2 * M_PI;
+        newPeriod();
+      }
+    }
+  }
+
+private:
+  auto newPeriod() -> void {
+    std::normal_distribution<double> jitter(0, m_jitter);
+    double period = 1.0 / m_freq + jitter(m_rng);
+    m_step = 2 * M_PI / (period * m_rate);
+  }
+
+  double m_rate;
+  double m_freq;
+  double m_jitter;
+  double m_level;
+  double m_phase = 0;
+  double m_step = 0;
+  std::minstd_rand m_rng;
+  std::normal_distribution<float> m_noise;
+};
+
+/* Same state machine evaluated on every sample, for comparison */
+auto perSampleCount(const float *x, uint32_t n, float low, float high)
+    -> uint32_t {
+  uint32_t edges = 0;
+  int level = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    if (level <= 0 && x[i] >= high) {
+      edges += level < 0;
+      level = 1;
+    } else if (level >= 0 && x[i] <= low) {
+      level = -1;
+    }
+  }
+  return edges;
+}
+
+auto benchmark(double sampleRate, uint32_t samples) -> void {
+  std::vector<float> x(samples);
+  for (double freq : {1e3, 1e5, 5e6}) {
+    SimSource src(sampleRate, freq, 0.5, 0);
+    src.fill(x.data(), samples);
+
+    EdgeCounter counter(sampleRate, -0.2f, 0.2f);
+    int64_t t = nowNs();
+    for (uint32_t done = 0; done < samples; done += CHUNK_SIZE) {
+      uint32_t n = samples - done < CHUNK_SIZE ? samples - done : CHUNK_SIZE;
+      counter.process(x.data() + done, n);
+    }
+    double counterMs = elapsedMs(t);
+
+    t = nowNs();
+    volatile uint32_t edges = perSampleCount(x.data(), samples, -0.2f, 0.2f);
+    double scanMs = elapsedMs(t);
+    (void)edges;
+
+    printf("%10.0f Hz: counter %.1f Msamples/s, per-sample scan %.1f "
+           "Msamples/s, stream rate %.1f Msamples/s\n",
+           freq, samples / counterMs / 1000.0, samples / scanMs / 1000.0,
+           sampleRate / 1e6);
+  }
+}
+
+auto printStats(const char *name, const RunningStats &s) -> void {
+  printf("%-8s mean %.9g s, std %.3g s, min %.9g s, max %.9g s (%llu)\n",
+         name, s.mean, s.stddev(), s.min, s.max, (unsigned long long)s.count);
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-d decimation] [-x samples] [-l low -u high] "
+          "[-H hysteresis] [-s] [-f freq] [-j jitter] [-n samples] [-b]\n"
+          "\t-d : Decimation (default 1)\n"
+          "\t-x : Stream the given number of samples through AXI\n"
+          "\t-l : Low threshold in volts\n"
+          "\t-u : High threshold in volts\n"
+          "\t-H : Hysteresis as a fraction of the half range when the "
+          "thresholds are derived from the signal (default 0.2)\n"
+          "\t-s : Use a simulated pulse train\n"
+          "\t-f : Simulated frequency (default 12345.678 Hz)\n"
+          "\t-j : Simulated RMS period jitter in seconds (default 1e-9)\n"
+          "\t-n : Simulated samples (default 16M)\n"
+          "\t-b : Benchmark the counter throughput\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  Thresholds thr;
+  uint32_t decimation = 1;
+  uint32_t axiSamples = 0;
+  uint32_t simSamples = 16 * 1024 * 1024;
+  double simFreq = 12345.678;
+  double simJitter = 1e-9;
+  bool sim = false;
+  bool bench = false;
+  bool lowSet = false, highSet = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:x:l:u:H:sf:j:n:bh")) != -1) {
+    switch (opt) {
+    case 'd':
+      decimation = atoi(optarg);
+      break;
+    case 'x':
+      axiSamples = atoi(optarg);
+      break;
+    case 'l':
+      thr.low = atof(optarg);
+      lowSet = true;
+      break;
+    case 'u':
+      thr.high = atof(optarg);
+      highSet = true;
+      break;
+    case 'H':
+      thr.hysteresis = atof(optarg);
+      break;
+    case 's':
+      sim = true;
+      break;
+    case 'f':
+      simFreq = atof(optarg);
+      break;
+    case 'j':
+      simJitter = atof(optarg);
+      break;
+    case 'n':
+      simSamples = atoi(optarg);
+      break;
+    case 'b':
+      bench = true;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  if (lowSet != highSet || (lowSet && thr.low >= thr.high)) {
+    fprintf(stderr, "Both -l and -u are needed, with -l below -u\n");
+    return 1;
+  }
+  thr.set = lowSet;
+
+  double sampleRate = 125e6 / decimation;
+  if (!sim && !bench) {
+    if (rp_Init() != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return 1;
+    }
+    sampleRate = rp_HPGetBaseFastADCSpeedHzOrDefault() / (double)decimation;
+  }
+
+  if (bench) {
+    benchmark(sampleRate, simSamples);
+    return 0;
+  }
+
+  EdgeCounter *counter = NULL;
+  bool ok = true;
+  int64_t t = nowNs();
+  if (sim) {
+    SimSource src(sampleRate, simFreq, 0.3, simJitter);
+    std::vector<float> chunk(CHUNK_SIZE);
+    for (uint32_t done = 0; ok && done < simSamples; done += CHUNK_SIZE) {
+      uint32_t n = simSamples - done < CHUNK_SIZE ? simSamples - done
+                                                  : CHUNK_SIZE;
+      src.fill(chunk.data(), n);
+      ok = feed(&counter, &thr, sampleRate, chunk.data(), n);
+    }
+  } else {
+    ok = axiSamples
+             ? captureAxi(&counter, &thr, sampleRate, decimation, axiSamples)
+             : captureBlock(&counter, &thr, sampleRate, decimation);
+    rp_Release();
+  }
+  double ms = elapsedMs(t);
+  if (!ok || !counter) {
+    delete counter;
+    return 1;
+  }
+
+  CounterResult r = counter->result();
+  delete counter;
+  printf("%llu samples at %.1f Hz in %.1f ms, thresholds %.4f / %.4f V\n",
+         (unsigned long long)r.samples, sampleRate, ms, thr.low, thr.high);
+  printf("Edges    %llu rising, %llu falling\n",
+         (unsigned long long)r.risingEdges,
+         (unsigned long long)r.fallingEdges);
+  if (r.frequency == 0) {
+    printf("Less than one full period captured\n");
+    return 2;
+  }
+  printf("Frequency %.6f Hz\n", r.frequency);
+  printStats("Period", r.period);
+  printStats("High", r.high);
+  printStats("Low", r.low);
+  printf("Duty     %.3f %%\n", r.duty * 100);
+  return 0;
+}
@@ -0,0 +1,216 @@
+/* Red Pitaya C++ API example Frequency response (Bode) sweep
+ * This application steps OUT1 through a frequency sweep and measures the
+ * transfer function IN2/IN1 of a device connected between OUT1 and IN2
+ * (OUT1 is also looped back to IN1 as the reference).
+ *
+ * Decimation and capture length follow the frequency and each point is
+ * captured until successive estimates agree. Run with -s to sweep a simulated
+ * RC low-pass instead of the hardware. */
+
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/fra.h"
+#include "rp.h"
+#include "rp_hw-profiles.h"
+
+class RpFraBackend : public FraBackend {
+public:
+  auto init(float amplitude) -> bool {
+    if (rp_Init() != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return false;
+    }
+    rp_GenReset();
+    rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+    rp_GenAmp(RP_CH_1, amplitude);
+    rp_GenFreq(RP_CH_1, 1000);
+    rp_GenOutEnable(RP_CH_1);
+    rp_GenTriggerOnly(RP_CH_1);
+
+    rp_AcqReset();
+    rp_AcqSetTriggerDelay(ADC_BUFFER_SIZE / 2);
+    return true;
+  }
+
+  auto release() -> void {
+    rp_GenOutDisable(RP_CH_1);
+    rp_Release();
+  }
+
+  auto adcRate() -> double override {
+    uint32_t rate = 0;
+    if (rp_HPGetBaseFastADCSpeedHz(&rate) != RP_HP_OK) {
+      fprintf(stderr, "[Error] Can't get fast ADC rate\n");
+      return 125e6;
+    }
+    return rate;
+  }
+
+  auto setFrequency(double hz) -> bool override {
+    return rp_GenFreq(RP_CH_1, (float)hz) == RP_OK;
+  }
+
+  auto capture(uint32_t decimation, uint32_t samples, float *in, float *out)
+      -> bool override {
+    if (rp_AcqSetDecimationFactor(decimation) != RP_OK) {
+      fprintf(stderr, "rp_AcqSetDecimationFactor failed!\n");
+      return false;
+    }
+    if (rp_AcqStart() != RP_OK) {
+      return false;
+    }
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+    rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+    while (state != RP_TRIG_STATE_TRIGGERED) {
+      rp_AcqGetTriggerState(&state);
+    }
+    bool fillState = false;
+    while (!fillState) {
+      rp_AcqGetBufferFillState(&fillState);
+    }
+    rp_AcqStop();
+
+    uint32_t pos = 0;
+    rp_AcqGetWritePointerAtTrig(&pos);
+    uint32_t size1 = samples;
+    uint32_t size2 = samples;
+    if (rp_AcqGetDataV(RP_CH_1, pos, &size1, in) != RP_OK ||
+        rp_AcqGetDataV(RP_CH_2, pos, &size2, out) != RP_OK) {
+      fprintf(stderr, "rp_AcqGetDataV failed!\n");
+      return false;
+    }
+    return size1 == samples && size2 == samples;
+  }
+};
+
+/* First order RC low-pass with a decaying start-up transient after every
+ * frequency change. Captures and generator changes take real time. */
+class SimFraBackend : public FraBackend {
+public:
+  SimFraBackend(double cutoffHz, double noise)
+      : m_cutoff(cutoffHz), m_noise(0, noise) {}
+
+  auto adcRate() -> double override { return 125e6; }
+
+  auto setFrequency(double hz) -> bool override {
+    usleep(2000);
+    m_freq = hz;
+    m_sinceChange = 0;
+    return true;
+  }
+
+  auto capture(uint32_t decimation, uint32_t samples, float *in, float *out)
+      -> bool override {
+    double dt = decimation / adcRate();
+    double w = 2 * M_PI * m_freq;
+    double x = m_freq / m_cutoff;
+    double gain = 1.0 / sqrt(1 + x * x);
+    double shift = -atan(x);
+    double tau = 1.0 / (2 * M_PI * m_cutoff);
+    double phase0 = 2 * M_PI * (m_rng() % 1000) / 1000.0;
+
+    for (uint32_t i = 0; i < samples; i++) {
+      double t = i * dt;
+      double transient = 0.3 * exp(-(m_sinceChange + t) / tau);
+      in[i] = (float)(cos(w * t + phase0) + m_noise(m_rng));
+      out[i] = (float)(gain * cos(w * t + phase0 + shift) + transient +
+                       m_noise(m_rng));
+    }
+    /* Acquisition always fills the whole buffer */
+    double duration = ADC_BUFFER_SIZE * dt;
+    m_sinceChange += duration;
+    usleep((useconds_t)(duration * 1e6));
+    return true;
+  }
+
+private:
+  double m_cutoff;
+  double m_freq = 1000;
+  double m_sinceChange = 0;
+  std::minstd_rand m_rng;
+  std::normal_distribution<double> m_noise;
+};
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-s] [-f start_hz] [-t stop_hz] [-n points] [-l]\n"
+          "\t-s : Use a simulated RC low-pass (fc = 10 kHz)\n"
+          "\t-f : Start frequency (default 100 Hz)\n"
+          "\t-t : Stop frequency (default 1 MHz)\n"
+          "\t-n : Number of points (default 50)\n"
+          "\t-l : Linear frequency steps\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  FraSettings settings;
+  bool simulate = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "sf:t:n:lh")) != -1) {
+    switch (opt) {
+    case 's':
+      simulate = true;
+      break;
+    case 'f':
+      settings.startHz = atof(optarg);
+      break;
+    case 't':
+      settings.stopHz = atof(optarg);
+      break;
+    case 'n':
+      settings.points = atoi(optarg);
+      break;
+    case 'l':
+      settings.logScale = false;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+
+  RpFraBackend rpBackend;
+  SimFraBackend simBackend(10000, 0.002);
+  FraBackend *backend = &simBackend;
+  if (!simulate) {
+    if (!rpBackend.init(0.5)) {
+      return 1;
+    }
+    backend = &rpBackend;
+  }
+
+  Fra fra(backend, settings);
+  std::vector<FraPoint> points;
+  FraStats stats;
+  bool ok = fra.run(&points, &stats);
+
+  printf("%12s %6s %6s %4s %10s %10s %9s %8s %8s %8s\n", "freq[Hz]", "dec",
+         "size", "cap", "mag[dB]", "phase[deg]", "coherence", "setup", "capt",
+         "proc");
+  for (auto &p : points) {
+    printf("%12.2f %6u %6u %4u %10.3f %10.2f %9.5f %8.2f %8.2f %8.3f%s\n",
+           p.freq, p.decimation, p.samples, p.captures, p.magnitudeDb,
+           p.phaseDeg, p.coherence, p.setupMs, p.captureMs, p.processMs,
+           p.settled ? "" : " (not settled)");
+  }
+  printf("\nSweep time %.1f ms (%zu points, %u captures)\n", stats.totalMs,
+         points.size(), stats.captures);
+  printf("\tgenerator setup %.1f ms\n", stats.setupMs);
+  printf("\tcapture %.1f ms, processing %.1f ms\n", stats.captureMs,
+         stats.processMs);
+
+  if (!simulate) {
+    rpBackend.release();
+  }
+  if (!ok) {
+    fprintf(stderr, "Sweep failed!\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,272 @@
+/* Red Pitaya C++ API example LCR meter
+ * This application measures the impedance of a device connected in series
+ * with a shunt resistor: OUT1 -> DUT -> shunt -> GND, IN1 at OUT1 and IN2
+ * across the shunt. It prints |Z|, phase, the series/parallel equivalent
+ * L, C, R and the D/Q factors.
+ *
+ * With -c the engine runs continuously and an averaged reading is printed
+ * twice a second. With -s a simulated R-C device is used instead of the
+ * hardware, -b benchmarks readings per second against it. */
+
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/lcr.h"
+#include "common/timing.h"
+#include "rp.h"
+#include "rp_hw-profiles.h"
+
+class RpLcrBackend : public LcrBackend {
+public:
+  auto init() -> bool {
+    if (rp_Init() != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return false;
+    }
+    rp_AcqReset();
+    rp_AcqSetTriggerDelay(ADC_BUFFER_SIZE / 2);
+    return true;
+  }
+
+  auto release() -> void {
+    rp_GenOutDisable(RP_CH_1);
+    rp_Release();
+  }
+
+  auto adcRate() -> double override {
+    uint32_t rate = 0;
+    if (rp_HPGetBaseFastADCSpeedHz(&rate) != RP_HP_OK) {
+      fprintf(stderr, "[Error] Can't get fast ADC rate\n");
+      return 125e6;
+    }
+    return rate;
+  }
+
+  auto setStimulus(double hz, double amplitude) -> bool override {
+    int ret = RP_OK;
+    ret |= rp_GenReset();
+    ret |= rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+    ret |= rp_GenFreq(RP_CH_1, (float)hz);
+    ret |= rp_GenAmp(RP_CH_1, (float)amplitude);
+    ret |= rp_GenOutEnable(RP_CH_1);
+    ret |= rp_GenTriggerOnly(RP_CH_1);
+    /* Let the DUT settle before the first capture */
+    usleep(10000);
+    return ret == RP_OK;
+  }
+
+  auto capture(uint32_t decimation, uint32_t samples, float *v1, float *v2)
+      -> bool override {
+    if (rp_AcqSetDecimationFactor(decimation) != RP_OK ||
+        rp_AcqStart() != RP_OK) {
+      return false;
+    }
+    rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+    rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+    while (state != RP_TRIG_STATE_TRIGGERED) {
+      rp_AcqGetTriggerState(&state);
+    }
+    bool fillState = false;
+    while (!fillState) {
+      rp_AcqGetBufferFillState(&fillState);
+    }
+    rp_AcqStop();
+
+    uint32_t pos = 0;
+    rp_AcqGetWritePointerAtTrig(&pos);
+    uint32_t size1 = samples;
+    uint32_t size2 = samples;
+    if (rp_AcqGetDataV(RP_CH_1, pos, &size1, v1) != RP_OK ||
+        rp_AcqGetDataV(RP_CH_2, pos, &size2, v2) != RP_OK) {
+      fprintf(stderr, "rp_AcqGetDataV failed!\n");
+      return false;
+    }
+    return size1 == samples && size2 == samples;
+  }
+};
+
+/* Series R-C device under test. The signals are computed once per stimulus
+ * so that the benchmark measures the engine and not the simulator. */
+class SimLcrBackend : public LcrBackend {
+public:
+  SimLcrBackend(double r, double c, double shunt, bool realTime)
+      : m_r(r), m_c(c), m_shunt(shunt), m_realTime(realTime) {}
+
+  auto adcRate() -> double override { return 125e6; }
+
+  auto setStimulus(double hz, double amplitude) -> bool override {
+    m_freq = hz;
+    m_amplitude = amplitude;
+    m_v1.clear();
+    m_v2.clear();
+    return true;
+  }
+
+  auto capture(uint32_t decimation, uint32_t samples, float *v1, float *v2)
+      -> bool override {
+    double dt = decimation / adcRate();
+    if (m_v1.size() != samples) {
+      double w = 2 * M_PI * m_freq;
+      /* I = V1 / (R + 1/jwC + Rshunt), V2 = I * Rshunt */
+      double zr = m_r + m_shunt;
+      double zi = -1.0 / (w * m_c);
+      double gain = m_shunt / hypot(zr, zi);
+      double shift = -atan2(zi, zr);
+      std::minstd_rand rng;
+      std::normal_distribution<double> noise(0, 0.001);
+      m_v1.resize(samples);
+      m_v2.resize(samples);
+      for (uint32_t i = 0; i < samples; i++) {
+        double t = i * dt;
+        m_v1[i] = (float)(m_amplitude * cos(w * t) + noise(rng));
+        m_v2[i] =
+            (float)(m_amplitude * gain * cos(w * t + shift) + noise(rng));
+      }
+    }
+    memcpy(v1, m_v1.data(), samples * sizeof(float));
+    memcpy(v2, m_v2.data(), samples * sizeof(float));
+    if (m_realTime) {
+      usleep((useconds_t)(ADC_BUFFER_SIZE * dt * 1e6));
+    }
+    return true;
+  }
+
+private:
+  double m_r;
+  double m_c;
+  double m_shunt;
+  bool m_realTime;
+  double m_freq = 1000;
+  double m_amplitude = 0.5;
+  std::vector<float> m_v1;
+  std::vector<float> m_v2;
+};
+
+void printReading(const LcrReading &r, LcrCircuit circuit) {
+  printf("f=%.1f Hz |Z|=%.4g Ohm phase=%.3f deg", r.freq, r.z, r.phaseDeg);
+  if (circuit == LcrCircuit::SERIES) {
+    printf(" Rs=%.4g Ohm Ls=%.4g H Cs=%.4g F", r.rs, r.ls, r.cs);
+  } else {
+    printf(" Rp=%.4g Ohm Lp=%.4g H Cp=%.4g F", r.rp, r.lp, r.cp);
+  }
+  printf(" D=%.4g Q=%.4g\n", r.d, r.q);
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-f freq] [-a amplitude] [-r shunt] [-p] [-n avg] "
+          "[-c seconds] [-s] [-b seconds]\n"
+          "\t-f : Stimulus frequency (default 1000 Hz)\n"
+          "\t-a : Stimulus amplitude (default 0.5 V)\n"
+          "\t-r : Shunt resistor (default 1000 Ohm)\n"
+          "\t-p : Report the parallel equivalent circuit\n"
+          "\t-n : Readings averaged in continuous mode (default 10)\n"
+          "\t-c : Run continuously for the given time\n"
+          "\t-s : Use a simulated series R-C (100 Ohm, 1 uF)\n"
+          "\t-b : Benchmark readings per second against the simulation\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  LcrSettings settings;
+  bool simulate = false;
+  double continuous = 0;
+  double benchmark = 0;
+  uint32_t averaging = 10;
+  int opt;
+  while ((opt = getopt(argc, argv, "f:a:r:pn:c:sb:h")) != -1) {
+    switch (opt) {
+    case 'f':
+      settings.freq = atof(optarg);
+      break;
+    case 'a':
+      settings.amplitude = atof(optarg);
+      break;
+    case 'r':
+      settings.shuntOhm = atof(optarg);
+      break;
+    case 'p':
+      settings.circuit = LcrCircuit::PARALLEL;
+      break;
+    case 'n':
+      averaging = atoi(optarg);
+      break;
+    case 'c':
+      continuous = atof(optarg);
+      break;
+    case 's':
+      simulate = true;
+      break;
+    case 'b':
+      simulate = true;
+      benchmark = atof(optarg);
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+
+  RpLcrBackend rpBackend;
+  SimLcrBackend simBackend(100, 1e-6, settings.shuntOhm, benchmark == 0);
+  LcrBackend *backend = &simBackend;
+  if (!simulate) {
+    if (!rpBackend.init()) {
+      return 1;
+    }
+    backend = &rpBackend;
+  }
+
+  LcrEngine engine(backend, settings);
+  int ret = 0;
+
+  if (continuous == 0 && benchmark == 0) {
+    LcrReading reading;
+    if (engine.measure(&reading)) {
+      printReading(reading, settings.circuit);
+    } else {
+      fprintf(stderr, "Measurement failed!\n");
+      ret = 1;
+    }
+  } else {
+    double duration = benchmark > 0 ? benchmark : continuous;
+    int64_t start = nowNs();
+    if (!engine.start()) {
+      fprintf(stderr, "Can't start the LCR engine!\n");
+      ret = 1;
+    }
+    while (engine.isRunning() && elapsedMs(start) < duration * 1000) {
+      usleep(500000);
+      LcrReading reading;
+      if (benchmark == 0 && engine.average(averaging, &reading)) {
+        printReading(reading, settings.circuit);
+      }
+    }
+    engine.stop();
+    double seconds = elapsedMs(start) / 1000.0;
+    uint64_t count = engine.readings();
+    if (engine.failed()) {
+      fprintf(stderr, "Capture failed!\n");
+      ret = 1;
+    }
+
+    LcrReading reading;
+    if (engine.average(averaging, &reading)) {
+      printf("Average of last %u readings:\n\t", averaging);
+      printReading(reading, settings.circuit);
+    }
+    printf("%llu readings in %.2f s, %.1f readings/s\n",
+           (unsigned long long)count, seconds, count / seconds);
+  }
+
+  if (!simulate) {
+    rpBackend.release();
+  }
+  return ret;
+}
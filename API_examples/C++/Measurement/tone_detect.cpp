@@ -0,0 +1,275 @@
+/* Red Pitaya C++ API example Multi-tone presence check
+ * This application checks a set of tones on IN1 with a Goertzel filter bank:
+ * every tone listed with -t must be present above the level given with -l
+ * and every tone listed with -r must stay below it. The exit code is 0 when
+ * the check passes and 2 when it fails, for use on test stations.
+ *
+ * By default one 16k buffer is evaluated (rp_AcqGetDataRaw). With -x the
+ * given number of samples is captured through AXI and streamed through the
+ * bank in chunks. With -s a simulated stream is used, -b compares the bank
+ * against one Goertzel loop per tone. */
+
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "common/goertzel.h"
+#include "common/timing.h"
+#include "rp.h"
+#include "rp_hw-profiles.h"
+
+#define CHUNK_SIZE 16384
+
+struct Tone {
+  double freq;
+  bool expected;
+};
+
+auto parseTones(const char *list, bool expected, std::vector<Tone> *tones)
+    -> void {
+  char *copy = strdup(list);
+  for (char *tok = strtok(copy, ","); tok; tok = strtok(NULL, ",")) {
+    tones->push_back({atof(tok), expected});
+  }
+  free(copy);
+}
+
+auto voltsPerCode() -> double {
+  uint8_t bits = 14;
+  rp_HPGetFastADCBits(&bits);
+  /* LV range, +-1 V full scale */
+  return 1.0 / (1 << (bits - 1));
+}
+
+auto captureBlock(GoertzelBank *bank, uint32_t decimation) -> bool {
+  rp_AcqReset();
+  rp_AcqSetDecimationFactor(decimation);
+  rp_AcqSetTriggerDelay(ADC_BUFFER_SIZE / 2);
+  rp_AcqStart();
+  rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+  rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+  while (state != RP_TRIG_STATE_TRIGGERED) {
+    rp_AcqGetTriggerState(&state);
+  }
+  bool fillState = false;
+  while (!fillState) {
+    rp_AcqGetBufferFillState(&fillState);
+  }
+  rp_AcqStop();
+
+  uint32_t pos = 0;
+  rp_AcqGetWritePointerAtTrig(&pos);
+  std::vector<int16_t> buff(ADC_BUFFER_SIZE);
+  uint32_t size = ADC_BUFFER_SIZE;
+  if (rp_AcqGetDataRaw(RP_CH_1, pos, &size, buff.data()) != RP_OK) {
+    fprintf(stderr, "rp_AcqGetDataRaw failed!\n");
+    return false;
+  }
+  bank->process(buff.data(), size);
+  return true;
+}
+
+auto captureAxi(GoertzelBank *bank, uint32_t decimation, uint32_t samples)
+    -> bool {
+  uint32_t start, size;
+  rp_AcqAxiGetMemoryRegion(&start, &size);
+  if (samples * sizeof(int16_t) > size) {
+    samples = size / sizeof(int16_t);
+  }
+  if (rp_AcqAxiSetDecimationFactor(decimation) != RP_OK ||
+      rp_AcqAxiSetTriggerDelay(RP_CH_1, samples) != RP_OK ||
+      rp_AcqAxiSetBufferSamples(RP_CH_1, start, samples) != RP_OK ||
+      rp_AcqAxiEnable(RP_CH_1, true) != RP_OK) {
+    fprintf(stderr, "AXI setup failed!\n");
+    return false;
+  }
+  rp_AcqStart();
+  rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+
+  bool fillState = false;
+  while (!fillState) {
+    rp_AcqAxiGetBufferFillState(RP_CH_1, &fillState);
+  }
+  rp_AcqStop();
+
+  uint32_t pos = 0;
+  rp_AcqAxiGetWritePointerAtTrig(RP_CH_1, &pos);
+  std::vector<int16_t> chunk(CHUNK_SIZE);
+  for (uint32_t done = 0; done < samples;) {
+    uint32_t n = samples - done < CHUNK_SIZE ? samples - done : CHUNK_SIZE;
+    if (rp_AcqAxiGetDataRaw(RP_CH_1, pos, &n, chunk.data()) != RP_OK) {
+      fprintf(stderr, "rp_AcqAxiGetDataRaw failed!\n");
+      rp_AcqAxiEnable(RP_CH_1, false);
+      return false;
+    }
+    bank->process(chunk.data(), n);
+    pos = (pos + n) % samples;
+    done += n;
+  }
+  rp_AcqAxiEnable(RP_CH_1, false);
+  return true;
+}
+
+/* Tones at the frequencies marked as expected, amplitude 0.2 V, plus noise */
+auto simulate(GoertzelBank *bank, const std::vector<Tone> &tones,
+              double sampleRate, uint32_t samples) -> void {
+  std::minstd_rand rng;
+  std::normal_distribution<float> noise(0, 0.05f);
+  std::vector<float> chunk(CHUNK_SIZE);
+  for (uint32_t done = 0; done < samples; done += CHUNK_SIZE) {
+    uint32_t n = samples - done < CHUNK_SIZE ? samples - done : CHUNK_SIZE;
+    for (uint32_t i = 0; i < n; i++) {
+      double t = (done + i) / sampleRate;
+      float v = noise(rng);
+      for (auto &tone : tones) {
+        if (tone.expected) {
+          v += 0.2f * (float)sin(2 * M_PI * tone.freq * t);
+        }
+      }
+      chunk[i] = v;
+    }
+    bank->process(chunk.data(), n);
+  }
+}
+
+/* Bank versus a separate Goertzel pass per tone over the same buffer */
+auto benchmark(const std::vector<double> &norm, uint32_t samples) -> void {
+  std::vector<float> x(samples);
+  std::minstd_rand rng;
+  std::uniform_real_distribution<float> dist(-1, 1);
+  for (auto &v : x) {
+    v = dist(rng);
+  }
+
+  GoertzelBank bank(norm);
+  int64_t t = nowNs();
+  bank.process(x.data(), samples);
+  double bankMs = elapsedMs(t);
+
+  volatile double sink = 0;
+  t = nowNs();
+  for (double f : norm) {
+    double c = 2 * cos(2 * M_PI * f);
+    double s1 = 0, s2 = 0;
+    for (uint32_t i = 0; i < samples; i++) {
+      double s0 = x[i] + c * s1 - s2;
+      s2 = s1;
+      s1 = s0;
+    }
+    sink = sink + s1 * s1 + s2 * s2 - c * s1 * s2;
+  }
+  double loopMs = elapsedMs(t);
+
+  printf("%zu tones x %u samples: bank %.2f ms (%.1f Msamples/s), "
+         "per-tone loops %.2f ms (%.1fx)\n",
+         norm.size(), samples, bankMs, samples / bankMs / 1000.0, loopMs,
+         loopMs / bankMs);
+}
+
+void printHelp(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s -t freqs [-r freqs] [-l level] [-d decimation] "
+          "[-x samples] [-s] [-b]\n"
+          "\t-t : Comma separated tones that must be present (Hz)\n"
+          "\t-r : Comma separated tones that must be absent (Hz)\n"
+          "\t-l : Detection level in volts (default 0.05)\n"
+          "\t-d : Decimation (default 8)\n"
+          "\t-x : Stream the given number of samples through AXI\n"
+          "\t-s : Use a simulated signal with the -t tones\n"
+          "\t-b : Benchmark the bank against per-tone loops\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  std::vector<Tone> tones;
+  double level = 0.05;
+  uint32_t decimation = 8;
+  uint32_t axiSamples = 0;
+  bool sim = false;
+  bool bench = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:r:l:d:x:sbh")) != -1) {
+    switch (opt) {
+    case 't':
+      parseTones(optarg, true, &tones);
+      break;
+    case 'r':
+      parseTones(optarg, false, &tones);
+      break;
+    case 'l':
+      level = atof(optarg);
+      break;
+    case 'd':
+      decimation = atoi(optarg);
+      break;
+    case 'x':
+      axiSamples = atoi(optarg);
+      break;
+    case 's':
+      sim = true;
+      break;
+    case 'b':
+      bench = true;
+      break;
+    default:
+      printHelp(argv[0]);
+      return 1;
+    }
+  }
+  if (tones.empty()) {
+    printHelp(argv[0]);
+    return 1;
+  }
+
+  double sampleRate = 125e6 / decimation;
+  if (!sim && !bench) {
+    if (rp_Init() != RP_OK) {
+      fprintf(stderr, "Rp api init failed!\n");
+      return 1;
+    }
+    sampleRate = rp_HPGetBaseFastADCSpeedHzOrDefault() / (double)decimation;
+  }
+
+  std::vector<double> norm;
+  for (auto &tone : tones) {
+    norm.push_back(tone.freq / sampleRate);
+  }
+
+  if (bench) {
+    benchmark(norm, 1 << 20);
+    return 0;
+  }
+
+  GoertzelBank bank(norm);
+  double scale = 1.0;
+  bool ok = true;
+  if (sim) {
+    simulate(&bank, tones, sampleRate, axiSamples ? axiSamples : 1 << 20);
+  } else {
+    scale = voltsPerCode();
+    ok = axiSamples ? captureAxi(&bank, decimation, axiSamples)
+                    : captureBlock(&bank, decimation);
+    rp_Release();
+  }
+  if (!ok) {
+    return 1;
+  }
+
+  bool pass = true;
+  printf("%u samples at %.1f Hz\n", (uint32_t)bank.samples(), sampleRate);
+  for (uint32_t t = 0; t < bank.tones(); t++) {
+    double amp = bank.amplitude(t) * scale;
+    bool present = amp >= level;
+    bool good = present == tones[t].expected;
+    pass = pass && good;
+    printf("\t%12.2f Hz %8.4f V %-7s %s\n", tones[t].freq, amp,
+           present ? "present" : "absent", good ? "OK" : "FAIL");
+  }
+  printf("%s\n", pass ? "PASS" : "FAIL");
+  return pass ? 0 : 2;
+}
@@ -0,0 +1,183 @@
+/* Red Pitaya C++ examples - timeline burst sequencer */
+
+#include "burst_sequencer.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <thread>
+#include <time.h>
+
+#include "realtime.h"
+#include "timing.h"
+
+namespace {
+
+/* Poll interval of waits on the other thread */
+constexpr int64_t POLL_NS = 100000;
+/* Longest single sleep, so stop() is noticed */
+constexpr int64_t MAX_SLEEP_NS = 50000000;
+
+auto sleepUntil(int64_t ns) -> void {
+  struct timespec ts;
+  ts.tv_sec = ns / 1000000000LL;
+  ts.tv_nsec = ns % 1000000000LL;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+         EINTR) {
+  }
+}
+
+auto toNs(double seconds) -> int64_t { return (int64_t)(seconds * 1e9); }
+
+} // namespace
+
+auto burstDuration(const BurstParams &p) -> double {
+  double burst = p.frequency > 0 ? p.count / p.frequency : 0;
+  double period = p.period * 1e-6;
+  return p.repetitions * (period > burst ? period : burst);
+}
+
+BurstSequencer::BurstSequencer(BurstBackend *backend,
+                               const BurstSequencerSettings &settings)
+    : m_backend(backend), m_settings(settings) {}
+
+auto BurstSequencer::run(std::vector<BurstEvent> events) -> bool {
+  std::stable_sort(events.begin(), events.end(),
+                   [](const BurstEvent &a, const BurstEvent &b) {
+                     return a.time < b.time;
+                   });
+  m_events = std::move(events);
+  m_fireNs.assign(m_events.size(), 0);
+  m_staged = 0;
+  m_fired = 0;
+  m_stop = false;
+  m_failed = false;
+  m_stageFailures = 0;
+  m_stats = BurstTimingStats();
+  m_stats.events = m_events.size();
+  m_stats.error = LatencyHistogram(m_settings.histogramBinUs,
+                                   m_settings.histogramBins);
+
+  for (const auto &e : m_events) {
+    if (e.channel >= BURST_SEQUENCER_CHANNELS) {
+      fprintf(stderr, "Burst event for channel %u out of range\n",
+              e.channel + 1);
+      return false;
+    }
+  }
+
+  /* Events at the same time on different channels fire together. A
+   * channel showing up twice starts a new group, its second configuration
+   * can only be staged after the first fired. */
+  m_start = nowNs() + toNs(m_settings.stageAheadMs * 1e-3);
+  m_groups.clear();
+  for (uint32_t i = 0; i < m_events.size(); i++) {
+    const BurstEvent &e = m_events[i];
+    int64_t deadline = m_start + toNs(e.time);
+    uint32_t bit = 1u << e.channel;
+    Group *g = m_groups.empty() ? nullptr : &m_groups.back();
+    bool join = g && g->deadline == deadline;
+    for (uint32_t j = join ? g->first : i; j < i; j++) {
+      join = join && m_events[j].channel != e.channel;
+    }
+    if (join) {
+      g->last = i;
+      g->mask |= e.trigger ? bit : 0;
+    } else {
+      m_groups.push_back({deadline, i, i, e.trigger ? bit : 0u});
+    }
+  }
+
+  std::thread staging([this] { stager(); });
+  std::thread firing([this] { triggerer(); });
+  staging.join();
+  firing.join();
+  m_stats.failures += m_stageFailures;
+  return !m_failed && !m_stop;
+}
+
+auto BurstSequencer::stager() -> void {
+  std::vector<BurstParams> have(BURST_SEQUENCER_CHANNELS);
+  std::vector<bool> known(BURST_SEQUENCER_CHANNELS, false);
+  std::vector<int64_t> previous(BURST_SEQUENCER_CHANNELS, -1);
+  int64_t ahead = toNs(m_settings.stageAheadMs * 1e-3);
+
+  for (uint32_t i = 0; i < m_events.size() && !m_stop; i++) {
+    const BurstEvent &e = m_events[i];
+    int64_t when = m_start + toNs(e.time) - ahead;
+
+    /* The channel's last burst has to be fired and played out */
+    int64_t prev = previous[e.channel];
+    if (prev >= 0 && m_events[prev].trigger) {
+      while (m_fired.load() <= (uint32_t)prev && !m_stop) {
+        sleepUntil(nowNs() + POLL_NS);
+      }
+      const BurstParams &p = m_events[prev].params;
+      when = std::max(when, m_fireNs[prev] + toNs(burstDuration(p)));
+    }
+    while (!m_stop && nowNs() < when) {
+      sleepUntil(std::min(when, nowNs() + MAX_SLEEP_NS));
+    }
+    if (m_stop) {
+      break;
+    }
+
+    if (known[e.channel] && have[e.channel] == e.params) {
+      m_stats.stagesSkipped++;
+    } else {
+      int64_t t = nowNs();
+      bool ok = m_backend->stage(e.channel, e.params);
+      m_stats.maxStageMs = std::max(m_stats.maxStageMs, elapsedMs(t));
+      m_stats.stages++;
+      known[e.channel] = ok;
+      have[e.channel] = e.params;
+      if (!ok) {
+        m_stageFailures++;
+        m_failed = true;
+      }
+    }
+    previous[e.channel] = i;
+    m_staged.store(i + 1);
+  }
+}
+
+auto BurstSequencer::triggerer() -> void {
+  m_stats.realtime =
+      makeThreadRealtime(m_settings.priority, m_settings.cpu) &&
+      m_settings.priority > 0;
+  int64_t spin = toNs(m_settings.spinUs * 1e-6);
+
+  for (const Group &g : m_groups) {
+    while (!m_stop && nowNs() < g.deadline - spin) {
+      sleepUntil(std::min(g.deadline - spin, nowNs() + MAX_SLEEP_NS));
+    }
+    while (!m_stop && nowNs() < g.deadline) {
+    }
+    /* Sleep rather than spin, the staging thread may need this CPU */
+    if (m_staged.load() <= g.last) {
+      m_stats.lateStages++;
+      while (!m_stop && m_staged.load() <= g.last) {
+        sleepUntil(nowNs() + POLL_NS);
+      }
+    }
+    if (m_stop) {
+      break;
+    }
+
+    int64_t t = nowNs();
+    if (g.mask) {
+      if (!m_backend->trigger(g.mask)) {
+        m_stats.failures++;
+        m_failed = true;
+      }
+      double callUs = (nowNs() - t) / 1e3;
+      m_stats.maxTriggerUs = std::max(m_stats.maxTriggerUs, callUs);
+      m_stats.triggers++;
+      m_stats.error.add((t - g.deadline) / 1e3);
+    }
+    for (uint32_t i = g.first; i <= g.last; i++) {
+      m_fireNs[i] = t;
+    }
+    m_fired.store(g.last + 1);
+  }
+}
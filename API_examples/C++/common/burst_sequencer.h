@@ -0,0 +1,134 @@
+/* Red Pitaya C++ examples - timeline burst sequencer
+ *
+ * Plays a timeline of burst events: at each event time a channel gets its
+ * burst configuration and, unless the event only configures, a software
+ * trigger. Writing a configuration takes a string of register round trips
+ * and triggering takes one, so the two are split:
+ *  - a staging thread writes the configuration of an event stageAheadMs
+ *    before its time, once the previous burst of that channel has finished
+ *    playing, and skips it when the channel already has it;
+ *  - a trigger thread, SCHED_FIFO if allowed, sleeps to each event time
+ *    with clock_nanosleep(TIMER_ABSTIME), spins the last spinUs and fires.
+ *    Events at the same time fire with one trigger call.
+ * Deadlines are absolute, so a late wakeup does not shift the events after
+ * it. The difference between fire time and planned time goes into a
+ * histogram. */
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+#include "latency_histogram.h"
+
+#define BURST_SEQUENCER_CHANNELS 2
+
+struct BurstParams {
+  /* Waveform id, interpreted by the backend */
+  int waveform = 0;
+  float frequency = 1000;
+  float amplitude = 1;
+  float offset = 0;
+  /* Periods per burst, bursts and burst period in microseconds, 0 for
+   * bursts back to back */
+  uint32_t count = 1;
+  uint32_t repetitions = 1;
+  uint32_t period = 0;
+
+  auto operator==(const BurstParams &o) const -> bool = default;
+};
+
+/* Time the burst plays after its trigger */
+auto burstDuration(const BurstParams &p) -> double;
+
+struct BurstEvent {
+  /* Seconds from the start of the sequence */
+  double time = 0;
+  uint8_t channel = 0;
+  BurstParams params;
+  /* false only configures, e.g. for a burst fired by the external
+   * trigger */
+  bool trigger = true;
+};
+
+class BurstBackend {
+public:
+  virtual ~BurstBackend() = default;
+
+  /* Configures a channel for bursts without firing it. Called from the
+   * staging thread while the trigger thread may fire other channels. */
+  virtual auto stage(uint8_t channel, const BurstParams &params) -> bool = 0;
+
+  /* Fires the channels in the mask (bit per channel) together */
+  virtual auto trigger(uint32_t mask) -> bool = 0;
+};
+
+struct BurstSequencerSettings {
+  double stageAheadMs = 100;
+  /* Busy wait before each deadline, trades CPU for wakeup latency */
+  double spinUs = 200;
+  /* SCHED_FIFO priority of the trigger thread, 0 leaves it alone */
+  int priority = 80;
+  /* CPU of the trigger thread, -1 for any */
+  int cpu = -1;
+  double histogramBinUs = 10;
+  uint32_t histogramBins = 100;
+};
+
+struct BurstTimingStats {
+  uint64_t events = 0;
+  uint64_t triggers = 0;
+  uint64_t stages = 0;
+  /* Configurations that were already on the channel */
+  uint64_t stagesSkipped = 0;
+  /* Triggers that had to wait for their staging */
+  uint64_t lateStages = 0;
+  uint64_t failures = 0;
+  /* Fire time minus planned time */
+  LatencyHistogram error;
+  double maxTriggerUs = 0;
+  double maxStageMs = 0;
+  /* The trigger thread got SCHED_FIFO */
+  bool realtime = false;
+};
+
+class BurstSequencer {
+public:
+  BurstSequencer(BurstBackend *backend,
+                 const BurstSequencerSettings &settings);
+
+  /* Plays the events, sorted by time, starting stageAheadMs from now.
+   * Returns when the last event fired; false if a call failed. */
+  auto run(std::vector<BurstEvent> events) -> bool;
+  auto stop() -> void { m_stop = true; }
+
+  auto stats() const -> const BurstTimingStats & { return m_stats; }
+
+private:
+  struct Group {
+    int64_t deadline;
+    uint32_t first;
+    uint32_t last;
+    uint32_t mask;
+  };
+
+  auto stager() -> void;
+  auto triggerer() -> void;
+
+  BurstBackend *m_backend;
+  BurstSequencerSettings m_settings;
+  std::vector<BurstEvent> m_events;
+  std::vector<Group> m_groups;
+  int64_t m_start = 0;
+  /* Events staged, events fired, in timeline order */
+  std::atomic<uint32_t> m_staged{0};
+  std::atomic<uint32_t> m_fired{0};
+  /* Fire time of each event, written before m_fired moves past it */
+  std::vector<int64_t> m_fireNs;
+  std::atomic<bool> m_stop{false};
+  std::atomic<bool> m_failed{false};
+  /* Counted apart from m_stats.failures, which the trigger thread owns */
+  uint64_t m_stageFailures = 0;
+  BurstTimingStats m_stats;
+};
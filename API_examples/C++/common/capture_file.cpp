@@ -0,0 +1,557 @@
+/* Red Pitaya C++ examples - chunked capture file */
+
+#include "capture_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t LANES = 8;
+
+auto alignUp(uint64_t v, uint64_t align) -> uint64_t {
+  return (v + align - 1) / align * align;
+}
+
+template <typename T>
+auto columnRange(const T *__restrict x, uint32_t n, float *min, float *max)
+    -> void {
+  if (n == 0) {
+    *min = *max = 0;
+    return;
+  }
+  T lo[LANES], hi[LANES];
+  for (uint32_t l = 0; l < LANES; l++) {
+    lo[l] = hi[l] = x[0];
+  }
+  uint32_t i = 0;
+  for (; i + LANES <= n; i += LANES) {
+    for (uint32_t l = 0; l < LANES; l++) {
+      T v = x[i + l];
+      lo[l] = v < lo[l] ? v : lo[l];
+      hi[l] = v > hi[l] ? v : hi[l];
+    }
+  }
+  for (; i < n; i++) {
+    lo[0] = x[i] < lo[0] ? x[i] : lo[0];
+    hi[0] = x[i] > hi[0] ? x[i] : hi[0];
+  }
+  for (uint32_t l = 1; l < LANES; l++) {
+    lo[0] = lo[l] < lo[0] ? lo[l] : lo[0];
+    hi[0] = hi[l] > hi[0] ? hi[l] : hi[0];
+  }
+  *min = lo[0];
+  *max = hi[0];
+}
+
+/* Zigzag delta + LEB128 varint. Returns the encoded size, or 0 when it
+ * would reach limit bytes. */
+auto encodeColumn(const int16_t *x, uint32_t n, uint8_t *out, uint32_t limit)
+    -> uint32_t {
+  uint32_t size = 0;
+  int32_t prev = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    int32_t d = x[i] - prev;
+    prev = x[i];
+    uint32_t z = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+    if (size + 3 >= limit) {
+      return 0;
+    }
+    while (z >= 0x80) {
+      out[size++] = (uint8_t)(z | 0x80);
+      z >>= 7;
+    }
+    out[size++] = (uint8_t)z;
+  }
+  return size;
+}
+
+/* Decodes the first n samples of a column */
+auto decodeColumn(const uint8_t *in, uint32_t bytes, uint32_t n, int16_t *out)
+    -> uint32_t {
+  uint32_t pos = 0;
+  int32_t prev = 0;
+  uint32_t i = 0;
+  for (; i < n && pos < bytes; i++) {
+    uint32_t z = 0;
+    int shift = 0;
+    uint8_t b;
+    do {
+      b = in[pos++];
+      if (shift < 32) {
+        z |= (uint32_t)(b & 0x7f) << shift;
+      }
+      shift += 7;
+    } while ((b & 0x80) && pos < bytes);
+    prev += (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+    out[i] = (int16_t)prev;
+  }
+  return i;
+}
+
+auto writeAll(int fd, const void *data, uint64_t size, uint64_t offset)
+    -> bool {
+  const char *p = (const char *)data;
+  while (size) {
+    ssize_t n = pwrite(fd, p, size, offset);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += n;
+    size -= n;
+    offset += n;
+  }
+  return true;
+}
+
+} // namespace
+
+CaptureFileWriter::~CaptureFileWriter() { close(); }
+
+auto CaptureFileWriter::open(const char *path, const CaptureFileInfo &info)
+    -> bool {
+  if (m_fd >= 0 || info.channels == 0 ||
+      info.channels > CAPTURE_MAX_CHANNELS || info.chunkSamples == 0 ||
+      info.chunkSamples > CAPTURE_MAX_CHUNK_SAMPLES) {
+    return false;
+  }
+  m_fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (m_fd < 0) {
+    return false;
+  }
+
+  memset(&m_header, 0, sizeof(m_header));
+  memcpy(m_header.magic, CAPTURE_FILE_MAGIC, sizeof(m_header.magic));
+  m_header.version = CAPTURE_FILE_VERSION;
+  m_header.headerSize = sizeof(m_header);
+  m_header.channels = info.channels;
+  m_header.sampleType = info.sampleType;
+  m_header.chunkSamples = info.chunkSamples;
+  m_header.decimation = info.decimation;
+  m_header.sampleRate = info.sampleRate;
+  m_header.startTimeNs = info.startTimeNs;
+  for (int i = 0; i < CAPTURE_MAX_CHANNELS; i++) {
+    m_header.gain[i] = info.gain[i];
+    m_header.offset[i] = info.offset[i];
+  }
+  m_compress = info.compress && info.sampleType == CaptureSampleType::INT16;
+  m_sampleSize = info.sampleType == CaptureSampleType::INT16 ? 2 : 4;
+  for (uint16_t c = 0; c < info.channels; c++) {
+    m_stage[c].assign((size_t)info.chunkSamples * m_sampleSize, 0);
+  }
+  m_fill = 0;
+  m_samples = 0;
+  m_timeBaseNs = m_chunkTimeNs = info.startTimeNs;
+  m_timeOffsetNs = 0;
+  m_index.clear();
+
+  /* Header first, so an unfinished file can still be read */
+  m_offset = CAPTURE_FILE_ALIGN;
+  if (!writeAt(&m_header, sizeof(m_header), 0)) {
+    ::close(m_fd);
+    m_fd = -1;
+    return false;
+  }
+  return true;
+}
+
+auto CaptureFileWriter::write(const int16_t *const *channels, uint32_t n,
+                              int64_t timeNs) -> bool {
+  if (m_header.sampleType != CaptureSampleType::INT16) {
+    return false;
+  }
+  return append(channels, n, timeNs);
+}
+
+auto CaptureFileWriter::write(const float *const *channels, uint32_t n,
+                              int64_t timeNs) -> bool {
+  if (m_header.sampleType != CaptureSampleType::FLOAT32) {
+    return false;
+  }
+  return append(channels, n, timeNs);
+}
+
+template <typename T>
+auto CaptureFileWriter::append(const T *const *channels, uint32_t n,
+                               int64_t timeNs) -> bool {
+  if (m_fd < 0) {
+    return false;
+  }
+  if (timeNs >= 0) {
+    /* The chunk header holds the time of its first sample only */
+    if (m_fill > 0 && !emitChunk()) {
+      return false;
+    }
+    m_timeBaseNs = timeNs;
+    m_timeOffsetNs = 0;
+  }
+  const double step = 1e9 / m_header.sampleRate;
+  uint32_t done = 0;
+  while (done < n) {
+    if (m_fill == 0) {
+      m_chunkTimeNs = m_timeBaseNs + llround(m_timeOffsetNs);
+    }
+    uint32_t room = m_header.chunkSamples - m_fill;
+    uint32_t count = n - done < room ? n - done : room;
+    for (uint16_t c = 0; c < m_header.channels; c++) {
+      char *dst = m_stage[c].data() + (size_t)m_fill * sizeof(T);
+      memcpy(dst, channels[c] + done, (size_t)count * sizeof(T));
+    }
+    m_fill += count;
+    done += count;
+    m_timeOffsetNs += count * step;
+    if (m_fill == m_header.chunkSamples && !emitChunk()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto CaptureFileWriter::emitChunk() -> bool {
+  if (m_fill == 0) {
+    return true;
+  }
+  const uint16_t channels = m_header.channels;
+  CaptureChunkHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CAPTURE_CHUNK_MAGIC, sizeof(h.magic));
+  h.firstSample = m_samples;
+  h.timeNs = m_chunkTimeNs;
+  h.samples = m_fill;
+
+  uint32_t raw = m_fill * m_sampleSize;
+  uint32_t columnRoom = alignUp(raw, CAPTURE_COLUMN_ALIGN);
+  uint64_t worst = alignUp(sizeof(h), CAPTURE_COLUMN_ALIGN) +
+                   (uint64_t)columnRoom * channels;
+  if (m_chunk.size() < worst) {
+    m_chunk.resize(worst);
+  }
+
+  uint32_t pos = alignUp(sizeof(h), CAPTURE_COLUMN_ALIGN);
+  for (uint16_t c = 0; c < channels; c++) {
+    const char *src = m_stage[c].data();
+    uint8_t *dst = (uint8_t *)m_chunk.data() + pos;
+    uint32_t size = 0;
+    if (m_sampleSize == 2) {
+      columnRange((const int16_t *)src, m_fill, &h.min[c], &h.max[c]);
+      if (m_compress) {
+        size = encodeColumn((const int16_t *)src, m_fill, dst, raw);
+      }
+    } else {
+      columnRange((const float *)src, m_fill, &h.min[c], &h.max[c]);
+    }
+    if (size) {
+      h.compressed |= 1u << c;
+    } else {
+      memcpy(dst, src, raw);
+      size = raw;
+    }
+    h.columnOffset[c] = pos;
+    h.columnBytes[c] = size;
+    uint32_t end = pos + size;
+    pos = alignUp(end, CAPTURE_COLUMN_ALIGN);
+    memset(m_chunk.data() + end, 0, pos - end);
+  }
+
+  uint64_t total = alignUp(pos, CAPTURE_FILE_ALIGN);
+  h.bytes = (uint32_t)total;
+  memcpy(m_chunk.data(), &h, sizeof(h));
+  memset(m_chunk.data() + sizeof(h), 0,
+         alignUp(sizeof(h), CAPTURE_COLUMN_ALIGN) - sizeof(h));
+  if (m_chunk.size() < total) {
+    m_chunk.resize(total);
+  }
+  memset(m_chunk.data() + pos, 0, total - pos);
+
+  if (!writeAt(m_chunk.data(), total, m_offset)) {
+    return false;
+  }
+  m_index.push_back({m_offset, h});
+  m_offset += total;
+  m_samples += m_fill;
+  m_fill = 0;
+  return true;
+}
+
+auto CaptureFileWriter::close() -> bool {
+  if (m_fd < 0) {
+    return true;
+  }
+  bool ok = emitChunk();
+  if (ok) {
+    m_header.totalSamples = m_samples;
+    m_header.chunkCount = m_index.size();
+    m_header.indexOffset = m_offset;
+    ok = writeAt(m_index.data(), m_index.size() * sizeof(CaptureIndexEntry),
+                 m_offset) &&
+         writeAt(&m_header, sizeof(m_header), 0);
+  }
+  if (ok) {
+    m_offset += m_index.size() * sizeof(CaptureIndexEntry);
+  }
+  ok = ::close(m_fd) == 0 && ok;
+  m_fd = -1;
+  return ok;
+}
+
+auto CaptureFileWriter::writeAt(const void *data, uint64_t size,
+                                uint64_t offset) -> bool {
+  return writeAll(m_fd, data, size, offset);
+}
+
+CaptureFileReader::~CaptureFileReader() { close(); }
+
+auto CaptureFileReader::open(const char *path) -> bool {
+  close();
+  m_fd = ::open(path, O_RDONLY);
+  if (m_fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(m_fd, &st) != 0 || st.st_size < CAPTURE_FILE_ALIGN) {
+    close();
+    return false;
+  }
+  m_size = st.st_size;
+  void *map = mmap(NULL, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+  if (map == MAP_FAILED) {
+    close();
+    return false;
+  }
+  m_map = (const uint8_t *)map;
+  m_header = (const CaptureFileHeader *)m_map;
+  if (memcmp(m_header->magic, CAPTURE_FILE_MAGIC, 8) ||
+      m_header->version != CAPTURE_FILE_VERSION ||
+      m_header->channels == 0 ||
+      m_header->channels > CAPTURE_MAX_CHANNELS ||
+      (m_header->sampleType != CaptureSampleType::INT16 &&
+       m_header->sampleType != CaptureSampleType::FLOAT32)) {
+    close();
+    return false;
+  }
+
+  /* The index is only used when every entry points at a valid chunk inside
+   * the file, the chunks are walked otherwise */
+  uint64_t indexOffset = m_header->indexOffset;
+  if (indexOffset >= CAPTURE_FILE_ALIGN && indexOffset <= m_size &&
+      indexOffset % alignof(CaptureIndexEntry) == 0 &&
+      m_header->chunkCount <=
+          (m_size - indexOffset) / sizeof(CaptureIndexEntry)) {
+    auto *index = (const CaptureIndexEntry *)(m_map + indexOffset);
+    uint64_t samples = 0;
+    uint64_t i = 0;
+    for (; i < m_header->chunkCount; i++) {
+      if (index[i].offset > indexOffset ||
+          index[i].chunk.firstSample != samples ||
+          !validChunk(index[i].offset, index[i].chunk)) {
+        break;
+      }
+      samples += index[i].chunk.samples;
+    }
+    if (i == m_header->chunkCount) {
+      m_index = index;
+      m_count = m_header->chunkCount;
+      m_samples = samples;
+      m_complete = true;
+      return true;
+    }
+  }
+  if (!rebuildIndex()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+auto CaptureFileReader::rebuildIndex() -> bool {
+  m_rebuilt.clear();
+  m_samples = 0;
+  uint64_t offset = CAPTURE_FILE_ALIGN;
+  while (offset + sizeof(CaptureChunkHeader) <= m_size) {
+    auto *h = (const CaptureChunkHeader *)(m_map + offset);
+    if (h->firstSample != m_samples || !validChunk(offset, *h)) {
+      break;
+    }
+    m_rebuilt.push_back({offset, *h});
+    m_samples += h->samples;
+    offset += h->bytes;
+  }
+  m_index = m_rebuilt.data();
+  m_count = m_rebuilt.size();
+  return true;
+}
+
+auto CaptureFileReader::validChunk(uint64_t offset,
+                                   const CaptureChunkHeader &h) const
+    -> bool {
+  if (offset < CAPTURE_FILE_ALIGN || offset > m_size ||
+      offset % alignof(CaptureChunkHeader) != 0 ||
+      sizeof(CaptureChunkHeader) > m_size - offset ||
+      memcmp(m_map + offset, CAPTURE_CHUNK_MAGIC, 4) ||
+      h.bytes < sizeof(CaptureChunkHeader) || h.bytes > m_size - offset ||
+      h.samples > CAPTURE_MAX_CHUNK_SAMPLES) {
+    return false;
+  }
+  uint64_t sampleSize =
+      m_header->sampleType == CaptureSampleType::INT16 ? 2 : 4;
+  for (uint16_t c = 0; c < m_header->channels; c++) {
+    uint64_t begin = h.columnOffset[c];
+    uint64_t end = begin + h.columnBytes[c];
+    if (begin < sizeof(CaptureChunkHeader) || end > h.bytes ||
+        begin % sampleSize != 0) {
+      return false;
+    }
+    bool compressed = h.compressed & (1u << c);
+    if (compressed ? m_header->sampleType != CaptureSampleType::INT16
+                   : h.columnBytes[c] < h.samples * sampleSize) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto CaptureFileReader::close() -> void {
+  if (m_map) {
+    munmap((void *)m_map, m_size);
+  }
+  if (m_fd >= 0) {
+    ::close(m_fd);
+  }
+  m_fd = -1;
+  m_map = NULL;
+  m_header = NULL;
+  m_index = NULL;
+  m_count = m_samples = m_size = 0;
+  m_complete = false;
+  m_rebuilt.clear();
+}
+
+auto CaptureFileReader::findSample(uint64_t sample) const -> uint64_t {
+  uint64_t lo = 0, hi = m_count;
+  while (hi - lo > 1) {
+    uint64_t mid = (lo + hi) / 2;
+    if (m_index[mid].chunk.firstSample <= sample) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+auto CaptureFileReader::findTime(int64_t timeNs) const -> uint64_t {
+  uint64_t lo = 0, hi = m_count;
+  while (hi - lo > 1) {
+    uint64_t mid = (lo + hi) / 2;
+    if (m_index[mid].chunk.timeNs <= timeNs) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+auto CaptureFileReader::sampleAtTime(int64_t timeNs) const -> uint64_t {
+  if (m_count == 0) {
+    return 0;
+  }
+  const CaptureChunkHeader &h = m_index[findTime(timeNs)].chunk;
+  double offset = (timeNs - h.timeNs) * m_header->sampleRate / 1e9;
+  if (offset < 0) {
+    offset = 0;
+  }
+  uint64_t inChunk = (uint64_t)(offset + 0.5);
+  if (inChunk >= h.samples) {
+    inChunk = h.samples ? h.samples - 1 : 0;
+  }
+  return h.firstSample + inChunk;
+}
+
+auto CaptureFileReader::column(uint64_t chunk, uint16_t channel) const
+    -> const void * {
+  if (chunk >= m_count || channel >= m_header->channels) {
+    return NULL;
+  }
+  const CaptureIndexEntry &e = m_index[chunk];
+  if (e.chunk.compressed & (1u << channel)) {
+    return NULL;
+  }
+  return m_map + e.offset + e.chunk.columnOffset[channel];
+}
+
+template <typename T>
+auto CaptureFileReader::readColumn(uint16_t channel, uint64_t first,
+                                   uint32_t n, T *out) const -> uint32_t {
+  if (m_count == 0 || channel >= m_header->channels) {
+    return 0;
+  }
+  std::vector<int16_t> scratch;
+  uint32_t done = 0;
+  for (uint64_t c = findSample(first); c < m_count && done < n; c++) {
+    const CaptureIndexEntry &e = m_index[c];
+    const CaptureChunkHeader &h = e.chunk;
+    uint64_t at = first + done;
+    if (at < h.firstSample || at >= h.firstSample + h.samples) {
+      break;
+    }
+    uint32_t skip = at - h.firstSample;
+    uint32_t count = h.samples - skip < n - done ? h.samples - skip : n - done;
+    const uint8_t *src = m_map + e.offset + h.columnOffset[channel];
+    if (h.compressed & (1u << channel)) {
+      /* Only int16 columns are ever compressed */
+      if constexpr (!std::is_same_v<T, int16_t>) {
+        break;
+      }
+      scratch.resize(skip + count);
+      if (decodeColumn(src, h.columnBytes[channel], skip + count,
+                       scratch.data()) != skip + count) {
+        break;
+      }
+      memcpy(out + done, scratch.data() + skip, count * sizeof(T));
+    } else {
+      memcpy(out + done, src + (size_t)skip * sizeof(T), count * sizeof(T));
+    }
+    done += count;
+  }
+  return done;
+}
+
+auto CaptureFileReader::read(uint16_t channel, uint64_t first, uint32_t n,
+                             int16_t *out) const -> uint32_t {
+  if (m_header->sampleType != CaptureSampleType::INT16) {
+    return 0;
+  }
+  return readColumn(channel, first, n, out);
+}
+
+auto CaptureFileReader::readVolts(uint16_t channel, uint64_t first,
+                                  uint32_t n, float *out) const -> uint32_t {
+  if (channel >= m_header->channels) {
+    return 0;
+  }
+  const float gain = m_header->gain[channel];
+  const float offset = m_header->offset[channel];
+  if (m_header->sampleType == CaptureSampleType::FLOAT32) {
+    uint32_t done = readColumn(channel, first, n, out);
+    for (uint32_t i = 0; i < done; i++) {
+      out[i] = out[i] * gain + offset;
+    }
+    return done;
+  }
+  std::vector<int16_t> codes(n);
+  uint32_t done = readColumn(channel, first, n, codes.data());
+  for (uint32_t i = 0; i < done; i++) {
+    out[i] = codes[i] * gain + offset;
+  }
+  return done;
+}
@@ -0,0 +1,204 @@
+/* Red Pitaya C++ examples - chunked capture file
+ *
+ * Long captures are stored as a sequence of chunks. Each chunk holds the
+ * same sample range of every channel as separate columns (channel 1 samples,
+ * then channel 2 samples, ...). Chunks start on a page boundary and columns
+ * on a cache line, so an uncompressed column can be used straight from a
+ * read-only mmap of the file.
+ *
+ * Every chunk header records its first sample, the time of that sample and
+ * the min/max of each column. The same headers are repeated in an index at
+ * the end of the file, so a reader can find a time or sample range with a
+ * binary search and draw an overview from the min/max values without
+ * touching the sample data. If the writer did not finish (no index), or an
+ * index entry points outside the file or at a chunk whose columns do not
+ * fit in it, the reader rebuilds the index by walking the chunk headers,
+ * which are checked the same way.
+ *
+ * int16 columns can be stored compressed (zigzag delta + varint). A column
+ * that would not get smaller is stored raw. Compression is chosen per column
+ * and flagged in the chunk header.
+ *
+ * All fields are little-endian. Layout:
+ *   CaptureFileHeader, padded to CAPTURE_FILE_ALIGN
+ *   chunk: CaptureChunkHeader, columns, padded to CAPTURE_FILE_ALIGN
+ *   ...
+ *   index: CaptureIndexEntry[chunkCount] at header.indexOffset */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "capture_writer.h"
+
+#define CAPTURE_FILE_MAGIC "RPCHUNK1"
+#define CAPTURE_FILE_VERSION 1
+#define CAPTURE_FILE_ALIGN 4096
+#define CAPTURE_COLUMN_ALIGN 64
+#define CAPTURE_CHUNK_MAGIC "CHNK"
+#define CAPTURE_MAX_CHUNK_SAMPLES (16 * 1024 * 1024)
+
+struct CaptureFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint16_t channels;
+  CaptureSampleType sampleType;
+  /* Samples per channel in a full chunk, the last one may be shorter */
+  uint32_t chunkSamples;
+  uint32_t decimation;
+  uint32_t reserved;
+  double sampleRate;
+  /* Time of the first sample, CLOCK_REALTIME nanoseconds or 0 */
+  int64_t startTimeNs;
+  uint64_t totalSamples;
+  uint64_t chunkCount;
+  /* 0 while the file is being written */
+  uint64_t indexOffset;
+  /* Volts = sample * gain + offset */
+  float gain[CAPTURE_MAX_CHANNELS];
+  float offset[CAPTURE_MAX_CHANNELS];
+  uint8_t pad[24];
+};
+
+static_assert(sizeof(CaptureFileHeader) == 128, "file header layout");
+
+struct CaptureChunkHeader {
+  char magic[4];
+  /* Bytes from this header to the next chunk */
+  uint32_t bytes;
+  uint64_t firstSample;
+  int64_t timeNs;
+  uint32_t samples;
+  /* Bit c set when column c is compressed */
+  uint32_t compressed;
+  /* Relative to the chunk header */
+  uint32_t columnOffset[CAPTURE_MAX_CHANNELS];
+  uint32_t columnBytes[CAPTURE_MAX_CHANNELS];
+  /* In sample units */
+  float min[CAPTURE_MAX_CHANNELS];
+  float max[CAPTURE_MAX_CHANNELS];
+};
+
+static_assert(sizeof(CaptureChunkHeader) == 96, "chunk header layout");
+
+struct CaptureIndexEntry {
+  uint64_t offset;
+  CaptureChunkHeader chunk;
+};
+
+struct CaptureFileInfo {
+  uint16_t channels = 1;
+  CaptureSampleType sampleType = CaptureSampleType::INT16;
+  uint32_t chunkSamples = 64 * 1024;
+  uint32_t decimation = 1;
+  double sampleRate = 125e6;
+  int64_t startTimeNs = 0;
+  float gain[CAPTURE_MAX_CHANNELS] = {1, 1, 1, 1};
+  float offset[CAPTURE_MAX_CHANNELS] = {};
+  /* Compress int16 columns */
+  bool compress = false;
+};
+
+class CaptureFileWriter {
+public:
+  ~CaptureFileWriter();
+
+  auto open(const char *path, const CaptureFileInfo &info) -> bool;
+
+  /* Appends n samples of every channel. timeNs is the time of the first of
+   * them; pass it after a gap in the stream, otherwise (-1) the time
+   * continues from the previous samples at the sample rate. A new time
+   * ends the pending chunk, so every chunk has a single time base. */
+  auto write(const int16_t *const *channels, uint32_t n, int64_t timeNs = -1)
+      -> bool;
+  auto write(const float *const *channels, uint32_t n, int64_t timeNs = -1)
+      -> bool;
+
+  /* Writes the pending chunk and the index. Called by the destructor. */
+  auto close() -> bool;
+
+  auto samples() const -> uint64_t { return m_samples; }
+  auto chunks() const -> uint64_t { return m_index.size(); }
+  /* File size so far */
+  auto bytes() const -> uint64_t { return m_offset; }
+
+private:
+  template <typename T>
+  auto append(const T *const *channels, uint32_t n, int64_t timeNs) -> bool;
+  auto emitChunk() -> bool;
+  auto writeAt(const void *data, uint64_t size, uint64_t offset) -> bool;
+
+  int m_fd = -1;
+  CaptureFileHeader m_header;
+  bool m_compress = false;
+  uint32_t m_sampleSize = 0;
+  /* Staged columns of the chunk being filled */
+  std::vector<char> m_stage[CAPTURE_MAX_CHANNELS];
+  uint32_t m_fill = 0;
+  uint64_t m_samples = 0;
+  /* Time of the next sample as a base plus an offset, a double alone
+   * would not hold epoch nanoseconds exactly */
+  int64_t m_timeBaseNs = 0;
+  double m_timeOffsetNs = 0;
+  int64_t m_chunkTimeNs = 0;
+  std::vector<char> m_chunk;
+  uint64_t m_offset = 0;
+  std::vector<CaptureIndexEntry> m_index;
+};
+
+class CaptureFileReader {
+public:
+  ~CaptureFileReader();
+
+  /* Maps the whole file read-only */
+  auto open(const char *path) -> bool;
+  auto close() -> void;
+
+  auto header() const -> const CaptureFileHeader & { return *m_header; }
+  auto channels() const -> uint16_t { return m_header->channels; }
+  auto samples() const -> uint64_t { return m_samples; }
+  /* False when the index was rebuilt from the chunks */
+  auto complete() const -> bool { return m_complete; }
+
+  auto chunks() const -> uint64_t { return m_count; }
+  auto chunk(uint64_t i) const -> const CaptureChunkHeader & {
+    return m_index[i].chunk;
+  }
+  /* Chunk holding a sample or the last chunk starting at or before a time */
+  auto findSample(uint64_t sample) const -> uint64_t;
+  auto findTime(int64_t timeNs) const -> uint64_t;
+  /* Sample nearest to a time */
+  auto sampleAtTime(int64_t timeNs) const -> uint64_t;
+
+  /* Column of a chunk straight from the mapping, NULL if compressed */
+  auto column(uint64_t chunk, uint16_t channel) const -> const void *;
+
+  /* Copies samples [first, first + n) of a channel, decompressing as
+   * needed. Returns the number of samples copied. The int16 version needs
+   * an int16 file, the volts version works on both. */
+  auto read(uint16_t channel, uint64_t first, uint32_t n, int16_t *out) const
+      -> uint32_t;
+  auto readVolts(uint16_t channel, uint64_t first, uint32_t n,
+                 float *out) const -> uint32_t;
+
+private:
+  auto rebuildIndex() -> bool;
+  /* True when a chunk and its columns lie inside the file */
+  auto validChunk(uint64_t offset, const CaptureChunkHeader &h) const -> bool;
+  template <typename T>
+  auto readColumn(uint16_t channel, uint64_t first, uint32_t n, T *out) const
+      -> uint32_t;
+
+  int m_fd = -1;
+  const uint8_t *m_map = NULL;
+  uint64_t m_size = 0;
+  const CaptureFileHeader *m_header = NULL;
+  const CaptureIndexEntry *m_index = NULL;
+  uint64_t m_count = 0;
+  uint64_t m_samples = 0;
+  bool m_complete = false;
+  std::vector<CaptureIndexEntry> m_rebuilt;
+};
@@ -0,0 +1,276 @@
+/* Red Pitaya C++ examples - buffered capture output */
+
+#include "capture_writer.h"
+
+#include <charconv>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "binary capture output assumes a little-endian target"
+#endif
+
+/* Longest formatted field without the digits after the point: a float in
+ * fixed notation has up to 39 digits before it, then sign, point and
+ * separator; a 64-bit index or an int16 is shorter */
+constexpr uint32_t FIELD_BASE = 48;
+
+auto writeAll(int fd, const char *data, size_t size) -> bool {
+  while (size) {
+    ssize_t n = ::write(fd, data, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+auto format(char *p, char *end, float v, int precision) -> char * {
+  if (precision < 0) {
+    return std::to_chars(p, end, v).ptr;
+  }
+  return std::to_chars(p, end, v, std::chars_format::fixed, precision).ptr;
+}
+
+auto format(char *p, char *end, int16_t v, int) -> char * {
+  return std::to_chars(p, end, v).ptr;
+}
+
+} // namespace
+
+CaptureWriter::CaptureWriter(int fd, CaptureFormat format, uint32_t bufferSize)
+    : m_fd(fd), m_format(format),
+      m_buffer(bufferSize > 4096 ? bufferSize : 4096) {}
+
+CaptureWriter::~CaptureWriter() { flush(); }
+
+auto CaptureWriter::begin(const CaptureInfo &info, CaptureSampleType type)
+    -> bool {
+  m_channels = info.channels;
+  m_row = 0;
+  if (m_channels == 0 || m_channels > CAPTURE_MAX_CHANNELS) {
+    m_failed = true;
+    m_error = EINVAL;
+    return false;
+  }
+  if (m_format != CaptureFormat::RPCAP) {
+    return true;
+  }
+  CaptureHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CAPTURE_MAGIC, sizeof(h.magic));
+  h.headerSize = sizeof(h);
+  h.channels = info.channels;
+  h.sampleType = type;
+  h.samples = info.samples;
+  h.decimation = info.decimation;
+  h.triggerPos = info.triggerPos;
+  h.sampleRate = info.sampleRate;
+  for (int i = 0; i < CAPTURE_MAX_CHANNELS; i++) {
+    h.gain[i] = info.gain[i];
+    h.offset[i] = info.offset[i];
+  }
+  return append(&h, sizeof(h));
+}
+
+auto CaptureWriter::isText() const -> bool {
+  return m_format == CaptureFormat::CSV || m_format == CaptureFormat::TSV ||
+         m_format == CaptureFormat::SSV;
+}
+
+auto CaptureWriter::write(const float *const *channels, uint32_t n) -> bool {
+  if (isText()) {
+    return writeText(channels, n);
+  }
+  return writeBinary(channels, n);
+}
+
+auto CaptureWriter::write(const int16_t *const *channels, uint32_t n)
+    -> bool {
+  if (isText()) {
+    return writeText(channels, n);
+  }
+  return writeBinary(channels, n);
+}
+
+template <typename T>
+auto CaptureWriter::writeText(const T *const *channels, uint32_t n) -> bool {
+  const char sep = m_format == CaptureFormat::CSV   ? ','
+                   : m_format == CaptureFormat::TSV ? '\t'
+                                                    : ' ';
+  /* Room for the longest row, which has to fit the buffer */
+  const uint64_t rowMax =
+      (uint64_t)(m_channels + 1) *
+      (FIELD_BASE + (m_precision > 0 ? (uint64_t)m_precision : 0));
+  if (rowMax > m_buffer.size()) {
+    m_failed = true;
+    m_error = EINVAL;
+    return false;
+  }
+  for (uint32_t i = 0; i < n && !m_failed; i++, m_row++) {
+    char *p = reserve(rowMax);
+    if (!p) {
+      return false;
+    }
+    char *start = p;
+    char *end = p + rowMax;
+    if (m_index) {
+      p = std::to_chars(p, end, m_row).ptr;
+      *p++ = sep;
+    }
+    for (uint16_t c = 0; c < m_channels; c++) {
+      p = format(p, end, channels[c][i], m_precision);
+      *p++ = sep;
+    }
+    p[-1] = '\n';
+    m_fill += p - start;
+  }
+  return !m_failed;
+}
+
+template <typename T>
+auto CaptureWriter::writeBinary(const T *const *channels, uint32_t n)
+    -> bool {
+  if (m_channels == 1) {
+    return append(channels[0], n * sizeof(T));
+  }
+  /* Interleave straight into the output buffer, in pieces that fit */
+  const uint32_t rowSize = m_channels * sizeof(T);
+  uint32_t done = 0;
+  while (done < n && !m_failed) {
+    uint32_t room = (m_buffer.size() - m_fill) / rowSize;
+    if (room == 0) {
+      flush();
+      continue;
+    }
+    uint32_t count = n - done < room ? n - done : room;
+    T *out = (T *)(m_buffer.data() + m_fill);
+    for (uint16_t c = 0; c < m_channels; c++) {
+      const T *in = channels[c] + done;
+      for (uint32_t i = 0; i < count; i++) {
+        out[i * m_channels + c] = in[i];
+      }
+    }
+    m_fill += count * rowSize;
+    done += count;
+  }
+  return !m_failed;
+}
+
+auto CaptureWriter::reserve(uint32_t size) -> char * {
+  if (m_buffer.size() - m_fill < size && !flush()) {
+    return NULL;
+  }
+  return m_buffer.data() + m_fill;
+}
+
+auto CaptureWriter::append(const void *data, uint32_t size) -> bool {
+  const char *p = (const char *)data;
+  while (size && !m_failed) {
+    if (m_fill == 0 && size >= m_buffer.size()) {
+      /* Large blocks go out directly */
+      if (!writeAll(m_fd, p, size)) {
+        m_failed = true;
+        m_error = errno;
+        return false;
+      }
+      m_bytes += size;
+      return true;
+    }
+    uint32_t room = m_buffer.size() - m_fill;
+    uint32_t count = size < room ? size : room;
+    memcpy(m_buffer.data() + m_fill, p, count);
+    m_fill += count;
+    p += count;
+    size -= count;
+    if (m_fill == m_buffer.size()) {
+      flush();
+    }
+  }
+  return !m_failed;
+}
+
+auto CaptureWriter::flush() -> bool {
+  if (m_failed) {
+    return false;
+  }
+  if (m_fill && !writeAll(m_fd, m_buffer.data(), m_fill)) {
+    m_failed = true;
+    m_error = errno;
+    return false;
+  }
+  m_bytes += m_fill;
+  m_fill = 0;
+  return true;
+}
+
+auto captureParseFormat(const char *name, CaptureFormat *format) -> bool {
+  if (!strcmp(name, "csv")) {
+    *format = CaptureFormat::CSV;
+  } else if (!strcmp(name, "tsv")) {
+    *format = CaptureFormat::TSV;
+  } else if (!strcmp(name, "ssv")) {
+    *format = CaptureFormat::SSV;
+  } else if (!strcmp(name, "raw")) {
+    *format = CaptureFormat::RAW;
+  } else if (!strcmp(name, "rpcap")) {
+    *format = CaptureFormat::RPCAP;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+auto captureOpenOutput(const char *target) -> int {
+  signal(SIGPIPE, SIG_IGN);
+  if (!strcmp(target, "-")) {
+    return STDOUT_FILENO;
+  }
+  if (strncmp(target, "tcp:", 4)) {
+    return open(target, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  }
+
+  std::string address = target + 4;
+  size_t colon = address.rfind(':');
+  if (colon == std::string::npos) {
+    return -1;
+  }
+  std::string host = address.substr(0, colon);
+  std::string port = address.substr(colon + 1);
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo *res = NULL;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) {
+    return -1;
+  }
+  int fd = -1;
+  for (auto *ai = res; ai; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  return fd;
+}
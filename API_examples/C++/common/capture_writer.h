@@ -0,0 +1,121 @@
+/* Red Pitaya C++ examples - buffered capture output
+ *
+ * Writes multi-channel captures as text (CSV/TSV/SSV, one row per sample) or
+ * binary (interleaved little-endian samples, optionally preceded by a
+ * header describing the capture). Rows are formatted with std::to_chars
+ * into a large buffer that is written to the file descriptor in one call
+ * when full, so output speed is bound by the target, not by formatting.
+ *
+ * The descriptor may be a file, a pipe or a connected socket. A reader
+ * that goes away fails the writer with EPIPE, see error(). */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+enum class CaptureFormat {
+  CSV,
+  TSV,
+  /* Space separated, what the examples printed before */
+  SSV,
+  /* Interleaved samples, no header */
+  RAW,
+  /* CaptureHeader followed by interleaved samples */
+  RPCAP
+};
+
+#define CAPTURE_MAGIC "RPCAP01"
+#define CAPTURE_MAX_CHANNELS 4
+
+enum class CaptureSampleType : uint16_t { INT16 = 1, FLOAT32 = 2 };
+
+/* Binary header, all fields little-endian. Samples follow immediately,
+ * interleaved by channel. */
+struct CaptureHeader {
+  char magic[8];
+  uint32_t headerSize;
+  uint16_t channels;
+  CaptureSampleType sampleType;
+  /* Samples per channel, 0 when unknown (stream to a pipe or socket) */
+  uint64_t samples;
+  uint32_t decimation;
+  /* Write pointer at trigger of the first channel */
+  uint32_t triggerPos;
+  double sampleRate;
+  /* Volts = sample * gain + offset. 1 and 0 for float samples in volts. */
+  float gain[CAPTURE_MAX_CHANNELS];
+  float offset[CAPTURE_MAX_CHANNELS];
+};
+
+static_assert(sizeof(CaptureHeader) == 72, "header layout is part of format");
+
+struct CaptureInfo {
+  uint16_t channels = 1;
+  uint64_t samples = 0;
+  uint32_t decimation = 1;
+  uint32_t triggerPos = 0;
+  double sampleRate = 0;
+  float gain[CAPTURE_MAX_CHANNELS] = {1, 1, 1, 1};
+  float offset[CAPTURE_MAX_CHANNELS] = {};
+};
+
+class CaptureWriter {
+public:
+  /* The descriptor is not closed by the writer */
+  CaptureWriter(int fd, CaptureFormat format, uint32_t bufferSize = 1 << 20);
+  /* Flushes what is buffered */
+  ~CaptureWriter();
+
+  /* Text only: digits after the decimal point for float samples, -1 for the
+   * shortest exact representation */
+  auto setPrecision(int digits) -> void { m_precision = digits; }
+  /* Text only: prefix each row with the sample index */
+  auto setIndex(bool index) -> void { m_index = index; }
+
+  /* Writes the header (RPCAP). Must be called once before the samples. */
+  auto begin(const CaptureInfo &info, CaptureSampleType type) -> bool;
+
+  /* n samples of every channel passed to begin() */
+  auto write(const float *const *channels, uint32_t n) -> bool;
+  auto write(const int16_t *const *channels, uint32_t n) -> bool;
+
+  auto flush() -> bool;
+
+  auto failed() const -> bool { return m_failed; }
+  /* errno of the failed write, EPIPE when the reader closed a pipe or
+   * socket */
+  auto error() const -> int { return m_error; }
+  /* Bytes handed to the descriptor so far */
+  auto bytes() const -> uint64_t { return m_bytes; }
+
+private:
+  template <typename T>
+  auto writeText(const T *const *channels, uint32_t n) -> bool;
+  template <typename T>
+  auto writeBinary(const T *const *channels, uint32_t n) -> bool;
+  auto reserve(uint32_t size) -> char *;
+  auto append(const void *data, uint32_t size) -> bool;
+  auto isText() const -> bool;
+
+  int m_fd;
+  CaptureFormat m_format;
+  std::vector<char> m_buffer;
+  uint32_t m_fill = 0;
+  uint16_t m_channels = 0;
+  uint64_t m_row = 0;
+  int m_precision = -1;
+  bool m_index = false;
+  bool m_failed = false;
+  int m_error = 0;
+  uint64_t m_bytes = 0;
+};
+
+/* Parses csv, tsv, ssv, raw or rpcap */
+auto captureParseFormat(const char *name, CaptureFormat *format) -> bool;
+
+/* Opens an output target: "-" is stdout, "tcp:host:port" connects a
+ * socket, anything else is created as a file (a FIFO works too).
+ * Ignores SIGPIPE, so writing to a closed pipe or socket fails with EPIPE
+ * instead of killing the process. Returns -1 on failure. */
+auto captureOpenOutput(const char *target) -> int;
@@ -0,0 +1,186 @@
+/* Red Pitaya C++ examples - reciprocal frequency counter */
+
+#include "counter.h"
+
+namespace {
+
+constexpr uint32_t LANES = 8;
+
+static_assert(COUNTER_BLOCK % LANES == 0, "block must be whole lanes");
+
+/* Range of one full block with independent lanes */
+auto blockRange(const float *__restrict x, float *min, float *max) -> void {
+  float lo[LANES], hi[LANES];
+  for (uint32_t l = 0; l < LANES; l++) {
+    lo[l] = hi[l] = x[l];
+  }
+  for (uint32_t i = LANES; i < COUNTER_BLOCK; i += LANES) {
+    for (uint32_t l = 0; l < LANES; l++) {
+      float v = x[i + l];
+      lo[l] = v < lo[l] ? v : lo[l];
+      hi[l] = v > hi[l] ? v : hi[l];
+    }
+  }
+  *min = lo[0];
+  *max = hi[0];
+  for (uint32_t l = 1; l < LANES; l++) {
+    *min = lo[l] < *min ? lo[l] : *min;
+    *max = hi[l] > *max ? hi[l] : *max;
+  }
+}
+
+} // namespace
+
+EdgeCounter::EdgeCounter(double sampleRate, float low, float high)
+    : m_rate(sampleRate), m_low(low), m_high(high), m_mid((low + high) / 2) {}
+
+auto EdgeCounter::reset() -> void {
+  m_level = Level::UNKNOWN;
+  m_index = 0;
+  m_prev = 0;
+  m_hasPrev = false;
+  m_tailCross = 0;
+  m_firstRise = m_lastRise = m_lastFall = -1;
+  m_rising = m_falling = 0;
+  m_period = RunningStats();
+  m_highWidth = RunningStats();
+  m_lowWidth = RunningStats();
+}
+
+auto EdgeCounter::process(const float *x, uint32_t n) -> void {
+  uint32_t i = 0;
+  while (i < n) {
+    uint32_t end = n - i > COUNTER_BLOCK ? i + COUNTER_BLOCK : n;
+    if (end - i == COUNTER_BLOCK && m_level != Level::UNKNOWN) {
+      float min, max;
+      blockRange(x + i, &min, &max);
+      if ((m_level == Level::LOW && max < m_high) ||
+          (m_level == Level::HIGH && min > m_low)) {
+        i = end;
+        continue;
+      }
+    }
+    scan(x, i, end);
+    i = end;
+  }
+  if (n) {
+    /* An edge armed at the end of the chunk may fire in the next one after
+     * its middle level crossing has been passed here */
+    bool above = x[n - 1] >= m_mid;
+    if ((m_level == Level::LOW && above) ||
+        (m_level == Level::HIGH && !above)) {
+      m_tailCross = edgeTime(x, n - 1);
+    }
+    m_prev = x[n - 1];
+    m_hasPrev = true;
+    m_index += n;
+  }
+}
+
+auto EdgeCounter::scan(const float *x, uint32_t begin, uint32_t end) -> void {
+  uint32_t i = begin;
+  while (i < end) {
+    if (m_level == Level::LOW) {
+      while (i < end && x[i] < m_high) {
+        i++;
+      }
+      if (i == end) {
+        break;
+      }
+      rising(edgeTime(x, i));
+      m_level = Level::HIGH;
+    } else if (m_level == Level::HIGH) {
+      while (i < end && x[i] > m_low) {
+        i++;
+      }
+      if (i == end) {
+        break;
+      }
+      falling(edgeTime(x, i));
+      m_level = Level::LOW;
+    } else if (x[i] <= m_low) {
+      m_level = Level::LOW;
+    } else if (x[i] >= m_high) {
+      m_level = Level::HIGH;
+    }
+    i++;
+  }
+}
+
+/* Walks back from the sample that fired the edge to the middle level
+ * crossing, which may lie in an earlier chunk. */
+auto EdgeCounter::edgeTime(const float *x, uint32_t i) const -> double {
+  bool above = x[i] >= m_mid;
+  uint32_t k = i;
+  while (k > 0 && (x[k - 1] >= m_mid) == above) {
+    k--;
+  }
+  float a;
+  if (k > 0) {
+    a = x[k - 1];
+  } else if (m_hasPrev && (m_prev >= m_mid) != above) {
+    a = m_prev;
+  } else {
+    return m_tailCross;
+  }
+  double frac = (m_mid - a) / (double)(x[k] - a);
+  return (double)(m_index + k) - 1.0 + frac;
+}
+
+auto EdgeCounter::rising(double t) -> void {
+  if (m_lastRise >= 0) {
+    m_period.add((t - m_lastRise) / m_rate);
+  } else {
+    m_firstRise = t;
+  }
+  if (m_lastFall >= 0) {
+    m_lowWidth.add((t - m_lastFall) / m_rate);
+  }
+  m_lastRise = t;
+  m_rising++;
+}
+
+auto EdgeCounter::falling(double t) -> void {
+  if (m_lastRise >= 0) {
+    m_highWidth.add((t - m_lastRise) / m_rate);
+  }
+  m_lastFall = t;
+  m_falling++;
+}
+
+auto EdgeCounter::result() const -> CounterResult {
+  CounterResult r;
+  r.samples = m_index;
+  r.risingEdges = m_rising;
+  r.fallingEdges = m_falling;
+  if (m_rising > 1 && m_lastRise > m_firstRise) {
+    r.frequency = (m_rising - 1) * m_rate / (m_lastRise - m_firstRise);
+  }
+  r.period = m_period;
+  r.high = m_highWidth;
+  r.low = m_lowWidth;
+  if (m_period.count && m_highWidth.count && m_period.mean > 0) {
+    r.duty = m_highWidth.mean / m_period.mean;
+  }
+  return r;
+}
+
+auto counterThresholds(const float *x, uint32_t n, float hysteresis,
+                       float *low, float *high) -> bool {
+  if (n == 0) {
+    return false;
+  }
+  float min = x[0], max = x[0];
+  for (uint32_t i = 1; i < n; i++) {
+    min = x[i] < min ? x[i] : min;
+    max = x[i] > max ? x[i] : max;
+  }
+  if (max <= min) {
+    return false;
+  }
+  float mid = (max + min) / 2;
+  float half = (max - min) / 2;
+  *low = mid - hysteresis * half;
+  *high = mid + hysteresis * half;
+  return true;
+}
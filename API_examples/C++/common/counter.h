@@ -0,0 +1,89 @@
+/* Red Pitaya C++ examples - reciprocal frequency counter
+ *
+ * Timestamps every edge of the input instead of counting whole periods in a
+ * gate time. An edge is armed when the signal passes one hysteresis
+ * threshold and fires when it reaches the other one, so noise around the
+ * switching level does not produce extra edges. The edge time is the
+ * crossing of the middle level, linearly interpolated between the two
+ * samples around it, which gives sub-sample resolution.
+ *
+ * The frequency is the number of full periods divided by the time between
+ * the first and the last rising edge (reciprocal counting), so the
+ * resolution improves with the capture length and does not depend on where
+ * the capture starts. Period, pulse width and duty cycle statistics are
+ * collected on the way.
+ *
+ * Input can be fed in arbitrary chunks. Blocks of COUNTER_BLOCK samples
+ * that cannot contain the next edge are rejected by a vectorized min/max
+ * check and only blocks with an edge are walked sample by sample. */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "running_stats.h"
+
+#define COUNTER_BLOCK 64
+
+struct CounterResult {
+  uint64_t samples = 0;
+  uint64_t risingEdges = 0;
+  uint64_t fallingEdges = 0;
+  /* Reciprocal frequency in Hz, 0 with less than two rising edges */
+  double frequency = 0;
+  /* Rising to rising edge, in seconds */
+  RunningStats period;
+  /* Pulse widths in seconds */
+  RunningStats high;
+  RunningStats low;
+  /* Mean high width over mean period */
+  double duty = 0;
+};
+
+class EdgeCounter {
+public:
+  /* Thresholds are in the units of the samples, low < high */
+  EdgeCounter(double sampleRate, float low, float high);
+
+  auto reset() -> void;
+  auto process(const float *x, uint32_t n) -> void;
+  auto result() const -> CounterResult;
+
+private:
+  enum class Level { UNKNOWN, LOW, HIGH };
+
+  auto scan(const float *x, uint32_t begin, uint32_t end) -> void;
+  auto edgeTime(const float *x, uint32_t i) const -> double;
+  auto rising(double t) -> void;
+  auto falling(double t) -> void;
+
+  double m_rate;
+  float m_low;
+  float m_high;
+  float m_mid;
+
+  Level m_level = Level::UNKNOWN;
+  /* Absolute index of the first sample of the current chunk */
+  uint64_t m_index = 0;
+  /* Last sample of the previous chunk */
+  float m_prev = 0;
+  bool m_hasPrev = false;
+  /* Middle level crossing of an edge still pending at the end of the
+   * previous chunks */
+  double m_tailCross = 0;
+
+  /* Edge times in samples, negative until seen */
+  double m_firstRise = -1;
+  double m_lastRise = -1;
+  double m_lastFall = -1;
+  uint64_t m_rising = 0;
+  uint64_t m_falling = 0;
+  RunningStats m_period;
+  RunningStats m_highWidth;
+  RunningStats m_lowWidth;
+};
+
+/* Hysteresis thresholds around the middle of the signal range:
+ * mid -/+ hysteresis * (max - min) / 2. Returns false for a flat signal. */
+auto counterThresholds(const float *x, uint32_t n, float hysteresis,
+                       float *low, float *high) -> bool;
@@ -0,0 +1,162 @@
+/* Red Pitaya C++ examples - float to DAC code quantizer */
+
+#include "dac_quantize.h"
+
+namespace {
+
+constexpr uint32_t LANES = DAC_QUANTIZE_LANES;
+/* 1.5 * 2^23: adding and subtracting it rounds to the nearest integer
+ * (ties to even) for |x| < 2^22 */
+constexpr float ROUND_MAGIC = 12582912.0f;
+constexpr float U16_SCALE = 1.0f / 65536.0f;
+
+/* Counter based generator (murmur3 finalizer of seed + sample index): no
+ * state carried from sample to sample, so the dithered loop vectorizes
+ * like the plain one */
+inline auto noise(uint32_t seed, uint32_t index) -> uint32_t {
+  uint32_t x = seed + index;
+  x ^= x >> 16;
+  x *= 0x85ebca6bu;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35u;
+  x ^= x >> 16;
+  return x;
+}
+
+/* Difference of the two 16 bit halves, triangular on (-1, 1) */
+inline auto tpdf(uint32_t r) -> float {
+  return (float)((int32_t)(r & 0xffff) - (int32_t)(r >> 16)) * U16_SCALE;
+}
+
+inline auto roundMagic(float v) -> float {
+  return (v + ROUND_MAGIC) - ROUND_MAGIC;
+}
+
+/* A select, not a branch, so the lane loops still vectorize */
+inline auto notNan(float x) -> float { return x == x ? x : 0.0f; }
+
+} // namespace
+
+DacQuantizer::DacQuantizer(const DacFormat &format, DacDither dither,
+                           uint32_t seed)
+    : m_dither(dither), m_seed(seed * 0x9e3779b9u) {
+  uint8_t bits = format.bits < 2 ? 2 : (format.bits > 16 ? 16 : format.bits);
+  float full = (float)(1 << (bits - 1));
+  m_scale = format.gain * full;
+  m_bias = format.offset * full;
+  m_min = -(1 << (bits - 1));
+  m_max = (1 << (bits - 1)) - 1;
+}
+
+template <bool DITHER>
+auto DacQuantizer::run(const float *in, int16_t *out, uint32_t n) -> void {
+  const float *__restrict src = in;
+  int16_t *__restrict dst = out;
+  const float a = m_scale;
+  const float b = m_bias;
+  const float lo = (float)m_min;
+  const float hi = (float)m_max;
+  const uint32_t seed = m_seed;
+  const uint32_t index = m_index;
+  uint32_t low[LANES] = {};
+  uint32_t high[LANES] = {};
+
+  uint32_t i = 0;
+  for (; i + LANES <= n; i += LANES) {
+    const float *s = src + i;
+    int16_t *d = dst + i;
+    for (uint32_t l = 0; l < LANES; l++) {
+      float v = notNan(s[l]) * a + b;
+      if (DITHER) {
+        v += tpdf(noise(seed, index + i + l));
+      }
+      v = roundMagic(v);
+      low[l] += v < lo;
+      high[l] += v > hi;
+      v = v < lo ? lo : v;
+      v = v > hi ? hi : v;
+      d[l] = (int16_t)(int32_t)v;
+    }
+  }
+  for (; i < n; i++) {
+    float v = notNan(src[i]) * a + b;
+    if (DITHER) {
+      v += tpdf(noise(seed, index + i));
+    }
+    v = roundMagic(v);
+    low[0] += v < lo;
+    high[0] += v > hi;
+    v = v < lo ? lo : v;
+    v = v > hi ? hi : v;
+    dst[i] = (int16_t)(int32_t)v;
+  }
+
+  for (uint32_t l = 0; l < LANES; l++) {
+    m_stats.clippedLow += low[l];
+    m_stats.clippedHigh += high[l];
+  }
+}
+
+/* q[n] = Q(v[n] - e[n-1]), e[n] = q[n] - (v[n] - e[n-1]): the error goes
+ * through 1 - z^-1, +6 dB per octave towards Nyquist. The fed back error is
+ * limited to one LSB so a clipped sample does not ring. */
+auto DacQuantizer::shaped(const float *in, int16_t *out, uint32_t n) -> void {
+  const float a = m_scale;
+  const float b = m_bias;
+  const float lo = (float)m_min;
+  const float hi = (float)m_max;
+  float e = m_error;
+  uint64_t low = 0;
+  uint64_t high = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    float v = notNan(in[i]) * a + b - e;
+    float q = roundMagic(v + tpdf(noise(m_seed, m_index + i)));
+    low += q < lo;
+    high += q > hi;
+    q = q < lo ? lo : q;
+    q = q > hi ? hi : q;
+    out[i] = (int16_t)(int32_t)q;
+    e = q - v;
+    e = e < -1.0f ? -1.0f : (e > 1.0f ? 1.0f : e);
+  }
+  m_error = e;
+  m_stats.clippedLow += low;
+  m_stats.clippedHigh += high;
+}
+
+auto DacQuantizer::quantize(const float *in, int16_t *out, uint32_t n)
+    -> void {
+  switch (m_dither) {
+  case DacDither::NONE:
+    run<false>(in, out, n);
+    break;
+  case DacDither::TPDF:
+    run<true>(in, out, n);
+    break;
+  case DacDither::SHAPED:
+    shaped(in, out, n);
+    break;
+  }
+  m_index += n;
+  m_stats.samples += n;
+}
+
+auto DacQuantizer::copyCodes(const int16_t *in, int16_t *out, uint32_t n)
+    -> void {
+  const int16_t *__restrict src = in;
+  int16_t *__restrict dst = out;
+  const int16_t lo = (int16_t)m_min;
+  const int16_t hi = (int16_t)m_max;
+  uint32_t low = 0;
+  uint32_t high = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    int16_t v = src[i];
+    low += v < lo;
+    high += v > hi;
+    v = v < lo ? lo : v;
+    dst[i] = v > hi ? hi : v;
+  }
+  m_stats.samples += n;
+  m_stats.clippedLow += low;
+  m_stats.clippedHigh += high;
+}
@@ -0,0 +1,71 @@
+/* Red Pitaya C++ examples - float to DAC code quantizer
+ *
+ * Converts float samples (full scale +-1) to signed DAC codes of the given
+ * width, applying the channel calibration first:
+ *   code = round((x * gain + offset) * 2^(bits - 1))
+ * and clamping to [-2^(bits - 1), 2^(bits - 1) - 1]. Samples whose rounded
+ * code is out of range are counted per direction. NaN plays as 0.
+ *
+ * Rounding uses the float magic number trick instead of lrintf(), so the
+ * plain and dithered paths are branch free lane loops that the compiler
+ * vectorizes. Dither options:
+ *   NONE   - round to nearest
+ *   TPDF   - triangular dither of +-1 LSB, decorrelates the error from
+ *            the signal
+ *   SHAPED - TPDF plus first order error feedback, which moves the
+ *            quantization noise towards Nyquist. Sequential by nature.
+ *
+ * Buffers that are already quantized can go through copyCodes(), which
+ * only clamps and counts, so a writer that takes codes skips conversion. */
+
+#pragma once
+
+#include <stdint.h>
+
+#define DAC_QUANTIZE_LANES 8
+
+enum class DacDither { NONE, TPDF, SHAPED };
+
+struct DacFormat {
+  uint8_t bits = 14;
+  /* Channel calibration, offset in full scale units */
+  float gain = 1;
+  float offset = 0;
+};
+
+struct DacQuantizeStats {
+  uint64_t samples = 0;
+  uint64_t clippedLow = 0;
+  uint64_t clippedHigh = 0;
+};
+
+class DacQuantizer {
+public:
+  explicit DacQuantizer(const DacFormat &format,
+                        DacDither dither = DacDither::NONE, uint32_t seed = 1);
+
+  auto quantize(const float *in, int16_t *out, uint32_t n) -> void;
+  auto copyCodes(const int16_t *in, int16_t *out, uint32_t n) -> void;
+
+  auto minCode() const -> int32_t { return m_min; }
+  auto maxCode() const -> int32_t { return m_max; }
+  auto stats() const -> const DacQuantizeStats & { return m_stats; }
+  auto resetStats() -> void { m_stats = DacQuantizeStats(); }
+
+private:
+  template <bool DITHER>
+  auto run(const float *in, int16_t *out, uint32_t n) -> void;
+  auto shaped(const float *in, int16_t *out, uint32_t n) -> void;
+
+  DacDither m_dither;
+  float m_scale;
+  float m_bias;
+  int32_t m_min;
+  int32_t m_max;
+  /* Dither noise is a function of the seed and the sample index */
+  uint32_t m_seed;
+  uint32_t m_index = 0;
+  /* Error fed back into the next sample by SHAPED */
+  float m_error = 0;
+  DacQuantizeStats m_stats;
+};
@@ -0,0 +1,344 @@
+/* Red Pitaya C++ examples - streaming DAC playback */
+
+#include "dac_stream.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+
+#include "rp.h"
+#include "rp_asg_axi.h"
+#include "rp_hw-profiles.h"
+#include "timing.h"
+
+namespace {
+
+/* Producer and start() poll interval while waiting for the queue */
+constexpr auto POLL = std::chrono::microseconds(500);
+/* Shortest sleep of the refill thread */
+constexpr double MIN_SLEEP_US = 20;
+
+auto queueSize(DacStreamBackend *backend, const DacStreamSettings &s)
+    -> size_t {
+  size_t ring = backend->ringSamples();
+  return s.queueSamples > ring ? s.queueSamples : ring;
+}
+
+} // namespace
+
+DacStream::DacStream(DacStreamBackend *backend,
+                     const DacStreamSettings &settings)
+    : m_backend(backend), m_queue(queueSize(backend, settings)) {
+  uint32_t segments = settings.segments < 2 ? 2 : settings.segments;
+  m_ring = backend->ringSamples();
+  m_segment = m_ring / segments;
+  m_rate = backend->dacRate();
+  if (m_segment == 0 || m_segment * segments != m_ring) {
+    fprintf(stderr, "DAC ring of %u samples can't be split in %u segments\n",
+            m_ring, segments);
+    m_segment = 0;
+  }
+  m_buffer.resize(m_segment);
+}
+
+DacStream::~DacStream() { stop(); }
+
+auto DacStream::write(const float *x, uint32_t n) -> uint32_t {
+  return m_queue.push(x, n);
+}
+
+auto DacStream::writeAll(const float *x, uint32_t n) -> bool {
+  while (n) {
+    if (m_stopped || m_failed) {
+      return false;
+    }
+    uint32_t done = m_queue.push(x, n);
+    x += done;
+    n -= done;
+    if (n) {
+      std::this_thread::sleep_for(POLL);
+    }
+  }
+  return true;
+}
+
+auto DacStream::finish() -> void { m_finished.store(true); }
+
+/* Next segment from the queue, padded with zeros. The finished flag is read
+ * before the queue, so a short read after it really is the end. */
+auto DacStream::fillSegment() -> bool {
+  uint64_t pos = m_written;
+  bool finished = m_finished.load();
+  uint32_t n = m_queue.pop(m_buffer.data(), m_segment);
+  for (uint32_t i = n; i < m_segment; i++) {
+    m_buffer[i] = 0;
+  }
+  if (n < m_segment && m_end == UINT64_MAX) {
+    if (finished) {
+      m_end = pos + n;
+    } else {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stats.underruns++;
+      m_stats.underrunSamples += m_segment - n;
+    }
+  }
+  m_written = pos + m_segment;
+  return m_backend->write(pos, m_buffer.data(), m_segment);
+}
+
+auto DacStream::refill(uint64_t played) -> bool {
+  uint64_t pos = m_written;
+  uint64_t queued = m_queue.readAvailable();
+  if (!fillSegment()) {
+    return false;
+  }
+  bool late = m_backend->played() > pos;
+  double leadMs = (double)(pos - played) / m_rate * 1e3;
+  double latencyMs = (double)(queued + pos - played) / m_rate * 1e3;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats.refills++;
+  m_stats.lateRefills += late;
+  if (m_stats.refills == 1 || leadMs < m_stats.minLeadMs) {
+    m_stats.minLeadMs = leadMs;
+  }
+  if (latencyMs > m_stats.maxLatencyMs) {
+    m_stats.maxLatencyMs = latencyMs;
+  }
+  return true;
+}
+
+auto DacStream::start() -> bool {
+  if (m_running) {
+    return true;
+  }
+  if (m_segment == 0) {
+    return false;
+  }
+  while (m_queue.readAvailable() < m_ring && !m_finished) {
+    std::this_thread::sleep_for(POLL);
+  }
+  m_written = 0;
+  m_end = UINT64_MAX;
+  m_stats = DacStreamStats();
+  for (uint32_t pos = 0; pos < m_ring; pos += m_segment) {
+    if (!fillSegment()) {
+      return false;
+    }
+  }
+  if (!m_backend->start()) {
+    return false;
+  }
+  m_started = true;
+  m_stopped = false;
+  m_done = false;
+  m_failed = false;
+  m_running = true;
+  m_thread = std::thread(&DacStream::worker, this);
+  return true;
+}
+
+auto DacStream::stop() -> void {
+  m_stopped = true;
+  m_running = false;
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  if (m_started && !m_done) {
+    m_backend->stop();
+  }
+  m_started = false;
+}
+
+auto DacStream::worker() -> void {
+  const uint64_t spare = m_ring - m_segment;
+  while (m_running) {
+    uint64_t played = m_backend->played();
+    m_played = played;
+    m_writtenNow = m_written;
+    if (played >= m_end) {
+      /* Stop before the DAC loops over the ring again */
+      m_backend->stop();
+      m_done = true;
+      break;
+    }
+    if (played >= m_written) {
+      /* The DAC overtook the writer, continue after it */
+      uint64_t next = (played / m_segment + 1) * m_segment;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stats.lateRefills++;
+      m_stats.skippedSamples += next - m_written;
+      m_written = next;
+    }
+    if (m_written - played <= spare) {
+      if (!refill(played)) {
+        m_failed = true;
+        break;
+      }
+      continue;
+    }
+    /* Half the time until the oldest segment is played out, so a late
+     * wake-up still leaves time to refill it */
+    double us = (double)(m_written - played - spare) / m_rate * 0.5e6;
+    std::this_thread::sleep_for(std::chrono::microseconds(
+        (int64_t)(us > MIN_SLEEP_US ? us : MIN_SLEEP_US)));
+  }
+  m_running = false;
+}
+
+auto DacStream::stats() -> DacStreamStats {
+  DacStreamStats s;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    s = m_stats;
+  }
+  s.played = m_played;
+  s.written = m_writtenNow;
+  s.queued = m_queue.readAvailable();
+  uint64_t ahead = s.written > s.played ? s.written - s.played : 0;
+  s.latencyMs = (double)(s.queued + ahead) / m_rate * 1e3;
+  return s;
+}
+
+auto RpDacStreamBackend::init(uint32_t decimation, uint32_t start,
+                              uint32_t samples, bool adcClock) -> bool {
+  m_ring = samples;
+  m_decimation = decimation;
+  m_adcClock = adcClock;
+  double dacBase = rp_HPGetBaseSpeedHzOrDefault();
+  double adcBase = rp_HPGetBaseFastADCSpeedHzOrDefault();
+  m_rate = dacBase / decimation;
+  m_ratio = ADC_CLOCK_DECIMATION / adcBase * dacBase / decimation;
+  m_ticksPerNs = adcBase / ADC_CLOCK_DECIMATION * 1e-9;
+  if (rp_GenAxiReserveMemory(RP_CH_1, start,
+                             start + samples * sizeof(int16_t)) != RP_OK) {
+    fprintf(stderr, "Error setting address for DMA mode for OUT1\n");
+    return false;
+  }
+  if (rp_GenAxiSetDecimationFactor(RP_CH_1, decimation) != RP_OK) {
+    fprintf(stderr, "Error setting decimation for generator\n");
+    return false;
+  }
+  if (rp_GenAxiSetEnable(RP_CH_1, true) != RP_OK) {
+    fprintf(stderr, "Error enable axi mode for OUT1\n");
+    return false;
+  }
+  rp_GenSetAmplitudeAndOffsetOrigin(RP_CH_1);
+  if (m_adcClock &&
+      (rp_AcqReset() != RP_OK ||
+       rp_AcqSetDecimationFactor(ADC_CLOCK_DECIMATION) != RP_OK)) {
+    fprintf(stderr, "Error setting up the acquisition as DAC clock\n");
+    return false;
+  }
+  return true;
+}
+
+auto RpDacStreamBackend::initRegion(uint32_t decimation, uint32_t ringSamples,
+                                    uint32_t unit, bool adcClock) -> bool {
+  uint32_t start, size;
+  if (rp_AcqAxiGetMemoryRegion(&start, &size) != RP_OK) {
+    fprintf(stderr, "Error get memory!\n");
+    return false;
+  }
+  if (ringSamples * sizeof(int16_t) > size) {
+    ringSamples = size / sizeof(int16_t);
+  }
+  uint32_t samples = ringSamples / unit * unit;
+  if (samples == 0) {
+    fprintf(stderr, "AXI region too small\n");
+    return false;
+  }
+  return init(decimation, start, samples, adcClock);
+}
+
+auto RpDacStreamBackend::release() -> void {
+  rp_GenAxiSetEnable(RP_CH_1, false);
+  rp_GenAxiReleaseMemory(RP_CH_1);
+}
+
+auto RpDacStreamBackend::write(uint64_t position, const float *data,
+                               uint32_t n) -> bool {
+  return rp_GenAxiWriteWaveformOffset(RP_CH_1, position % m_ring,
+                                      (float *)data, n) == RP_OK;
+}
+
+auto RpDacStreamBackend::start() -> bool {
+  /* The acquisition never triggers and keeps lapping its buffer */
+  if (m_adcClock && (rp_AcqStart() != RP_OK ||
+                     rp_AcqSetTriggerSrc(RP_TRIG_SRC_DISABLED) != RP_OK)) {
+    return false;
+  }
+  if (rp_GenOutEnable(RP_CH_1) != RP_OK ||
+      rp_GenTriggerOnly(RP_CH_1) != RP_OK) {
+    return false;
+  }
+  m_startNs = nowNs();
+  m_ticks = 0;
+  m_pointerNs = m_startNs;
+  return !m_adcClock || rp_AcqGetWritePointer(&m_pointer) == RP_OK;
+}
+
+auto RpDacStreamBackend::stop() -> void {
+  rp_GenOutDisable(RP_CH_1);
+  if (m_adcClock) {
+    rp_AcqStop();
+  }
+}
+
+auto RpDacStreamBackend::played() -> uint64_t {
+  int64_t now = nowNs();
+  if (!m_adcClock) {
+    return (uint64_t)((now - m_startNs) * 1e-9 * m_rate);
+  }
+  uint32_t pointer;
+  if (rp_AcqGetWritePointer(&pointer) == RP_OK) {
+    /* The pointer gives the position within a lap, the system clock how
+     * many whole laps passed since the last read */
+    uint32_t delta = (pointer + ADC_BUFFER_SIZE - m_pointer) % ADC_BUFFER_SIZE;
+    double expected = (now - m_pointerNs) * m_ticksPerNs;
+    int64_t laps = llround((expected - delta) / ADC_BUFFER_SIZE);
+    m_ticks += delta + (laps > 0 ? laps : 0) * (uint64_t)ADC_BUFFER_SIZE;
+    m_pointer = pointer;
+    m_pointerNs = now;
+  }
+  return (uint64_t)(m_ticks * m_ratio);
+}
+
+SimDacStreamBackend::SimDacStreamBackend(double rate, uint32_t ringSamples)
+    : m_rate(rate), m_ring(ringSamples), m_tag(ringSamples, UINT64_MAX) {}
+
+auto SimDacStreamBackend::write(uint64_t position, const float *,
+                                uint32_t n) -> bool {
+  consume();
+  uint32_t offset = position % m_ring;
+  for (uint32_t i = 0; i < n; i++) {
+    m_tag[offset + i] = position + i;
+  }
+  return true;
+}
+
+auto SimDacStreamBackend::start() -> bool {
+  m_startNs = nowNs();
+  m_played = 0;
+  m_running = true;
+  return true;
+}
+
+auto SimDacStreamBackend::stop() -> void {
+  consume();
+  m_running = false;
+}
+
+auto SimDacStreamBackend::played() -> uint64_t {
+  consume();
+  return m_played;
+}
+
+auto SimDacStreamBackend::consume() -> void {
+  if (!m_running) {
+    return;
+  }
+  uint64_t now = (uint64_t)((nowNs() - m_startNs) * 1e-9 * m_rate);
+  for (; m_played < now; m_played++) {
+    m_stale += m_tag[m_played % m_ring] != m_played;
+  }
+}
@@ -0,0 +1,221 @@
+/* Red Pitaya C++ examples - streaming DAC playback
+ *
+ * Plays an arbitrarily long signal from a ring in generator (AXI) memory
+ * that the DAC loops over. The ring is split into segments, two for
+ * ping-pong. A refill thread writes the next samples into a segment as soon
+ * as the DAC has finished playing it, so the DAC always has the rest of the
+ * ring ahead of it.
+ *
+ * Samples come from a producer (callback, file, pipe) through a lock-free
+ * SPSC queue, so the producer never waits for generator memory and the
+ * refill thread never waits for the producer. If the queue runs dry the
+ * segment is padded with zeros and counted as an underrun. If a segment is
+ * written after the DAC got to it (the refill thread was late) it is
+ * counted as a late refill; when the DAC overtakes the writer completely
+ * the writer skips ahead to the next segment boundary.
+ *
+ * Latency is the time from a sample entering the queue to it leaving the
+ * DAC: queued samples plus samples written ahead of the DAC, at the DAC
+ * rate.
+ *
+ * RpDacStreamBackend plays OUT1 from the AXI region, SimDacStreamBackend
+ * consumes a ring at the DAC rate on the system clock without hardware. */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+
+class DacStreamBackend {
+public:
+  virtual ~DacStreamBackend() = default;
+
+  /* Samples per second leaving the DAC */
+  virtual auto dacRate() -> double = 0;
+
+  /* Size of the ring the DAC loops over, in samples */
+  virtual auto ringSamples() -> uint32_t = 0;
+
+  /* Writes the samples of stream positions [position, position + n) to
+   * ring offset position % ringSamples(). Never wraps the ring. */
+  virtual auto write(uint64_t position, const float *data, uint32_t n)
+      -> bool = 0;
+
+  /* Starts looping the ring from offset 0 */
+  virtual auto start() -> bool = 0;
+  virtual auto stop() -> void = 0;
+
+  /* Samples played since start(). Called from one thread at a time. */
+  virtual auto played() -> uint64_t = 0;
+};
+
+struct DacStreamSettings {
+  /* Ring split in this many segments, 2 is ping-pong */
+  uint32_t segments = 2;
+  /* Capacity of the producer queue in samples */
+  uint32_t queueSamples = 1 << 20;
+};
+
+struct DacStreamStats {
+  uint64_t played = 0;
+  /* Stream positions written to the ring, padding included */
+  uint64_t written = 0;
+  uint64_t refills = 0;
+  /* Segments padded because the queue ran dry, and the padding */
+  uint64_t underruns = 0;
+  uint64_t underrunSamples = 0;
+  /* Segments the DAC reached before they were written */
+  uint64_t lateRefills = 0;
+  /* Samples skipped when the DAC overtook the writer */
+  uint64_t skippedSamples = 0;
+  uint64_t queued = 0;
+  /* Producer to DAC output, now and worst seen */
+  double latencyMs = 0;
+  double maxLatencyMs = 0;
+  /* Smallest time the DAC had left before reaching a segment that was
+   * being refilled */
+  double minLeadMs = 0;
+};
+
+class DacStream {
+public:
+  DacStream(DacStreamBackend *backend, const DacStreamSettings &settings);
+  ~DacStream();
+
+  /* Producer side, from one thread. write() takes what fits in the queue,
+   * writeAll() waits for space and fails once the stream stopped. */
+  auto write(const float *x, uint32_t n) -> uint32_t;
+  auto writeAll(const float *x, uint32_t n) -> bool;
+  /* End of the stream: the rest of the ring is padded with zeros and the
+   * stream is done when the last sample has played */
+  auto finish() -> void;
+
+  /* Waits until the queue can fill the ring (or the stream is finished),
+   * prefills it and starts the DAC and the refill thread */
+  auto start() -> bool;
+  auto stop() -> void;
+  auto isRunning() const -> bool { return m_running; }
+  auto done() const -> bool { return m_done; }
+  auto failed() const -> bool { return m_failed; }
+
+  auto stats() -> DacStreamStats;
+
+private:
+  auto fillSegment() -> bool;
+  auto refill(uint64_t played) -> bool;
+  auto worker() -> void;
+
+  DacStreamBackend *m_backend;
+  uint32_t m_ring = 0;
+  uint32_t m_segment = 0;
+  double m_rate = 0;
+  SpscQueue<float> m_queue;
+  std::vector<float> m_buffer;
+
+  /* Refill thread state */
+  uint64_t m_written = 0;
+  uint64_t m_end = UINT64_MAX;
+  /* Published by the refill thread for stats() */
+  std::atomic<uint64_t> m_played{0};
+  std::atomic<uint64_t> m_writtenNow{0};
+
+  std::thread m_thread;
+  bool m_started = false;
+  std::atomic<bool> m_running{false};
+  std::atomic<bool> m_stopped{false};
+  std::atomic<bool> m_finished{false};
+  std::atomic<bool> m_done{false};
+  std::atomic<bool> m_failed{false};
+  std::mutex m_mutex;
+  DacStreamStats m_stats;
+};
+
+/* OUT1 looping over a ring in the AXI region. rp_Init() and rp_Release()
+ * are up to the caller.
+ *
+ * The generator has no readable DMA position. With adcClock, played()
+ * counts on the write pointer of the (non-AXI) acquisition instead, which
+ * free-runs untriggered at ADC_CLOCK_DECIMATION on the FPGA clock that also
+ * drives the DAC, so the position does not drift against the DAC however
+ * long the stream runs. Each read of the pointer is unwrapped with the
+ * system clock, which only has to be right to half a buffer lap (67 ms at
+ * 125 MS/s) between two reads. The error is one ADC sample at that
+ * decimation (8.2 us at 125 MS/s) plus the few us between the DAC start
+ * and the first pointer read.
+ *
+ * Without adcClock (when the application uses the ADC itself) played()
+ * runs on the system clock, which drifts against the DAC by the tolerance
+ * of the two crystals: at 50 ppm that is 1 ms every 20 s, and a 67 ms
+ * segment (ping-pong ring of 256k samples at decimation 64) within 23
+ * minutes, after which underruns and late refills go undetected. Such
+ * users should track the DAC from their own ADC counter, as the loopback
+ * does. */
+#define ADC_CLOCK_DECIMATION 1024
+
+class RpDacStreamBackend : public DacStreamBackend {
+public:
+  /* samples at byte address start of the AXI region */
+  auto init(uint32_t decimation, uint32_t start, uint32_t samples,
+            bool adcClock = true) -> bool;
+  /* Up to ringSamples of the AXI region, rounded down to a multiple of
+   * unit */
+  auto initRegion(uint32_t decimation, uint32_t ringSamples, uint32_t unit,
+                  bool adcClock = true) -> bool;
+  auto release() -> void;
+
+  auto dacRate() -> double override { return m_rate; }
+  auto ringSamples() -> uint32_t override { return m_ring; }
+  auto write(uint64_t position, const float *data, uint32_t n)
+      -> bool override;
+  auto start() -> bool override;
+  auto stop() -> void override;
+  auto played() -> uint64_t override;
+
+private:
+  uint32_t m_ring = 0;
+  uint32_t m_decimation = 1;
+  double m_rate = 0;
+  bool m_adcClock = true;
+  /* DAC samples per ADC sample of the clock acquisition */
+  double m_ratio = 1;
+  /* ADC samples of the clock acquisition expected per ns */
+  double m_ticksPerNs = 0;
+  uint64_t m_ticks = 0;
+  uint32_t m_pointer = 0;
+  int64_t m_pointerNs = 0;
+  int64_t m_startNs = 0;
+};
+
+/* Plays the ring at the DAC rate on the system clock. Every ring sample
+ * remembers the stream position written to it, so a sample played before
+ * its refill shows up as stale. */
+class SimDacStreamBackend : public DacStreamBackend {
+public:
+  SimDacStreamBackend(double rate, uint32_t ringSamples);
+
+  auto dacRate() -> double override { return m_rate; }
+  auto ringSamples() -> uint32_t override { return m_ring; }
+  auto write(uint64_t position, const float *data, uint32_t n)
+      -> bool override;
+  auto start() -> bool override;
+  auto stop() -> void override;
+  auto played() -> uint64_t override;
+
+  auto stale() const -> uint64_t { return m_stale; }
+
+private:
+  auto consume() -> void;
+
+  double m_rate;
+  uint32_t m_ring;
+  std::vector<uint64_t> m_tag;
+  bool m_running = false;
+  int64_t m_startNs = 0;
+  uint64_t m_played = 0;
+  uint64_t m_stale = 0;
+};
@@ -0,0 +1,213 @@
+/* Red Pitaya C++ examples - single-bin synchronous demodulation */
+
+#include "demod.h"
+
+#include <math.h>
+
+namespace {
+
+/* Number of reference phasors advanced in parallel. Each lane sees every
+ * LANES-th sample, so the lanes have no dependency on each other. */
+constexpr uint32_t LANES = 8;
+
+/* The float lanes are re-seeded from the exact double phase after every
+ * block, which keeps the rotation error bounded for long buffers. */
+constexpr uint32_t BLOCK = 1024;
+
+struct Accum {
+  double re = 0;
+  double im = 0;
+  double sum = 0;
+};
+
+template <typename T, bool PAIR>
+auto demodKernel(const T *a, const T *b, uint32_t n, double freq, Phasor *pa,
+                 Phasor *pb) -> void {
+  const double w = 2.0 * M_PI * freq;
+  const float stepRe = (float)cos(w * LANES);
+  const float stepIm = (float)-sin(w * LANES);
+
+  Accum accA, accB;
+  double refRe = 0;
+  double refIm = 0;
+
+  uint32_t i = 0;
+  while (i + LANES <= n) {
+    float cr[LANES], ci[LANES];
+    for (uint32_t l = 0; l < LANES; l++) {
+      double phase = fmod(w * (double)(i + l), 2.0 * M_PI);
+      cr[l] = (float)cos(phase);
+      ci[l] = (float)-sin(phase);
+    }
+
+    float aRe[LANES] = {}, aIm[LANES] = {}, aSum[LANES] = {};
+    float bRe[LANES] = {}, bIm[LANES] = {}, bSum[LANES] = {};
+    float rRe[LANES] = {}, rIm[LANES] = {};
+
+    uint32_t end = i + BLOCK;
+    if (end > n) {
+      end = n - (n - i) % LANES;
+    }
+    for (; i < end; i += LANES) {
+      for (uint32_t l = 0; l < LANES; l++) {
+        float xa = (float)a[i + l];
+        aRe[l] += xa * cr[l];
+        aIm[l] += xa * ci[l];
+        aSum[l] += xa;
+        if (PAIR) {
+          float xb = (float)b[i + l];
+          bRe[l] += xb * cr[l];
+          bIm[l] += xb * ci[l];
+          bSum[l] += xb;
+        }
+        rRe[l] += cr[l];
+        rIm[l] += ci[l];
+        float nr = cr[l] * stepRe - ci[l] * stepIm;
+        float ni = cr[l] * stepIm + ci[l] * stepRe;
+        cr[l] = nr;
+        ci[l] = ni;
+      }
+    }
+
+    for (uint32_t l = 0; l < LANES; l++) {
+      accA.re += aRe[l];
+      accA.im += aIm[l];
+      accA.sum += aSum[l];
+      if (PAIR) {
+        accB.re += bRe[l];
+        accB.im += bIm[l];
+        accB.sum += bSum[l];
+      }
+      refRe += rRe[l];
+      refIm += rIm[l];
+    }
+  }
+
+  for (; i < n; i++) {
+    double phase = fmod(w * (double)i, 2.0 * M_PI);
+    double c = cos(phase);
+    double s = -sin(phase);
+    accA.re += a[i] * c;
+    accA.im += a[i] * s;
+    accA.sum += a[i];
+    if (PAIR) {
+      accB.re += b[i] * c;
+      accB.im += b[i] * s;
+      accB.sum += b[i];
+    }
+    refRe += c;
+    refIm += s;
+  }
+
+  if (n == 0) {
+    *pa = Phasor();
+    if (PAIR) {
+      *pb = Phasor();
+    }
+    return;
+  }
+
+  auto finish = [&](const Accum &acc) -> Phasor {
+    double mean = acc.sum / n;
+    Phasor p;
+    p.re = 2.0 * (acc.re - mean * refRe) / n;
+    p.im = 2.0 * (acc.im - mean * refIm) / n;
+    return p;
+  };
+  *pa = finish(accA);
+  if (PAIR) {
+    *pb = finish(accB);
+  }
+}
+
+} // namespace
+
+auto demodulate(const float *x, uint32_t n, double freq) -> Phasor {
+  Phasor p;
+  demodKernel<float, false>(x, nullptr, n, freq, &p, nullptr);
+  return p;
+}
+
+auto demodulatePair(const float *a, const float *b, uint32_t n, double freq,
+                    Phasor *pa, Phasor *pb) -> void {
+  demodKernel<float, true>(a, b, n, freq, pa, pb);
+}
+
+auto demodulatePairRaw(const int16_t *a, const int16_t *b, uint32_t n,
+                       double freq, Phasor *pa, Phasor *pb) -> void {
+  demodKernel<int16_t, true>(a, b, n, freq, pa, pb);
+}
+
+namespace {
+
+auto roundDecimation(double decimation) -> uint32_t {
+  if (decimation <= 1) {
+    return 1;
+  }
+  if (decimation <= 2) {
+    return 2;
+  }
+  if (decimation <= 4) {
+    return 4;
+  }
+  if (decimation <= 8) {
+    return 8;
+  }
+  if (decimation <= 16) {
+    return 16;
+  }
+  if (decimation >= 65536) {
+    return 65536;
+  }
+  return (uint32_t)ceil(decimation);
+}
+
+} // namespace
+
+auto planCapture(double freq, double adcRate, double periods,
+                 uint32_t minSamples, uint32_t maxSamples, uint32_t *decimation,
+                 uint32_t *samples) -> void {
+  uint32_t dec = roundDecimation(periods * adcRate / (freq * maxSamples));
+  double perPeriod = adcRate / (dec * freq);
+
+  double count = ceil(periods);
+  double forMinSamples = ceil(minSamples / perPeriod);
+  if (forMinSamples > count) {
+    count = forMinSamples;
+  }
+  if (count * perPeriod > maxSamples) {
+    count = floor(maxSamples / perPeriod);
+  }
+  if (count < 1) {
+    count = 1;
+  }
+
+  uint32_t n = (uint32_t)lround(count * perPeriod);
+  if (n > maxSamples) {
+    n = maxSamples;
+  }
+  *decimation = dec;
+  *samples = n;
+}
+
+auto phasorAbs(const Phasor &p) -> double { return hypot(p.re, p.im); }
+
+auto phasorArg(const Phasor &p) -> double { return atan2(p.im, p.re); }
+
+auto phasorDiv(const Phasor &a, const Phasor &b) -> Phasor {
+  double d = b.re * b.re + b.im * b.im;
+  Phasor r;
+  if (d == 0) {
+    return r;
+  }
+  r.re = (a.re * b.re + a.im * b.im) / d;
+  r.im = (a.im * b.re - a.re * b.im) / d;
+  return r;
+}
+
+auto phasorMulConj(const Phasor &a, const Phasor &b) -> Phasor {
+  Phasor r;
+  r.re = a.re * b.re + a.im * b.im;
+  r.im = a.im * b.re - a.re * b.im;
+  return r;
+}
@@ -0,0 +1,45 @@
+/* Red Pitaya C++ examples - single-bin synchronous demodulation
+ *
+ * Correlates captured buffers against a complex reference at one frequency.
+ * The reference is produced by rotating a set of phasors instead of calling
+ * sin()/cos() per sample, and the inner loops work on independent lanes so
+ * the compiler can vectorize them. */
+
+#pragma once
+
+#include <stdint.h>
+
+struct Phasor {
+  double re = 0;
+  double im = 0;
+};
+
+/* Demodulates x[0..n) at freq (cycles per sample, 0 < freq < 0.5).
+ * The mean of x is removed, so a DC offset does not leak into the result.
+ * The returned phasor is the peak amplitude and phase of the tone. */
+auto demodulate(const float *x, uint32_t n, double freq) -> Phasor;
+
+/* Demodulates two buffers captured at the same time with one shared
+ * reference. This is the common case for ratio measurements (FRA, LCR). */
+auto demodulatePair(const float *a, const float *b, uint32_t n, double freq,
+                    Phasor *pa, Phasor *pb) -> void;
+
+/* Same as demodulatePair() for raw int16 ADC codes. The caller scales the
+ * result to volts. */
+auto demodulatePairRaw(const int16_t *a, const int16_t *b, uint32_t n,
+                       double freq, Phasor *pa, Phasor *pb) -> void;
+
+/* Chooses an ADC decimation and a capture length holding an integer number
+ * of periods of freq, at least `periods` and at least minSamples samples,
+ * within maxSamples. The decimation is one accepted by
+ * rp_AcqSetDecimationFactor() (1, 2, 4, 8, 16 or 17 to 65536). */
+auto planCapture(double freq, double adcRate, double periods,
+                 uint32_t minSamples, uint32_t maxSamples, uint32_t *decimation,
+                 uint32_t *samples) -> void;
+
+auto phasorAbs(const Phasor &p) -> double;
+auto phasorArg(const Phasor &p) -> double;
+/* Returns a / b */
+auto phasorDiv(const Phasor &a, const Phasor &b) -> Phasor;
+/* Returns a * conj(b) */
+auto phasorMulConj(const Phasor &a, const Phasor &b) -> Phasor;
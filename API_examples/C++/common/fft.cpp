@@ -0,0 +1,85 @@
+/* Red Pitaya C++ examples - radix-2 complex FFT */
+
+#include "fft.h"
+
+#include <math.h>
+#include <utility>
+
+Fft::Fft(uint32_t size) : m_size(size) {
+  m_twRe.resize(size > 1 ? size : 2);
+  m_twIm.resize(size > 1 ? size : 2);
+  if (size < 2) {
+    return;
+  }
+  /* Last stage computed directly, the others are decimated copies of it */
+  uint32_t top = size / 2;
+  for (uint32_t j = 0; j < top; j++) {
+    double a = -M_PI * j / top;
+    m_twRe[top + j] = (float)cos(a);
+    m_twIm[top + j] = (float)sin(a);
+  }
+  for (uint32_t h = 1; h < top; h <<= 1) {
+    uint32_t stride = top / h;
+    for (uint32_t j = 0; j < h; j++) {
+      m_twRe[h + j] = m_twRe[top + j * stride];
+      m_twIm[h + j] = m_twIm[top + j * stride];
+    }
+  }
+}
+
+auto Fft::nextPow2(uint64_t n) -> uint32_t {
+  uint64_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return (uint32_t)p;
+}
+
+auto Fft::transform(float *re, float *im) const -> void {
+  const uint32_t n = m_size;
+
+  /* Bit reversal permutation with an incrementally reversed counter */
+  for (uint32_t i = 0, j = 0; i < n; i++) {
+    if (i < j) {
+      std::swap(re[i], re[j]);
+      std::swap(im[i], im[j]);
+    }
+    uint32_t bit = n >> 1;
+    while (bit && (j & bit)) {
+      j ^= bit;
+      bit >>= 1;
+    }
+    j |= bit;
+  }
+
+  for (uint32_t h = 1; h < n; h <<= 1) {
+    const float *__restrict wr = m_twRe.data() + h;
+    const float *__restrict wi = m_twIm.data() + h;
+    for (uint32_t start = 0; start < n; start += 2 * h) {
+      float *__restrict ar = re + start;
+      float *__restrict ai = im + start;
+      float *__restrict br = re + start + h;
+      float *__restrict bi = im + start + h;
+      for (uint32_t j = 0; j < h; j++) {
+        float tr = br[j] * wr[j] - bi[j] * wi[j];
+        float ti = br[j] * wi[j] + bi[j] * wr[j];
+        br[j] = ar[j] - tr;
+        bi[j] = ai[j] - ti;
+        ar[j] = ar[j] + tr;
+        ai[j] = ai[j] + ti;
+      }
+    }
+  }
+}
+
+auto Fft::forward(float *re, float *im) const -> void { transform(re, im); }
+
+auto Fft::inverse(float *re, float *im) const -> void {
+  /* ifft(x) = conj(fft(conj(x))) / N, swapping re and im does the conj */
+  transform(im, re);
+  const float scale = 1.0f / m_size;
+  for (uint32_t i = 0; i < m_size; i++) {
+    re[i] *= scale;
+    im[i] *= scale;
+  }
+}
@@ -0,0 +1,35 @@
+/* Red Pitaya C++ examples - radix-2 complex FFT
+ *
+ * Split real/imaginary arrays and per-stage contiguous twiddle tables, so
+ * each butterfly stage is a plain loop over arrays that the compiler can
+ * vectorize. Sizes must be powers of two. The twiddle tables take
+ * 8 bytes per point. */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+class Fft {
+public:
+  explicit Fft(uint32_t size);
+
+  auto size() const -> uint32_t { return m_size; }
+
+  /* In-place forward transform, X[k] = sum x[n] exp(-j 2 pi k n / N) */
+  auto forward(float *re, float *im) const -> void;
+
+  /* In-place inverse transform including the 1/N scale */
+  auto inverse(float *re, float *im) const -> void;
+
+  /* Smallest power of two >= n */
+  static auto nextPow2(uint64_t n) -> uint32_t;
+
+private:
+  auto transform(float *re, float *im) const -> void;
+
+  uint32_t m_size;
+  /* Twiddles of the stage with half length h are at [h, 2h) */
+  std::vector<float> m_twRe;
+  std::vector<float> m_twIm;
+};
@@ -0,0 +1,152 @@
+/* Red Pitaya C++ examples - frequency response analyzer (Bode sweep) */
+
+#include "fra.h"
+
+#include <math.h>
+
+#include "demod.h"
+#include "timing.h"
+
+namespace {
+
+/* Magnitude squared coherence between in and out, computed over segments
+ * that hold an integer number of periods each. */
+auto coherence(const float *in, const float *out, uint32_t n, double freq,
+               uint32_t segments) -> double {
+  double periods = n * freq;
+  uint32_t perSegment = (uint32_t)(periods / segments);
+  if (perSegment == 0) {
+    perSegment = 1;
+  }
+  uint32_t segLen = (uint32_t)lround(perSegment / freq);
+  if (segLen == 0 || segLen > n) {
+    segLen = n;
+  }
+
+  Phasor a, b;
+  Phasor sxy;
+  double sxx = 0;
+  double syy = 0;
+  for (uint32_t pos = 0; pos + segLen <= n; pos += segLen) {
+    demodulatePair(in + pos, out + pos, segLen, freq, &a, &b);
+    Phasor c = phasorMulConj(b, a);
+    sxy.re += c.re;
+    sxy.im += c.im;
+    sxx += a.re * a.re + a.im * a.im;
+    syy += b.re * b.re + b.im * b.im;
+  }
+  if (sxx == 0 || syy == 0) {
+    return 0;
+  }
+  return (sxy.re * sxy.re + sxy.im * sxy.im) / (sxx * syy);
+}
+
+auto isSettled(const Phasor &now, const Phasor &prev,
+               const FraSettings &settings) -> bool {
+  double magNow = phasorAbs(now);
+  double magPrev = phasorAbs(prev);
+  if (magNow == 0) {
+    return magPrev == 0;
+  }
+  double dPhase = (phasorArg(now) - phasorArg(prev)) * 180.0 / M_PI;
+  dPhase = fmod(fabs(dPhase), 360.0);
+  if (dPhase > 180.0) {
+    dPhase = 360.0 - dPhase;
+  }
+  return fabs(magNow - magPrev) / magNow < settings.settleMagTol &&
+         dPhase < settings.settlePhaseTol;
+}
+
+} // namespace
+
+auto fraPlanPoint(double freq, double adcRate, const FraSettings &settings,
+                  uint32_t *decimation, uint32_t *samples) -> void {
+  planCapture(freq, adcRate, settings.periods, settings.minSamples,
+              settings.maxSamples, decimation, samples);
+}
+
+auto fraFrequencies(const FraSettings &settings) -> std::vector<double> {
+  std::vector<double> freqs;
+  uint32_t n = settings.points;
+  for (uint32_t i = 0; i < n; i++) {
+    double t = n > 1 ? (double)i / (n - 1) : 0;
+    if (settings.logScale) {
+      freqs.push_back(settings.startHz *
+                      pow(settings.stopHz / settings.startHz, t));
+    } else {
+      freqs.push_back(settings.startHz +
+                      (settings.stopHz - settings.startHz) * t);
+    }
+  }
+  return freqs;
+}
+
+Fra::Fra(FraBackend *backend, const FraSettings &settings)
+    : m_backend(backend), m_settings(settings) {}
+
+auto Fra::run(std::vector<FraPoint> *points, FraStats *stats) -> bool {
+  std::vector<double> freqs = fraFrequencies(m_settings);
+  std::vector<float> in(m_settings.maxSamples);
+  std::vector<float> out(m_settings.maxSamples);
+  double rate = m_backend->adcRate();
+
+  *stats = FraStats();
+  points->clear();
+  int64_t sweepStart = nowNs();
+
+  for (size_t idx = 0; idx < freqs.size(); idx++) {
+    FraPoint pt;
+    pt.freq = freqs[idx];
+    fraPlanPoint(pt.freq, rate, m_settings, &pt.decimation, &pt.samples);
+    double norm = pt.freq * pt.decimation / rate;
+
+    int64_t setup = nowNs();
+    if (!m_backend->setFrequency(pt.freq)) {
+      return false;
+    }
+    pt.setupMs = elapsedMs(setup);
+    stats->setupMs += pt.setupMs;
+
+    Phasor prev;
+    for (uint32_t k = 1; k <= m_settings.maxCaptures; k++) {
+      int64_t t = nowNs();
+      if (!m_backend->capture(pt.decimation, pt.samples, in.data(),
+                              out.data())) {
+        return false;
+      }
+      pt.captureMs += elapsedMs(t);
+      pt.captures = k;
+      stats->captures++;
+
+      t = nowNs();
+      Phasor a, b;
+      demodulatePair(in.data(), out.data(), pt.samples, norm, &a, &b);
+      Phasor h = phasorDiv(b, a);
+      bool settled = k > 1 && k >= m_settings.minCaptures &&
+                     isSettled(h, prev, m_settings);
+      bool last = settled || k == m_settings.maxCaptures;
+      prev = h;
+      pt.processMs += elapsedMs(t);
+      if (!last) {
+        continue;
+      }
+
+      t = nowNs();
+      pt.magnitude = phasorAbs(h);
+      pt.magnitudeDb = 20.0 * log10(pt.magnitude > 0 ? pt.magnitude : 1e-12);
+      pt.phaseDeg = phasorArg(h) * 180.0 / M_PI;
+      pt.coherence = coherence(in.data(), out.data(), pt.samples, norm,
+                               m_settings.segments);
+      pt.settled = settled;
+      pt.processMs += elapsedMs(t);
+      break;
+    }
+
+    stats->captureMs += pt.captureMs;
+    stats->processMs += pt.processMs;
+    points->push_back(pt);
+  }
+
+  stats->totalMs = elapsedMs(sweepStart);
+  return true;
+}
@@ -0,0 +1,97 @@
+/* Red Pitaya C++ examples - frequency response analyzer (Bode sweep)
+ *
+ * The sweep engine steps a generator through a list of frequencies and
+ * measures the transfer function between two simultaneously captured inputs
+ * (IN1 = stimulus, IN2 = response). For every point it:
+ *   - picks decimation and capture length to hold a target number of periods,
+ *   - repeats captures until successive estimates agree (settling detection)
+ *     instead of sleeping a fixed time.
+ * The time of a point goes into those captures; the generator change is
+ * short next to them, and the next point's captures cannot start before it
+ * settles, so the sweep is strictly sequential.
+ *
+ * Hardware access goes through FraBackend, so the same engine runs against
+ * the Red Pitaya API or against a simulated device. */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+class FraBackend {
+public:
+  virtual ~FraBackend() = default;
+
+  /* Undecimated ADC sample rate in Hz */
+  virtual auto adcRate() -> double = 0;
+
+  /* Changes the stimulus frequency */
+  virtual auto setFrequency(double hz) -> bool = 0;
+
+  /* Captures `samples` samples on both inputs at the given decimation. */
+  virtual auto capture(uint32_t decimation, uint32_t samples, float *in,
+                       float *out) -> bool = 0;
+};
+
+struct FraSettings {
+  double startHz = 100;
+  double stopHz = 1e6;
+  uint32_t points = 50;
+  bool logScale = true;
+  /* Number of signal periods held in each capture */
+  double periods = 10;
+  uint32_t minSamples = 2048;
+  uint32_t maxSamples = 16384;
+  /* Segments per capture used for the coherence estimate */
+  uint32_t segments = 4;
+  /* A point is settled when two successive estimates differ by less than
+   * this (relative magnitude, degrees of phase) */
+  double settleMagTol = 0.005;
+  double settlePhaseTol = 0.5;
+  uint32_t minCaptures = 2;
+  uint32_t maxCaptures = 8;
+};
+
+struct FraPoint {
+  double freq = 0;
+  double magnitude = 0;
+  double magnitudeDb = 0;
+  double phaseDeg = 0;
+  double coherence = 0;
+  uint32_t decimation = 1;
+  uint32_t samples = 0;
+  uint32_t captures = 0;
+  bool settled = false;
+  double setupMs = 0;
+  double captureMs = 0;
+  double processMs = 0;
+};
+
+struct FraStats {
+  double totalMs = 0;
+  double setupMs = 0;
+  double captureMs = 0;
+  double processMs = 0;
+  uint32_t captures = 0;
+};
+
+/* Chooses decimation and capture length for one frequency so that the
+ * capture holds an integer number of periods, at least settings.periods
+ * (see planCapture()). */
+auto fraPlanPoint(double freq, double adcRate, const FraSettings &settings,
+                  uint32_t *decimation, uint32_t *samples) -> void;
+
+/* Frequencies of the sweep (linear or logarithmic) */
+auto fraFrequencies(const FraSettings &settings) -> std::vector<double>;
+
+class Fra {
+public:
+  Fra(FraBackend *backend, const FraSettings &settings);
+
+  /* Runs the whole sweep. Returns false if the backend failed. */
+  auto run(std::vector<FraPoint> *points, FraStats *stats) -> bool;
+
+private:
+  FraBackend *m_backend;
+  FraSettings m_settings;
+};
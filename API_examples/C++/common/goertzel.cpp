@@ -0,0 +1,127 @@
+/* Red Pitaya C++ examples - multi-tone Goertzel detector bank */
+
+#include "goertzel.h"
+
+#include <math.h>
+
+namespace {
+
+constexpr uint32_t LANES = 8;
+
+} // namespace
+
+GoertzelBank::GoertzelBank(const std::vector<double> &freqs)
+    : m_tones(freqs.size()),
+      m_padded((freqs.size() + LANES - 1) / LANES * LANES),
+      m_omega(freqs.size()), m_coeff(m_padded, 0.0), m_s1(m_padded, 0.0),
+      m_s2(m_padded, 0.0), m_acc(freqs.size()) {
+  for (uint32_t t = 0; t < m_tones; t++) {
+    m_omega[t] = 2.0 * M_PI * freqs[t];
+    m_coeff[t] = 2.0 * cos(m_omega[t]);
+  }
+}
+
+auto GoertzelBank::reset() -> void {
+  for (uint32_t t = 0; t < m_padded; t++) {
+    m_s1[t] = 0;
+    m_s2[t] = 0;
+  }
+  for (auto &acc : m_acc) {
+    acc = Phasor();
+  }
+  m_blockFill = 0;
+  m_blockStart = 0;
+  m_samples = 0;
+}
+
+/* DFT bin of the current block, referred to global sample 0.
+ * After N samples y = s1 - exp(-jw) * s2 = sum x[m] exp(jw(N - 1 - m)), so
+ * rotating by exp(-jw(start + N - 1)) gives sum x[m] exp(-jw(start + m)). */
+auto GoertzelBank::partial(uint32_t tone) const -> Phasor {
+  Phasor r;
+  if (m_blockFill == 0) {
+    return r;
+  }
+  double w = m_omega[tone];
+  double yr = m_s1[tone] - cos(w) * m_s2[tone];
+  double yi = sin(w) * m_s2[tone];
+  double phase = fmod(w * (double)(m_blockStart + m_blockFill - 1), 2 * M_PI);
+  double c = cos(phase);
+  double s = -sin(phase);
+  r.re = yr * c - yi * s;
+  r.im = yr * s + yi * c;
+  return r;
+}
+
+auto GoertzelBank::fold() -> void {
+  for (uint32_t t = 0; t < m_tones; t++) {
+    Phasor p = partial(t);
+    m_acc[t].re += p.re;
+    m_acc[t].im += p.im;
+  }
+  for (uint32_t t = 0; t < m_padded; t++) {
+    m_s1[t] = 0;
+    m_s2[t] = 0;
+  }
+  m_blockStart += m_blockFill;
+  m_blockFill = 0;
+}
+
+template <typename T> auto GoertzelBank::run(const T *x, uint32_t n) -> void {
+  const double *__restrict coeff = m_coeff.data();
+  double *__restrict s1 = m_s1.data();
+  double *__restrict s2 = m_s2.data();
+  const uint32_t padded = m_padded;
+
+  uint32_t i = 0;
+  while (i < n) {
+    uint32_t len = GOERTZEL_BLOCK - m_blockFill;
+    if (len > n - i) {
+      len = n - i;
+    }
+    for (uint32_t k = 0; k < len; k++) {
+      const double v = (double)x[i + k];
+      for (uint32_t t = 0; t < padded; t++) {
+        double s0 = v + coeff[t] * s1[t] - s2[t];
+        s2[t] = s1[t];
+        s1[t] = s0;
+      }
+    }
+    i += len;
+    m_blockFill += len;
+    m_samples += len;
+    if (m_blockFill == GOERTZEL_BLOCK) {
+      fold();
+    }
+  }
+}
+
+auto GoertzelBank::process(const float *x, uint32_t n) -> void {
+  run(x, n);
+}
+
+auto GoertzelBank::process(const int16_t *x, uint32_t n) -> void {
+  run(x, n);
+}
+
+auto GoertzelBank::phasor(uint32_t tone) const -> Phasor {
+  Phasor r;
+  if (tone >= m_tones || m_samples == 0) {
+    return r;
+  }
+  Phasor p = partial(tone);
+  r.re = 2.0 * (m_acc[tone].re + p.re) / m_samples;
+  r.im = 2.0 * (m_acc[tone].im + p.im) / m_samples;
+  return r;
+}
+
+auto GoertzelBank::amplitude(uint32_t tone) const -> double {
+  return phasorAbs(phasor(tone));
+}
+
+auto GoertzelBank::amplitudes(std::vector<double> *out) const -> void {
+  out->resize(m_tones);
+  for (uint32_t t = 0; t < m_tones; t++) {
+    (*out)[t] = amplitude(t);
+  }
+}
@@ -0,0 +1,67 @@
+/* Red Pitaya C++ examples - multi-tone Goertzel detector bank
+ *
+ * Evaluates a set of frequencies over a buffer in one pass. The filter state
+ * of all tones is kept in arrays padded to a multiple of the lane count, and
+ * the inner loop runs over tones for each sample, so every tone is one SIMD
+ * lane.
+ *
+ * The bank can be fed one buffer at a time (block mode, reset() between
+ * buffers) or a continuous stream split into arbitrary chunks: the filter
+ * state is folded into an accumulator every GOERTZEL_BLOCK samples, so
+ * precision does not degrade on long streams and results can be read at any
+ * point.
+ *
+ * The coefficients and the filter state are double: for a tone close to DC
+ * the coefficient 2 cos(w) is close to 2, and a float one would move the bin
+ * by more than its width at high bin counts. */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "demod.h"
+
+#define GOERTZEL_BLOCK 4096
+
+class GoertzelBank {
+public:
+  /* freqs are normalized to the sample rate (cycles per sample) */
+  explicit GoertzelBank(const std::vector<double> &freqs);
+
+  auto reset() -> void;
+
+  auto process(const float *x, uint32_t n) -> void;
+  /* Raw ADC codes; results are in codes, scale them by volts per code */
+  auto process(const int16_t *x, uint32_t n) -> void;
+
+  auto tones() const -> uint32_t { return m_tones; }
+  /* Samples processed since the last reset() */
+  auto samples() const -> uint64_t { return m_samples; }
+
+  /* Peak amplitude and phase of each tone over all processed samples,
+   * scaled like demodulate(). Unlike demodulate() the mean is not removed,
+   * so tones should be well away from DC. */
+  auto phasor(uint32_t tone) const -> Phasor;
+  auto amplitude(uint32_t tone) const -> double;
+  /* Amplitudes of all tones */
+  auto amplitudes(std::vector<double> *out) const -> void;
+
+private:
+  template <typename T> auto run(const T *x, uint32_t n) -> void;
+  auto fold() -> void;
+  auto partial(uint32_t tone) const -> Phasor;
+
+  uint32_t m_tones;
+  uint32_t m_padded;
+  std::vector<double> m_omega;
+  std::vector<double> m_coeff;
+  std::vector<double> m_s1;
+  std::vector<double> m_s2;
+  /* Samples in the current block */
+  uint32_t m_blockFill = 0;
+  /* Global index of the first sample of the current block */
+  uint64_t m_blockStart = 0;
+  uint64_t m_samples = 0;
+  std::vector<Phasor> m_acc;
+};
@@ -0,0 +1,90 @@
+/* Red Pitaya C++ examples - latency histogram
+ *
+ * Fixed width bins in microseconds with exact min, max and mean. The last
+ * bin counts everything beyond the range, so percentiles that land there
+ * are reported as the maximum. Values below 0 count in the first bin. */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+class LatencyHistogram {
+public:
+  explicit LatencyHistogram(double binUs = 10, uint32_t bins = 100)
+      : m_binUs(binUs > 0 ? binUs : 1), m_bins(bins ? bins : 1, 0) {}
+
+  auto add(double us) -> void {
+    if (m_count == 0 || us < m_min) {
+      m_min = us;
+    }
+    if (m_count == 0 || us > m_max) {
+      m_max = us;
+    }
+    m_count++;
+    m_sum += us;
+    double bin = us / m_binUs;
+    uint32_t last = m_bins.size() - 1;
+    m_bins[bin <= 0 ? 0 : (bin >= last ? last : (uint32_t)bin)]++;
+  }
+
+  auto count() const -> uint64_t { return m_count; }
+  auto min() const -> double { return m_min; }
+  auto max() const -> double { return m_max; }
+  auto mean() const -> double { return m_count ? m_sum / m_count : 0; }
+  auto binUs() const -> double { return m_binUs; }
+  auto bins() const -> const std::vector<uint64_t> & { return m_bins; }
+
+  /* Upper edge of the bin holding the p-th percentile (0..100) */
+  auto percentile(double p) const -> double {
+    if (m_count == 0) {
+      return 0;
+    }
+    uint64_t rank = (uint64_t)(m_count * p / 100);
+    rank = rank < 1 ? 1 : rank;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b + 1 < m_bins.size(); b++) {
+      seen += m_bins[b];
+      if (seen >= rank) {
+        double edge = (b + 1) * m_binUs;
+        return edge < m_max ? edge : m_max;
+      }
+    }
+    return m_max;
+  }
+
+  /* Non-empty bins with a bar scaled to the fullest one */
+  auto print(FILE *f) const -> void {
+    uint64_t peak = 1;
+    for (uint64_t n : m_bins) {
+      peak = n > peak ? n : peak;
+    }
+    for (uint32_t b = 0; b < m_bins.size(); b++) {
+      if (m_bins[b] == 0) {
+        continue;
+      }
+      bool overflow = b + 1 == m_bins.size();
+      fprintf(f, "%s%8.0f us %9llu %.*s\n", overflow ? ">=" : "< ",
+              overflow ? b * m_binUs : (b + 1) * m_binUs,
+              (unsigned long long)m_bins[b], (int)(50 * m_bins[b] / peak),
+              "##################################################");
+    }
+  }
+
+  auto clear() -> void {
+    m_bins.assign(m_bins.size(), 0);
+    m_count = 0;
+    m_sum = 0;
+    m_min = 0;
+    m_max = 0;
+  }
+
+private:
+  double m_binUs;
+  std::vector<uint64_t> m_bins;
+  uint64_t m_count = 0;
+  double m_sum = 0;
+  double m_min = 0;
+  double m_max = 0;
+};
@@ -0,0 +1,159 @@
+/* Red Pitaya C++ examples - LCR measurement engine */
+
+#include "lcr.h"
+
+#include <math.h>
+
+#include "timing.h"
+
+auto lcrFromImpedance(const Phasor &z, double freq) -> LcrReading {
+  LcrReading r;
+  double w = 2.0 * M_PI * freq;
+  r.freq = freq;
+  r.r = z.re;
+  r.x = z.im;
+  r.z = phasorAbs(z);
+  r.phaseDeg = phasorArg(z) * 180.0 / M_PI;
+
+  r.rs = z.re;
+  r.ls = z.im / w;
+  r.cs = z.im != 0 ? -1.0 / (w * z.im) : 0;
+
+  Phasor one;
+  one.re = 1;
+  Phasor y = phasorDiv(one, z);
+  r.rp = y.re != 0 ? 1.0 / y.re : 0;
+  r.cp = y.im / w;
+  r.lp = y.im != 0 ? -1.0 / (w * y.im) : 0;
+
+  /* D = tan(delta) is the same for the series and parallel model */
+  r.d = z.im != 0 ? fabs(z.re / z.im) : 0;
+  r.q = z.re != 0 ? fabs(z.im / z.re) : 0;
+  return r;
+}
+
+auto lcrCompute(const Phasor &v1, const Phasor &v2, double shuntOhm,
+                double freq) -> LcrReading {
+  Phasor vDut;
+  vDut.re = v1.re - v2.re;
+  vDut.im = v1.im - v2.im;
+  Phasor current;
+  current.re = v2.re / shuntOhm;
+  current.im = v2.im / shuntOhm;
+  LcrReading r = lcrFromImpedance(phasorDiv(vDut, current), freq);
+  r.amplitude = phasorAbs(v1);
+  return r;
+}
+
+LcrEngine::LcrEngine(LcrBackend *backend, const LcrSettings &settings)
+    : m_backend(backend), m_settings(settings), m_history(settings.history) {}
+
+LcrEngine::~LcrEngine() { stop(); }
+
+auto LcrEngine::configure() -> bool {
+  planCapture(m_settings.freq, m_backend->adcRate(), m_settings.periods,
+              m_settings.minSamples, m_settings.maxSamples, &m_decimation,
+              &m_samples);
+  m_v1.resize(m_samples);
+  m_v2.resize(m_samples);
+  return m_backend->setStimulus(m_settings.freq, m_settings.amplitude);
+}
+
+auto LcrEngine::takeReading(LcrReading *reading) -> bool {
+  int64_t t = nowNs();
+  if (!m_backend->capture(m_decimation, m_samples, m_v1.data(),
+                          m_v2.data())) {
+    return false;
+  }
+  double norm = m_settings.freq * m_decimation / m_backend->adcRate();
+  Phasor v1, v2;
+  demodulatePair(m_v1.data(), m_v2.data(), m_samples, norm, &v1, &v2);
+  *reading = lcrCompute(v1, v2, m_settings.shuntOhm, m_settings.freq);
+  reading->index = m_index++;
+  reading->timeNs = t;
+  return true;
+}
+
+auto LcrEngine::measure(LcrReading *reading) -> bool {
+  if (m_running) {
+    return false;
+  }
+  return configure() && takeReading(reading);
+}
+
+auto LcrEngine::start() -> bool {
+  if (m_running) {
+    return true;
+  }
+  if (!configure()) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_history.clear();
+  }
+  m_failed = false;
+  m_running = true;
+  m_thread = std::thread(&LcrEngine::worker, this);
+  return true;
+}
+
+auto LcrEngine::stop() -> void {
+  m_running = false;
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+auto LcrEngine::worker() -> void {
+  LcrReading reading;
+  while (m_running) {
+    if (!takeReading(&reading)) {
+      m_failed = true;
+      m_running = false;
+      break;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_history.push(reading);
+  }
+}
+
+auto LcrEngine::latest(LcrReading *reading) -> bool {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_history.empty()) {
+    return false;
+  }
+  *reading = m_history.at(0);
+  return true;
+}
+
+auto LcrEngine::average(uint32_t count, LcrReading *reading) -> bool {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_history.empty() || count == 0) {
+    return false;
+  }
+  if (count > m_history.size()) {
+    count = m_history.size();
+  }
+  Phasor z;
+  double amplitude = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    const LcrReading &r = m_history.at(i);
+    z.re += r.r;
+    z.im += r.x;
+    amplitude += r.amplitude;
+  }
+  z.re /= count;
+  z.im /= count;
+  const LcrReading &newest = m_history.at(0);
+  *reading = lcrFromImpedance(z, newest.freq);
+  reading->index = newest.index;
+  reading->timeNs = newest.timeNs;
+  reading->amplitude = amplitude / count;
+  return true;
+}
+
+auto LcrEngine::readings() -> uint64_t {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_history.total();
+}
@@ -0,0 +1,132 @@
+/* Red Pitaya C++ examples - LCR measurement engine
+ *
+ * Measurement circuit: OUT1 drives the device under test in series with a
+ * known shunt resistor to ground. IN1 measures the voltage at OUT1 (across
+ * DUT + shunt), IN2 measures the voltage across the shunt:
+ *
+ *   OUT1 --+-- DUT --+-- Rshunt -- GND
+ *          |         |
+ *         IN1       IN2
+ *
+ * Both inputs are demodulated at the stimulus frequency with one shared
+ * reference, then Z = (V1 - V2) / (V2 / Rshunt). */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include "demod.h"
+#include "ring_buffer.h"
+
+enum class LcrCircuit { SERIES, PARALLEL };
+
+struct LcrReading {
+  uint64_t index = 0;
+  /* Monotonic time of the capture in nanoseconds */
+  int64_t timeNs = 0;
+  double freq = 0;
+  /* Impedance */
+  double z = 0;
+  double phaseDeg = 0;
+  double r = 0;
+  double x = 0;
+  /* Series equivalent circuit */
+  double rs = 0;
+  double ls = 0;
+  double cs = 0;
+  /* Parallel equivalent circuit */
+  double rp = 0;
+  double lp = 0;
+  double cp = 0;
+  /* Dissipation and quality factor */
+  double d = 0;
+  double q = 0;
+  /* Stimulus amplitude seen on IN1 */
+  double amplitude = 0;
+};
+
+/* Derives all LCR quantities from the demodulated input phasors */
+auto lcrCompute(const Phasor &v1, const Phasor &v2, double shuntOhm,
+                double freq) -> LcrReading;
+
+/* Derives all LCR quantities from a complex impedance */
+auto lcrFromImpedance(const Phasor &z, double freq) -> LcrReading;
+
+class LcrBackend {
+public:
+  virtual ~LcrBackend() = default;
+
+  virtual auto adcRate() -> double = 0;
+
+  /* Starts the stimulus at the given frequency and amplitude */
+  virtual auto setStimulus(double hz, double amplitude) -> bool = 0;
+
+  /* Captures `samples` samples on IN1 and IN2 at the given decimation */
+  virtual auto capture(uint32_t decimation, uint32_t samples, float *v1,
+                       float *v2) -> bool = 0;
+};
+
+struct LcrSettings {
+  double freq = 1000;
+  double amplitude = 0.5;
+  double shuntOhm = 1000;
+  /* Equivalent circuit reported as the primary result */
+  LcrCircuit circuit = LcrCircuit::SERIES;
+  /* Periods of the stimulus in every capture */
+  double periods = 10;
+  uint32_t minSamples = 1024;
+  uint32_t maxSamples = 16384;
+  /* Readings kept in the result ring buffer */
+  uint32_t history = 1024;
+};
+
+class LcrEngine {
+public:
+  LcrEngine(LcrBackend *backend, const LcrSettings &settings);
+  ~LcrEngine();
+
+  /* Sets the stimulus and takes a single reading */
+  auto measure(LcrReading *reading) -> bool;
+
+  /* Continuous mode: a worker thread captures back to back and pushes every
+   * reading into the result ring buffer. */
+  auto start() -> bool;
+  auto stop() -> void;
+  auto isRunning() const -> bool { return m_running; }
+
+  /* Newest reading. Returns false if there is none yet. */
+  auto latest(LcrReading *reading) -> bool;
+
+  /* Average of the newest `count` readings. The impedance is averaged as a
+   * complex value and the derived quantities are computed from it. */
+  auto average(uint32_t count, LcrReading *reading) -> bool;
+
+  /* Total number of readings taken in continuous mode */
+  auto readings() -> uint64_t;
+
+  /* Last backend error seen by the worker thread */
+  auto failed() const -> bool { return m_failed; }
+
+private:
+  auto configure() -> bool;
+  auto takeReading(LcrReading *reading) -> bool;
+  auto worker() -> void;
+
+  LcrBackend *m_backend;
+  LcrSettings m_settings;
+  uint32_t m_decimation = 1;
+  uint32_t m_samples = 0;
+  std::vector<float> m_v1;
+  std::vector<float> m_v2;
+  uint64_t m_index = 0;
+
+  std::thread m_thread;
+  std::atomic<bool> m_running{false};
+  std::atomic<bool> m_failed{false};
+  std::mutex m_mutex;
+  RingBuffer<LcrReading> m_history;
+};
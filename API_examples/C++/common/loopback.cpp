@@ -0,0 +1,214 @@
+/* Red Pitaya C++ examples - real-time ADC to DAC loopback */
+
+#include "loopback.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "realtime.h"
+#include "timing.h"
+
+namespace {
+
+/* Shortest sleep while waiting for the ADC */
+constexpr int64_t POLL_NS = 20000;
+
+auto sleepUntil(int64_t ns) -> void {
+  struct timespec ts;
+  ts.tv_sec = ns / 1000000000LL;
+  ts.tv_nsec = ns % 1000000000LL;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+         EINTR) {
+  }
+}
+
+} // namespace
+
+Loopback::Loopback(AdcStreamBackend *adc, DacStreamBackend *dac,
+                   LoopbackStage *stage, const LoopbackSettings &settings)
+    : m_adc(adc), m_dac(dac), m_stage(stage), m_settings(settings) {
+  m_rate = adc->adcRate();
+  m_block = settings.blockSamples;
+  m_delay = (uint64_t)(settings.delayBlocks < 2 ? 2 : settings.delayBlocks) *
+            m_block;
+  m_in.resize(m_block);
+  m_out.resize(m_block);
+}
+
+Loopback::~Loopback() { stop(); }
+
+auto Loopback::start() -> bool {
+  if (m_running) {
+    return true;
+  }
+  uint32_t dacRing = m_dac->ringSamples();
+  if (m_block == 0 || m_block * 2 > m_adc->ringSamples() ||
+      m_delay + 2 * m_block > dacRing) {
+    fprintf(stderr,
+            "Blocks of %u samples %llu apart don't fit ADC ring %u and DAC "
+            "ring %u\n",
+            m_block, (unsigned long long)m_delay, m_adc->ringSamples(),
+            dacRing);
+    return false;
+  }
+  if (m_dac->dacRate() != m_rate) {
+    fprintf(stderr, "ADC and DAC rates differ\n");
+    return false;
+  }
+
+  /* Until the first block arrives the DAC plays silence */
+  std::fill(m_out.begin(), m_out.end(), 0.0f);
+  for (uint64_t pos = 0; pos < dacRing; pos += m_block) {
+    if (!writeBlock(pos)) {
+      return false;
+    }
+  }
+
+  m_stats = LoopbackStats();
+  m_stats.turnaround =
+      LatencyHistogram(m_settings.histogramBinUs, m_settings.histogramBins);
+  if (!m_adc->start()) {
+    return false;
+  }
+  if (!m_dac->start()) {
+    m_adc->stop();
+    return false;
+  }
+  m_dacOffset = m_adc->captured();
+  m_stats.latencyMs = (m_dacOffset + m_delay) / m_rate * 1e3;
+  m_stats.minMarginUs = m_delay / m_rate * 1e6;
+
+  m_stopped = false;
+  m_failed = false;
+  m_running = true;
+  m_thread = std::thread([this] { worker(); });
+  return true;
+}
+
+auto Loopback::stop() -> void {
+  if (!m_running) {
+    return;
+  }
+  m_stopped = true;
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  m_dac->stop();
+  m_adc->stop();
+  m_running = false;
+}
+
+auto Loopback::stats() -> LoopbackStats {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+auto Loopback::readBlock(uint64_t position) -> bool {
+  uint32_t ring = m_adc->ringSamples();
+  uint32_t first = ring - position % ring;
+  first = first < m_block ? first : m_block;
+  bool ok = m_adc->read(position, m_in.data(), first);
+  if (first < m_block) {
+    ok = ok && m_adc->read(position + first, m_in.data() + first,
+                           m_block - first);
+  }
+  return ok;
+}
+
+auto Loopback::writeBlock(uint64_t position) -> bool {
+  uint32_t ring = m_dac->ringSamples();
+  uint32_t first = ring - position % ring;
+  first = first < m_block ? first : m_block;
+  bool ok = m_dac->write(position, m_out.data(), first);
+  if (first < m_block) {
+    ok = ok && m_dac->write(position + first, m_out.data() + first,
+                            m_block - first);
+  }
+  return ok;
+}
+
+auto Loopback::dacPosition(uint64_t captured) const -> uint64_t {
+  return captured > m_dacOffset ? captured - m_dacOffset : 0;
+}
+
+auto Loopback::worker() -> void {
+  bool realtime = makeThreadRealtime(m_settings.priority, m_settings.cpu) &&
+                  m_settings.priority > 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.realtime = realtime;
+  }
+  uint32_t adcRing = m_adc->ringSamples();
+  uint64_t pos = 0;
+
+  while (!m_stopped) {
+    /* Sleep for the samples the block still misses */
+    uint64_t captured = m_adc->captured();
+    while (captured < pos + m_block && !m_stopped) {
+      int64_t missingNs = (int64_t)((pos + m_block - captured) / m_rate * 1e9);
+      sleepUntil(nowNs() + std::max(missingNs, POLL_NS));
+      captured = m_adc->captured();
+    }
+    if (m_stopped) {
+      break;
+    }
+    /* When the last sample of the block arrived */
+    int64_t ready =
+        nowNs() - (int64_t)((captured - pos - m_block) / m_rate * 1e9);
+
+    /* Already past the output position: skip to a block that can still
+     * make it instead of writing stale blocks one after another */
+    uint64_t played = dacPosition(captured);
+    if (played > pos + m_delay) {
+      uint64_t next = ((played - m_delay) / m_block + 1) * m_block;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stats.underruns++;
+      m_stats.skippedSamples += next - pos;
+      pos = next;
+      continue;
+    }
+
+    bool overrun = captured - pos > adcRing;
+    if (!overrun) {
+      if (!readBlock(pos)) {
+        m_failed = true;
+        break;
+      }
+      /* The ADC may have lapped the block while it was read */
+      overrun = m_adc->captured() - pos > adcRing;
+    }
+    if (overrun) {
+      /* Resume with the newest complete block */
+      uint64_t next = (captured / m_block - 1) * m_block;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stats.overruns++;
+      m_stats.skippedSamples += next > pos ? next - pos : 0;
+      pos = next > pos ? next : pos + m_block;
+      continue;
+    }
+
+    m_stage->process(m_in.data(), m_out.data(), m_block);
+    /* The DAC position when the write starts: a block it had passed by then
+     * is late, one it reaches during the write is not */
+    uint64_t q = pos + m_delay;
+    played = dacPosition(m_adc->captured());
+    if (!writeBlock(q)) {
+      m_failed = true;
+      break;
+    }
+    int64_t written = nowNs();
+    double marginUs = ((double)q - (double)played) / m_rate * 1e6;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stats.blocks++;
+      m_stats.underruns += played > q;
+      m_stats.turnaround.add((written - ready) / 1e3);
+      if (marginUs < m_stats.minMarginUs) {
+        m_stats.minMarginUs = marginUs;
+      }
+    }
+    pos += m_block;
+  }
+}
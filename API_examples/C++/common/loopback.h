@@ -0,0 +1,133 @@
+/* Red Pitaya C++ examples - real-time ADC to DAC loopback
+ *
+ * Captures continuously into an ADC ring, runs each block of blockSamples
+ * through a processing stage and writes it into the DAC ring that the
+ * generator loops over. ADC and DAC run at the same rate and are started
+ * back to back, so input position p is written to output position
+ * p + delayBlocks * blockSamples: the latency is fixed by configuration,
+ * not by how fast the thread happens to be.
+ *
+ * The generator has no readable position. ADC and DAC share the sampling
+ * clock, so the DAC position is taken as the ADC position less the samples
+ * the ADC had captured when the DAC started. Everything is paced by the
+ * ADC write pointer and nothing drifts against the system clock.
+ *
+ * One thread does the work, SCHED_FIFO and pinned if allowed. It sleeps
+ * until the ADC should have completed the next block, reads, processes
+ * and writes it.
+ * Per block it records the turnaround (block complete at the ADC to
+ * written to the DAC ring) and the margin left before the DAC reaches it.
+ * A block the DAC reached before it was written is an underrun and plays
+ * stale ring content; if the DAC is already past a block when it is due,
+ * the thread skips ahead to one it can still make. A block the ADC
+ * overwrote before it was read is an overrun and is skipped as well. */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include "dac_stream.h"
+#include "latency_histogram.h"
+
+class AdcStreamBackend {
+public:
+  virtual ~AdcStreamBackend() = default;
+
+  virtual auto adcRate() -> double = 0;
+
+  /* Size of the ring the ADC writes, in samples */
+  virtual auto ringSamples() -> uint32_t = 0;
+
+  /* Starts capturing stream position 0 at ring offset 0 */
+  virtual auto start() -> bool = 0;
+  virtual auto stop() -> void = 0;
+
+  /* Samples captured since start(). Position p can be read while
+   * captured() - p <= ringSamples(). */
+  virtual auto captured() -> uint64_t = 0;
+
+  /* Reads positions [position, position + n) from ring offset
+   * position % ringSamples(). Never wraps the ring. */
+  virtual auto read(uint64_t position, float *data, uint32_t n) -> bool = 0;
+};
+
+/* The user processing between input and output, called with one block at
+ * a time from the loopback thread */
+class LoopbackStage {
+public:
+  virtual ~LoopbackStage() = default;
+  virtual auto process(const float *in, float *out, uint32_t n) -> void = 0;
+};
+
+struct LoopbackSettings {
+  uint32_t blockSamples = 1024;
+  /* Output lags input by this many blocks, at least 2. A block is complete
+   * one block after its first sample, the thread has the rest to turn it
+   * around. */
+  uint32_t delayBlocks = 2;
+  /* SCHED_FIFO priority, 0 leaves the thread alone, and CPU, -1 for any */
+  int priority = 80;
+  int cpu = -1;
+  double histogramBinUs = 10;
+  uint32_t histogramBins = 200;
+};
+
+struct LoopbackStats {
+  uint64_t blocks = 0;
+  uint64_t underruns = 0;
+  uint64_t overruns = 0;
+  uint64_t skippedSamples = 0;
+  /* ADC input to DAC output: the block delay plus the ADC samples
+   * captured before the DAC started */
+  double latencyMs = 0;
+  /* Block complete at the ADC to written to the DAC ring */
+  LatencyHistogram turnaround;
+  /* Time the DAC still had before reaching a written block */
+  double minMarginUs = 0;
+  bool realtime = false;
+};
+
+class Loopback {
+public:
+  Loopback(AdcStreamBackend *adc, DacStreamBackend *dac, LoopbackStage *stage,
+           const LoopbackSettings &settings);
+  ~Loopback();
+
+  /* Zeroes the DAC ring, starts ADC and DAC and the loopback thread */
+  auto start() -> bool;
+  auto stop() -> void;
+  auto isRunning() const -> bool { return m_running && !m_failed; }
+  auto failed() const -> bool { return m_failed; }
+
+  auto stats() -> LoopbackStats;
+
+private:
+  auto worker() -> void;
+  /* DAC position at ADC position captured */
+  auto dacPosition(uint64_t captured) const -> uint64_t;
+  auto readBlock(uint64_t position) -> bool;
+  auto writeBlock(uint64_t position) -> bool;
+
+  AdcStreamBackend *m_adc;
+  DacStreamBackend *m_dac;
+  LoopbackStage *m_stage;
+  LoopbackSettings m_settings;
+  double m_rate = 0;
+  uint32_t m_block = 0;
+  uint64_t m_delay = 0;
+  std::vector<float> m_in;
+  std::vector<float> m_out;
+  /* ADC samples captured when the DAC started */
+  uint64_t m_dacOffset = 0;
+
+  std::thread m_thread;
+  std::atomic<bool> m_running{false};
+  std::atomic<bool> m_stopped{false};
+  std::atomic<bool> m_failed{false};
+  std::mutex m_mutex;
+  LoopbackStats m_stats;
+};
@@ -0,0 +1,33 @@
+/* Red Pitaya C++ examples - real-time thread setup */
+
+#include "realtime.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+auto makeThreadRealtime(int priority, int cpu) -> bool {
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+      fprintf(stderr, "Can't pin thread to CPU %d\n", cpu);
+    }
+  }
+  if (priority <= 0) {
+    return true;
+  }
+  struct sched_param sp;
+  sp.sched_priority = priority;
+  return pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) == 0;
+}
+
+auto lockMemory() -> bool {
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    fprintf(stderr, "mlockall failed, page faults may add latency\n");
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,13 @@
+/* Red Pitaya C++ examples - real-time thread setup */
+
+#pragma once
+
+/* Pins the calling thread to cpu (unless -1) and gives it SCHED_FIFO at
+ * priority (unless 0). Returns false if the priority could not be set,
+ * usually for lack of CAP_SYS_NICE; the thread then keeps running as a
+ * normal one. */
+auto makeThreadRealtime(int priority, int cpu) -> bool;
+
+/* mlockall() of current and future pages, so no page fault lands on a
+ * deadline. Prints a warning and returns false if it is not allowed. */
+auto lockMemory() -> bool;
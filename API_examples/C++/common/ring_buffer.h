@@ -0,0 +1,48 @@
+/* Red Pitaya C++ examples - fixed capacity ring buffer
+ *
+ * Keeps the newest `capacity` items; pushing into a full buffer overwrites
+ * the oldest one. Not synchronized, callers provide their own locking. */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+template <typename T> class RingBuffer {
+public:
+  explicit RingBuffer(size_t capacity) : m_items(capacity ? capacity : 1) {}
+
+  auto push(const T &item) -> void {
+    m_items[m_head] = item;
+    m_head = (m_head + 1) % m_items.size();
+    if (m_size < m_items.size()) {
+      m_size++;
+    }
+    m_total++;
+  }
+
+  /* Item `age` steps back from the newest one (0 = newest) */
+  auto at(size_t age) const -> const T & {
+    size_t idx = (m_head + m_items.size() - 1 - age) % m_items.size();
+    return m_items[idx];
+  }
+
+  auto size() const -> size_t { return m_size; }
+  auto capacity() const -> size_t { return m_items.size(); }
+  auto empty() const -> bool { return m_size == 0; }
+  /* Number of items pushed since construction or clear() */
+  auto total() const -> uint64_t { return m_total; }
+
+  auto clear() -> void {
+    m_head = 0;
+    m_size = 0;
+    m_total = 0;
+  }
+
+private:
+  std::vector<T> m_items;
+  size_t m_head = 0;
+  size_t m_size = 0;
+  uint64_t m_total = 0;
+};
@@ -0,0 +1,33 @@
+/* Red Pitaya C++ examples - single pass mean, deviation and range */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+/* Welford's update, stable for long runs of nearly equal values */
+struct RunningStats {
+  uint64_t count = 0;
+  double mean = 0;
+  double m2 = 0;
+  double min = 0;
+  double max = 0;
+
+  auto add(double x) -> void {
+    if (count == 0) {
+      min = max = x;
+    } else {
+      min = x < min ? x : min;
+      max = x > max ? x : max;
+    }
+    count++;
+    double d = x - mean;
+    mean += d / count;
+    m2 += d * (x - mean);
+  }
+
+  /* Sample standard deviation */
+  auto stddev() const -> double {
+    return count > 1 ? sqrt(m2 / (count - 1)) : 0;
+  }
+};
@@ -0,0 +1,104 @@
+/* Red Pitaya C++ examples - lock-free single producer, single consumer queue
+ *
+ * Bounded ring of items between exactly one producer thread and one
+ * consumer thread. The capacity is rounded up to a power of two. Head and
+ * tail are free running counters on separate cache lines, published with
+ * release stores and read with acquire loads, so items are visible before
+ * the counter that covers them. Each side keeps a copy of the other side's
+ * counter and only reloads it when the ring looks full (or empty), which
+ * keeps the shared cache line from bouncing on every call.
+ *
+ * The bulk push() and pop() copy at most two contiguous runs. */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <vector>
+
+#define SPSC_CACHE_LINE 64
+
+template <typename T> class SpscQueue {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "items are copied with memcpy");
+
+public:
+  explicit SpscQueue(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    m_items.resize(size);
+    m_mask = size - 1;
+  }
+
+  auto capacity() const -> size_t { return m_mask + 1; }
+
+  /* Producer: copies up to n items in, returns how many fitted */
+  auto push(const T *items, size_t n) -> size_t {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (capacity() - (head - m_tailCache) < n) {
+      m_tailCache = m_tail.load(std::memory_order_acquire);
+    }
+    size_t space = capacity() - (head - m_tailCache);
+    n = n < space ? n : space;
+    copyIn(head, items, n);
+    m_head.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  /* Consumer: copies up to n items out, returns how many there were */
+  auto pop(T *items, size_t n) -> size_t {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (m_headCache - tail < n) {
+      m_headCache = m_head.load(std::memory_order_acquire);
+    }
+    size_t avail = m_headCache - tail;
+    n = n < avail ? n : avail;
+    copyOut(tail, items, n);
+    m_tail.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  auto push(const T &item) -> bool { return push(&item, 1) == 1; }
+  auto pop(T *item) -> bool { return pop(item, 1) == 1; }
+
+  /* Exact on the consumer side, a lower bound anywhere else */
+  auto readAvailable() const -> size_t {
+    size_t tail = m_tail.load(std::memory_order_acquire);
+    return m_head.load(std::memory_order_acquire) - tail;
+  }
+
+  /* Exact on the producer side, a lower bound anywhere else */
+  auto writeAvailable() const -> size_t {
+    size_t head = m_head.load(std::memory_order_acquire);
+    return capacity() - (head - m_tail.load(std::memory_order_acquire));
+  }
+
+private:
+  auto copyIn(size_t pos, const T *items, size_t n) -> void {
+    size_t start = pos & m_mask;
+    size_t first = n < capacity() - start ? n : capacity() - start;
+    memcpy(&m_items[start], items, first * sizeof(T));
+    memcpy(&m_items[0], items + first, (n - first) * sizeof(T));
+  }
+
+  auto copyOut(size_t pos, T *items, size_t n) const -> void {
+    size_t start = pos & m_mask;
+    size_t first = n < capacity() - start ? n : capacity() - start;
+    memcpy(items, &m_items[start], first * sizeof(T));
+    memcpy(items + first, &m_items[0], (n - first) * sizeof(T));
+  }
+
+  std::vector<T> m_items;
+  size_t m_mask;
+  /* Written by the producer */
+  alignas(SPSC_CACHE_LINE) std::atomic<size_t> m_head{0};
+  size_t m_tailCache = 0;
+  /* Written by the consumer */
+  alignas(SPSC_CACHE_LINE) std::atomic<size_t> m_tail{0};
+  size_t m_headCache = 0;
+};
@@ -0,0 +1,97 @@
+/* Red Pitaya C++ examples - stepped frequency sweep */
+
+#include "sweep.h"
+
+#include <math.h>
+
+Sweep::Sweep(const SweepSettings &settings, double rate)
+    : m_rate(rate), m_amplitude(settings.amplitude) {
+  std::vector<SweepPoint> points;
+  if (settings.law == SweepLaw::TABLE) {
+    points = settings.table;
+  } else if (settings.steps > 0) {
+    if (settings.law == SweepLaw::LOG &&
+        (settings.start <= 0 || settings.stop <= 0)) {
+      fprintf(stderr, "Logarithmic sweep needs positive frequencies\n");
+      return;
+    }
+    uint32_t n = settings.steps;
+    for (uint32_t k = 0; k < n; k++) {
+      double x = n > 1 ? (double)k / (n - 1) : 0;
+      SweepPoint p;
+      p.frequency =
+          settings.law == SweepLaw::LOG
+              ? settings.start * pow(settings.stop / settings.start, x)
+              : settings.start + (settings.stop - settings.start) * x;
+      points.push_back(p);
+    }
+  }
+
+  uint64_t start = 0;
+  for (uint32_t k = 0; k < points.size(); k++) {
+    const SweepPoint &p = points[k];
+    double dwell = p.dwell > 0 ? p.dwell : settings.dwell;
+    if (p.frequency < 0 || p.frequency >= rate / 2 || dwell <= 0) {
+      fprintf(stderr,
+              "Sweep step %u: %g Hz for %g s is outside 0 to %g Hz or has "
+              "no dwell\n",
+              k, p.frequency, dwell, rate / 2);
+      m_steps.clear();
+      m_samples = 0;
+      return;
+    }
+    SweepStep s;
+    s.index = k;
+    s.requested = p.frequency;
+    s.tuningWord = synthStep(p.frequency, rate);
+    s.frequency = s.tuningWord * rate / 4294967296.0;
+    s.start = start;
+    double samples = llround(dwell * rate);
+    s.samples = samples < 1 ? 1 : (uint64_t)samples;
+    start += s.samples;
+    m_steps.push_back(s);
+  }
+  m_samples = start;
+}
+
+auto Sweep::render(float *out, uint32_t n) -> void {
+  if (m_steps.empty()) {
+    return;
+  }
+  const Wavetable &sine = Wavetable::sine();
+  while (n) {
+    const SweepStep &s = m_steps[m_step];
+    uint64_t left = s.start + s.samples - m_pos;
+    uint32_t k = left < n ? (uint32_t)left : n;
+    /* Only the tuning word changes, the phase carries over */
+    m_osc.step = s.tuningWord;
+    sine.render(out, k, &m_osc, m_amplitude);
+    out += k;
+    n -= k;
+    m_pos += k;
+    if (m_pos == s.start + s.samples) {
+      m_step++;
+      if (m_step == m_steps.size()) {
+        m_step = 0;
+        m_pos = 0;
+      }
+    }
+  }
+}
+
+auto Sweep::rewind() -> void {
+  m_osc = SynthOsc();
+  m_pos = 0;
+  m_step = 0;
+}
+
+auto Sweep::writeTimeline(FILE *f) const -> bool {
+  fprintf(f, "# step,start,samples,start_s,dwell_s,requested_hz,"
+             "frequency_hz\n");
+  for (const SweepStep &s : m_steps) {
+    fprintf(f, "%u,%llu,%llu,%.9f,%.9f,%.6f,%.6f\n", s.index,
+            (unsigned long long)s.start, (unsigned long long)s.samples,
+            s.start / m_rate, s.samples / m_rate, s.requested, s.frequency);
+  }
+  return !ferror(f);
+}
@@ -0,0 +1,82 @@
+/* Red Pitaya C++ examples - stepped frequency sweep
+ *
+ * A sweep is a list of steps, each a frequency held for a dwell of a whole
+ * number of samples. The steps follow a linear or logarithmic law between
+ * two frequencies or come from a table with optional per-step dwell.
+ * Samples are rendered by a single DDS phase accumulator whose tuning word
+ * changes at step boundaries, so the phase runs on without a jump from one
+ * step to the next and from the end of a pass to the start of the next.
+ *
+ * The step list doubles as a marker timeline: first sample, length and
+ * the frequency the tuning word really produces for every step, so a
+ * capture that starts with the generator can be cut per step from sample
+ * positions alone. */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "synth.h"
+
+enum class SweepLaw { LINEAR, LOG, TABLE };
+
+struct SweepPoint {
+  double frequency = 0;
+  /* Seconds, 0 for the sweep's dwell */
+  double dwell = 0;
+};
+
+struct SweepSettings {
+  SweepLaw law = SweepLaw::LOG;
+  double start = 100;
+  double stop = 100e3;
+  uint32_t steps = 50;
+  std::vector<SweepPoint> table;
+  /* Seconds per step */
+  double dwell = 0.01;
+  float amplitude = 0.8f;
+};
+
+struct SweepStep {
+  uint32_t index;
+  /* Asked for and produced by the tuning word */
+  double requested;
+  double frequency;
+  uint32_t tuningWord;
+  uint64_t start;
+  uint64_t samples;
+};
+
+class Sweep {
+public:
+  Sweep(const SweepSettings &settings, double rate);
+
+  /* False with a message on stderr if the settings give no usable step */
+  auto valid() const -> bool { return !m_steps.empty(); }
+  auto steps() const -> const std::vector<SweepStep> & { return m_steps; }
+  /* Samples in one pass */
+  auto samples() const -> uint64_t { return m_samples; }
+  auto rate() const -> double { return m_rate; }
+
+  /* Renders the next n samples, wrapping to the first step after the
+   * last, phase continuous across calls */
+  auto render(float *out, uint32_t n) -> void;
+  /* Back to the first sample, phase 0 */
+  auto rewind() -> void;
+
+  /* One CSV line per step: index, start sample, samples, start and
+   * dwell in seconds, requested and produced frequency */
+  auto writeTimeline(FILE *f) const -> bool;
+
+private:
+  double m_rate;
+  float m_amplitude;
+  std::vector<SweepStep> m_steps;
+  uint64_t m_samples = 0;
+  /* Render state */
+  SynthOsc m_osc;
+  uint64_t m_pos = 0;
+  uint32_t m_step = 0;
+};
@@ -0,0 +1,213 @@
+/* Red Pitaya C++ examples - DDS waveform synthesis */
+
+#include "synth.h"
+
+#include <math.h>
+
+#include "fft.h"
+
+namespace {
+
+constexpr uint32_t LANES = 8;
+constexpr uint32_t FRAC_BITS = 32 - SYNTH_TABLE_BITS;
+constexpr uint32_t FRAC_MASK = (1u << FRAC_BITS) - 1;
+constexpr double PHASE_SCALE = 4294967296.0;
+/* Interpolation error of harmonic h is about (2 pi h / SIZE)^2 / 8 of its
+ * amplitude, 1e-3 at this limit */
+constexpr uint32_t MAX_HARMONIC = SYNTH_TABLE_SIZE / 64;
+
+inline auto lookup(const float *__restrict table, uint32_t phase) -> float {
+  const float scale = 1.0f / (float)(1u << FRAC_BITS);
+  uint32_t idx = phase >> FRAC_BITS;
+  float frac = (float)(phase & FRAC_MASK) * scale;
+  float a = table[idx];
+  return a + frac * (table[idx + 1] - a);
+}
+
+auto wrapWord(double cycles) -> uint32_t {
+  cycles -= floor(cycles);
+  return (uint32_t)(uint64_t)llround(cycles * PHASE_SCALE);
+}
+
+/* Amplitudes coeff(k) of harmonics 1 to maxHarmonic, with Lanczos sigma
+ * factors that cut the Gibbs overshoot of a truncated series from 9 % to
+ * about 1 %, so normalizing to the peak keeps the flat parts near 1 */
+template <typename F>
+auto series(uint32_t maxHarmonic, F coeff) -> std::vector<float> {
+  if (maxHarmonic < 1) {
+    maxHarmonic = 1;
+  }
+  std::vector<float> amps(maxHarmonic);
+  for (uint32_t k = 1; k <= maxHarmonic; k++) {
+    double x = M_PI * k / (maxHarmonic + 1);
+    amps[k - 1] = (float)(coeff(k) * sin(x) / x);
+  }
+  return amps;
+}
+
+} // namespace
+
+auto synthStep(double freq, double sampleRate) -> uint32_t {
+  return wrapWord(freq / sampleRate);
+}
+
+auto synthCyclesStep(double cycles, uint32_t n) -> uint32_t {
+  return wrapWord(cycles / n);
+}
+
+auto synthPhase(double radians) -> uint32_t {
+  return wrapWord(radians / (2 * M_PI));
+}
+
+auto synthMaxHarmonic(uint32_t step, double limit) -> uint32_t {
+  /* A word above 2^31 is a negative frequency */
+  uint32_t mag = step > 0x80000000u ? 0u - step : step;
+  if (mag == 0) {
+    return MAX_HARMONIC;
+  }
+  double h = floor(limit * PHASE_SCALE / mag);
+  if (h < 1) {
+    return 1;
+  }
+  return h > MAX_HARMONIC ? MAX_HARMONIC : (uint32_t)h;
+}
+
+/* Built in the frequency domain: harmonic h with amplitude a and phase p is
+ * a sin(theta + p), so X[h] = N a / 2 (sin p - j cos p) and X[N - h] is its
+ * conjugate. One inverse FFT then gives the period for any number of
+ * harmonics. */
+auto Wavetable::harmonics(const std::vector<float> &amps,
+                          const std::vector<float> &phases) -> Wavetable {
+  const uint32_t n = SYNTH_TABLE_SIZE;
+  std::vector<float> re(n, 0.0f);
+  std::vector<float> im(n, 0.0f);
+  uint32_t count = amps.size() < n / 2 ? amps.size() : n / 2 - 1;
+  for (uint32_t h = 1; h <= count; h++) {
+    double a = 0.5 * n * amps[h - 1];
+    double p = h - 1 < phases.size() ? phases[h - 1] : 0.0;
+    re[h] = (float)(a * sin(p));
+    im[h] = (float)(-a * cos(p));
+    re[n - h] = re[h];
+    im[n - h] = -im[h];
+  }
+  Fft(n).inverse(re.data(), im.data());
+
+  Wavetable w;
+  w.m_table.resize(n + 1);
+  for (uint32_t i = 0; i < n; i++) {
+    w.m_table[i] = re[i];
+  }
+  w.m_table[n] = w.m_table[0];
+  return w;
+}
+
+auto Wavetable::sine() -> const Wavetable & {
+  static const Wavetable table = [] {
+    Wavetable w;
+    w.m_table.resize(SYNTH_TABLE_SIZE + 1);
+    for (uint32_t i = 0; i < SYNTH_TABLE_SIZE; i++) {
+      w.m_table[i] = (float)sin(2 * M_PI * i / SYNTH_TABLE_SIZE);
+    }
+    w.m_table[SYNTH_TABLE_SIZE] = 0.0f;
+    return w;
+  }();
+  return table;
+}
+
+auto Wavetable::square(uint32_t maxHarmonic) -> Wavetable {
+  Wavetable w = harmonics(series(maxHarmonic, [](uint32_t k) {
+    return k % 2 ? 4 / (M_PI * k) : 0.0;
+  }));
+  w.normalize();
+  return w;
+}
+
+auto Wavetable::saw(uint32_t maxHarmonic) -> Wavetable {
+  Wavetable w = harmonics(series(maxHarmonic, [](uint32_t k) {
+    return (k % 2 ? 2 : -2) / (M_PI * k);
+  }));
+  w.normalize();
+  return w;
+}
+
+auto Wavetable::triangle(uint32_t maxHarmonic) -> Wavetable {
+  Wavetable w = harmonics(series(maxHarmonic, [](uint32_t k) {
+    return k % 2 ? (k % 4 == 1 ? 8 : -8) / (M_PI * M_PI * k * k) : 0.0;
+  }));
+  w.normalize();
+  return w;
+}
+
+auto Wavetable::peak() const -> float {
+  float p = 0;
+  for (float v : m_table) {
+    p = fabsf(v) > p ? fabsf(v) : p;
+  }
+  return p;
+}
+
+auto Wavetable::normalize() -> void {
+  float p = peak();
+  if (p > 0) {
+    for (float &v : m_table) {
+      v /= p;
+    }
+  }
+}
+
+template <bool ADD>
+auto Wavetable::run(float *out, uint32_t n, SynthOsc *osc,
+                    float amplitude) const -> void {
+  const float *__restrict table = m_table.data();
+  float *__restrict dst = out;
+  uint32_t phase = osc->phase;
+  const uint32_t step = osc->step;
+  uint32_t offset[LANES];
+  for (uint32_t l = 0; l < LANES; l++) {
+    offset[l] = l * step;
+  }
+
+  uint32_t i = 0;
+  for (; i + LANES <= n; i += LANES) {
+    for (uint32_t l = 0; l < LANES; l++) {
+      float v = amplitude * lookup(table, phase + offset[l]);
+      dst[i + l] = ADD ? dst[i + l] + v : v;
+    }
+    phase += LANES * step;
+  }
+  for (; i < n; i++) {
+    float v = amplitude * lookup(table, phase);
+    dst[i] = ADD ? dst[i] + v : v;
+    phase += step;
+  }
+  osc->phase = phase;
+}
+
+auto Wavetable::render(float *out, uint32_t n, SynthOsc *osc,
+                       float amplitude) const -> void {
+  run<false>(out, n, osc, amplitude);
+}
+
+auto Wavetable::add(float *out, uint32_t n, SynthOsc *osc,
+                    float amplitude) const -> void {
+  run<true>(out, n, osc, amplitude);
+}
+
+/* phase(k) = phase + start k + rate k^2 / 2 in 2^-32 cycle units. The
+ * double keeps well under one unit of error for any buffer the AWG holds,
+ * and the conversion through uint64 wraps it to the accumulator width. */
+auto Wavetable::chirp(float *out, uint32_t n, uint32_t phase,
+                      double startStep, double stopStep,
+                      float amplitude) const -> uint32_t {
+  const float *__restrict table = m_table.data();
+  float *__restrict dst = out;
+  const double rate = n ? (stopStep - startStep) / n : 0.0;
+  const double base = phase;
+  for (uint32_t i = 0; i < n; i++) {
+    double k = i;
+    double p = base + k * (startStep + 0.5 * rate * k);
+    dst[i] = amplitude * lookup(table, (uint32_t)(uint64_t)p);
+  }
+  double k = n;
+  return (uint32_t)(uint64_t)(base + k * (startStep + 0.5 * rate * k));
+}
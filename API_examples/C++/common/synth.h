@@ -0,0 +1,83 @@
+/* Red Pitaya C++ examples - DDS waveform synthesis
+ *
+ * Waveforms are rendered like in a hardware DDS: a 32 bit phase accumulator
+ * advances by a tuning word per sample and its top bits index a one period
+ * table, with linear interpolation on the remaining bits. The table has
+ * SYNTH_TABLE_SIZE points, so a sine is accurate to about -150 dB, far below
+ * float and DAC resolution.
+ *
+ * Square, saw and triangle tables are built from their Fourier series up to
+ * a chosen harmonic (band-limited, no aliasing when the highest harmonic is
+ * below Nyquist), and any sum of harmonics can be tabulated the same way.
+ * Samples are written straight into the destination buffer, several phases
+ * are evaluated per loop iteration to keep the pipeline full.
+ *
+ * For a buffer that is played cyclically (arbitrary waveform, DMA), use
+ * synthCyclesStep() with a power of two length and an integer number of
+ * cycles: the tuning word is then exact and the buffer wraps without a
+ * phase jump. */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#define SYNTH_TABLE_BITS 14
+#define SYNTH_TABLE_SIZE (1u << SYNTH_TABLE_BITS)
+
+struct SynthOsc {
+  /* Full scale 2^32 is one cycle */
+  uint32_t phase = 0;
+  uint32_t step = 0;
+};
+
+/* Tuning word for a frequency, |freq| < sampleRate / 2 */
+auto synthStep(double freq, double sampleRate) -> uint32_t;
+/* Tuning word for a number of cycles in n samples */
+auto synthCyclesStep(double cycles, uint32_t n) -> uint32_t;
+/* Phase word for an angle in radians */
+auto synthPhase(double radians) -> uint32_t;
+/* Highest harmonic of a tone that stays below limit * sample rate, capped
+ * to what the table resolves */
+auto synthMaxHarmonic(uint32_t step, double limit = 0.45) -> uint32_t;
+
+class Wavetable {
+public:
+  /* amps[h - 1] and phases[h - 1] (radians, sine based) of harmonic h,
+   * missing phases are 0 */
+  static auto harmonics(const std::vector<float> &amps,
+                        const std::vector<float> &phases = {}) -> Wavetable;
+  /* Shared pure sine table */
+  static auto sine() -> const Wavetable &;
+  /* Band-limited shapes with harmonics up to maxHarmonic, Lanczos smoothed
+   * and scaled to a peak of 1. Square and triangle only have odd
+   * harmonics. */
+  static auto square(uint32_t maxHarmonic) -> Wavetable;
+  static auto saw(uint32_t maxHarmonic) -> Wavetable;
+  static auto triangle(uint32_t maxHarmonic) -> Wavetable;
+
+  /* Writes n samples of amplitude * table and advances the oscillator */
+  auto render(float *out, uint32_t n, SynthOsc *osc, float amplitude) const
+      -> void;
+  /* Same, added to what is in out */
+  auto add(float *out, uint32_t n, SynthOsc *osc, float amplitude) const
+      -> void;
+
+  /* Linear chirp from startStep to stopStep tuning words over n samples,
+   * continuing from phase. Returns the phase after the last sample. */
+  auto chirp(float *out, uint32_t n, uint32_t phase, double startStep,
+             double stopStep, float amplitude) const -> uint32_t;
+
+  /* Peak of the table, for normalizing sums of harmonics */
+  auto peak() const -> float;
+
+private:
+  Wavetable() = default;
+  auto normalize() -> void;
+  template <bool ADD>
+  auto run(float *out, uint32_t n, SynthOsc *osc, float amplitude) const
+      -> void;
+
+  /* SYNTH_TABLE_SIZE points plus a copy of the first for interpolation */
+  std::vector<float> m_table;
+};
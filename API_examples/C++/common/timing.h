@@ -0,0 +1,18 @@
+/* Red Pitaya C++ examples - monotonic time helpers used for instrumentation */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+/* Monotonic time in nanoseconds */
+inline auto nowNs() -> int64_t {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Milliseconds elapsed since a nowNs() timestamp */
+inline auto elapsedMs(int64_t startNs) -> double {
+  return (double)(nowNs() - startNs) / 1e6;
+}
@@ -0,0 +1,179 @@
+/* Red Pitaya C++ examples - content-addressed waveform cache */
+
+#include "waveform_cache.h"
+
+#include <string.h>
+
+namespace {
+
+/* A custom 64 bit multiply-rotate hash over four independent lanes. The
+ * primes and the lane round are borrowed from xxHash64, but the seeding,
+ * merge and tail differ, so its values are not xxHash64 values and must not
+ * be compared with hashes computed elsewhere. It only has to be stable
+ * within this cache. */
+constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint32_t LANES = 4;
+
+inline auto rotl(uint64_t x, int r) -> uint64_t {
+  return (x << r) | (x >> (64 - r));
+}
+
+inline auto mix(uint64_t acc, uint64_t input) -> uint64_t {
+  return rotl(acc + input * PRIME2, 31) * PRIME1;
+}
+
+} // namespace
+
+auto waveformKey(const float *data, uint32_t n) -> WaveformKey {
+  const uint8_t *p = (const uint8_t *)data;
+  uint64_t bytes = (uint64_t)n * sizeof(float);
+  uint64_t acc[LANES] = {PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1};
+
+  uint64_t i = 0;
+  for (; i + LANES * 8 <= bytes; i += LANES * 8) {
+    uint64_t w[LANES];
+    memcpy(w, p + i, sizeof(w));
+    for (uint32_t l = 0; l < LANES; l++) {
+      acc[l] = mix(acc[l], w[l]);
+    }
+  }
+  uint64_t h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) +
+               rotl(acc[3], 18);
+  for (uint32_t l = 0; l < LANES; l++) {
+    h = (h ^ mix(0, acc[l])) * PRIME1 + PRIME4;
+  }
+  h += bytes;
+  for (; i + 4 <= bytes; i += 4) {
+    uint32_t w;
+    memcpy(&w, p + i, sizeof(w));
+    h = rotl(h ^ (w * PRIME1), 23) * PRIME2 + PRIME3;
+  }
+  h ^= h >> 33;
+  h *= PRIME2;
+  h ^= h >> 29;
+  h *= PRIME3;
+  h ^= h >> 32;
+
+  WaveformKey key;
+  key.hash = h;
+  key.samples = n;
+  return key;
+}
+
+WaveformCache::WaveformCache(uint32_t slots, uint32_t slotSamples)
+    : m_slots(slots ? slots : 1), m_slotSamples(slotSamples) {}
+
+/* A few dozen slots at most, a linear scan beats any map */
+auto WaveformCache::find(const WaveformKey &key) const -> int {
+  for (uint32_t i = 0; i < m_slots.size(); i++) {
+    if (m_slots[i].valid && m_slots[i].key == key) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Empty slot first, then the least recently used one */
+auto WaveformCache::victim(bool allowPlaying) const -> int {
+  int best = -1;
+  for (uint32_t i = 0; i < m_slots.size(); i++) {
+    if ((int)i == m_playing && !allowPlaying) {
+      continue;
+    }
+    if (!m_slots[i].valid) {
+      return i;
+    }
+    if (best < 0 || m_slots[i].used < m_slots[best].used) {
+      best = i;
+    }
+  }
+  if (best < 0 && allowPlaying) {
+    best = m_playing;
+  }
+  return best;
+}
+
+auto WaveformCache::assign(int slot, const WaveformKey &key) -> void {
+  Slot &s = m_slots[slot];
+  if (s.valid) {
+    m_stats.evictions++;
+  }
+  s.key = key;
+  s.valid = true;
+  s.used = ++m_clock;
+  m_stats.uploadedSamples += key.samples;
+}
+
+auto WaveformCache::select(const WaveformKey &key, bool *upload) -> int {
+  *upload = false;
+  if (key.samples > m_slotSamples) {
+    return -1;
+  }
+  int slot = find(key);
+  if (slot >= 0) {
+    Slot &s = m_slots[slot];
+    m_stats.hits++;
+    m_stats.skippedSamples += key.samples;
+    if (s.preloaded) {
+      m_stats.preloadHits++;
+      s.preloaded = false;
+    }
+    s.used = ++m_clock;
+    return slot;
+  }
+  /* Prefer any other slot, so the output keeps playing while uploading */
+  slot = victim(m_slots.size() == 1);
+  if (slot < 0) {
+    slot = m_playing;
+  }
+  m_stats.misses++;
+  assign(slot, key);
+  m_slots[slot].preloaded = false;
+  *upload = true;
+  return slot;
+}
+
+auto WaveformCache::preload(const WaveformKey &key, bool *upload) -> int {
+  *upload = false;
+  if (key.samples > m_slotSamples) {
+    return -1;
+  }
+  int slot = find(key);
+  if (slot >= 0) {
+    m_slots[slot].used = ++m_clock;
+    return slot;
+  }
+  slot = victim(false);
+  if (slot < 0) {
+    return -1;
+  }
+  m_stats.preloads++;
+  assign(slot, key);
+  m_slots[slot].preloaded = true;
+  *upload = true;
+  return slot;
+}
+
+auto WaveformCache::setPlaying(int slot) -> void {
+  m_playing = slot;
+  if (slot >= 0 && slot < (int)m_slots.size()) {
+    m_slots[slot].used = ++m_clock;
+  }
+}
+
+auto WaveformCache::invalidate(int slot) -> void {
+  if (slot >= 0 && slot < (int)m_slots.size()) {
+    m_slots[slot].valid = false;
+    m_slots[slot].preloaded = false;
+  }
+}
+
+auto WaveformCache::clear() -> void {
+  for (auto &s : m_slots) {
+    s = Slot();
+  }
+  m_playing = -1;
+}
@@ -0,0 +1,93 @@
+/* Red Pitaya C++ examples - content-addressed waveform cache
+ *
+ * Keeps track of which waveforms are resident in generator memory, keyed by
+ * a 64 bit hash of their samples, so a sequencer that keeps switching
+ * between the same waveforms can skip uploads of data that is already
+ * there. Generator memory is modelled as equal slots: the 16k sample AWG
+ * buffer of a channel is one slot, an AXI (DMA) region holds several.
+ *
+ * select() returns the slot of a waveform that should play next. When it is
+ * resident that is a hit and only the playback pointer has to move.
+ * Otherwise the least recently used slot that is not playing is handed out
+ * and the caller uploads into it. preload() does the same for waveforms that
+ * are known to come soon, without ever touching the playing slot, so the
+ * later select() is a hit.
+ *
+ * The cache holds no samples and does no I/O. With 64 bit hashes the chance
+ * of two different waveforms in a set of a few thousand sharing a key is
+ * below 1e-12. */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+struct WaveformKey {
+  uint64_t hash = 0;
+  uint32_t samples = 0;
+
+  auto operator==(const WaveformKey &k) const -> bool {
+    return hash == k.hash && samples == k.samples;
+  }
+};
+
+/* Hash of the sample bits, cheaper than converting them for an upload */
+auto waveformKey(const float *data, uint32_t n) -> WaveformKey;
+
+struct WaveformCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  /* Hits on a slot filled by preload() that had not played yet */
+  uint64_t preloadHits = 0;
+  uint64_t preloads = 0;
+  /* Resident waveforms replaced by another one */
+  uint64_t evictions = 0;
+  uint64_t uploadedSamples = 0;
+  uint64_t skippedSamples = 0;
+};
+
+class WaveformCache {
+public:
+  WaveformCache(uint32_t slots, uint32_t slotSamples);
+
+  auto slots() const -> uint32_t { return m_slots.size(); }
+  auto slotSamples() const -> uint32_t { return m_slotSamples; }
+
+  /* Slot for the waveform that plays next, -1 if it does not fit in a
+   * slot. *upload is set when it has to be written into the slot first.
+   * With a single slot the playing waveform is replaced. */
+  auto select(const WaveformKey &key, bool *upload) -> int;
+
+  /* Slot for a waveform that will play soon, -1 if it does not fit or only
+   * the playing slot could take it. *upload as for select(). */
+  auto preload(const WaveformKey &key, bool *upload) -> int;
+
+  /* The slot that is playing now; it is not evicted by preload() */
+  auto setPlaying(int slot) -> void;
+  auto playing() const -> int { return m_playing; }
+
+  /* Forget what is in a slot, e.g. after a failed upload */
+  auto invalidate(int slot) -> void;
+  auto clear() -> void;
+
+  auto stats() const -> const WaveformCacheStats & { return m_stats; }
+  auto resetStats() -> void { m_stats = WaveformCacheStats(); }
+
+private:
+  struct Slot {
+    WaveformKey key;
+    bool valid = false;
+    bool preloaded = false;
+    uint64_t used = 0;
+  };
+
+  auto find(const WaveformKey &key) const -> int;
+  auto victim(bool allowPlaying) const -> int;
+  auto assign(int slot, const WaveformKey &key) -> void;
+
+  std::vector<Slot> m_slots;
+  uint32_t m_slotSamples;
+  int m_playing = -1;
+  uint64_t m_clock = 0;
+  WaveformCacheStats m_stats;
+};
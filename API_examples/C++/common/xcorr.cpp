@@ -0,0 +1,237 @@
+/* Red Pitaya C++ examples - cross-channel time delay estimation */
+
+#include "xcorr.h"
+
+#include <math.h>
+
+#include "fft.h"
+
+namespace {
+
+constexpr uint32_t LANES = 8;
+constexpr uint32_t BLOCK = 4096;
+/* Half width of the windowed sinc interpolator */
+constexpr int32_t SINC_TAPS = 8;
+
+/* Dot product with independent float lanes, flushed to double per block */
+auto dot(const float *__restrict a, const float *__restrict b, uint32_t n)
+    -> double {
+  double total = 0;
+  uint32_t i = 0;
+  while (i < n) {
+    uint32_t end = i + BLOCK < n ? i + BLOCK : n;
+    float acc[LANES] = {};
+    for (; i + LANES <= end; i += LANES) {
+      for (uint32_t l = 0; l < LANES; l++) {
+        acc[l] += a[i + l] * b[i + l];
+      }
+    }
+    for (; i < end; i++) {
+      acc[0] += a[i] * b[i];
+    }
+    for (uint32_t l = 0; l < LANES; l++) {
+      total += acc[l];
+    }
+  }
+  return total;
+}
+
+auto sinc(double x) -> double {
+  if (fabs(x) < 1e-9) {
+    return 1.0;
+  }
+  return sin(M_PI * x) / (M_PI * x);
+}
+
+/* Correlation between integer lags, reconstructed with a Hann windowed sinc */
+auto interpolate(const std::vector<float> &r, int32_t peak, double delta)
+    -> double {
+  double sum = 0;
+  for (int32_t m = -SINC_TAPS; m <= SINC_TAPS; m++) {
+    int32_t idx = peak + m;
+    if (idx < 0 || idx >= (int32_t)r.size()) {
+      continue;
+    }
+    double t = delta - m;
+    double window = 0.5 + 0.5 * cos(M_PI * t / (SINC_TAPS + 1));
+    sum += r[idx] * sinc(t) * window;
+  }
+  return sum;
+}
+
+auto refineParabolic(const std::vector<float> &r, int32_t peak) -> double {
+  if (peak <= 0 || peak + 1 >= (int32_t)r.size()) {
+    return 0;
+  }
+  double ym = r[peak - 1];
+  double y0 = r[peak];
+  double yp = r[peak + 1];
+  double den = ym - 2 * y0 + yp;
+  if (den == 0) {
+    return 0;
+  }
+  double delta = 0.5 * (ym - yp) / den;
+  return delta > 0.5 ? 0.5 : (delta < -0.5 ? -0.5 : delta);
+}
+
+/* Golden section search for the maximum of the interpolated correlation */
+auto refineSinc(const std::vector<float> &r, int32_t peak) -> double {
+  const double g = (sqrt(5.0) - 1) / 2;
+  double lo = -1;
+  double hi = 1;
+  double a = hi - g * (hi - lo);
+  double b = lo + g * (hi - lo);
+  double fa = interpolate(r, peak, a);
+  double fb = interpolate(r, peak, b);
+  while (hi - lo > 1e-5) {
+    if (fa > fb) {
+      hi = b;
+      b = a;
+      fb = fa;
+      a = hi - g * (hi - lo);
+      fa = interpolate(r, peak, a);
+    } else {
+      lo = a;
+      a = b;
+      fa = fb;
+      b = lo + g * (hi - lo);
+      fb = interpolate(r, peak, b);
+    }
+  }
+  return (lo + hi) / 2;
+}
+
+auto removeMean(const float *x, uint32_t n, std::vector<float> *out) -> void {
+  double sum = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    sum += x[i];
+  }
+  float mean = n ? (float)(sum / n) : 0;
+  out->resize(n);
+  for (uint32_t i = 0; i < n; i++) {
+    (*out)[i] = x[i] - mean;
+  }
+}
+
+} // namespace
+
+auto xcorrDirect(const float *x, const float *y, uint32_t n, int32_t minLag,
+                 int32_t maxLag, float *out) -> void {
+  for (int32_t k = minLag; k <= maxLag; k++) {
+    /* n ranges over [max(0, -k), min(n, n - k)) */
+    int64_t first = k < 0 ? -k : 0;
+    int64_t last = k > 0 ? (int64_t)n - k : n;
+    double r = 0;
+    if (last > first) {
+      r = dot(x + first, y + first + k, (uint32_t)(last - first));
+    }
+    out[k - minLag] = (float)r;
+  }
+}
+
+auto xcorrFft(const float *x, const float *y, uint32_t n, int32_t minLag,
+              int32_t maxLag, float *out) -> void {
+  int64_t maxAbs = -minLag > maxLag ? -minLag : maxLag;
+  Fft fft(Fft::nextPow2(n + maxAbs));
+  const uint32_t m = fft.size();
+
+  /* z = x + j y, one transform for both signals */
+  std::vector<float> re(m, 0.0f);
+  std::vector<float> im(m, 0.0f);
+  for (uint32_t i = 0; i < n; i++) {
+    re[i] = x[i];
+    im[i] = y[i];
+  }
+  fft.forward(re.data(), im.data());
+
+  /* X[k] = (Z[k] + conj(Z[-k])) / 2, Y[k] = (Z[k] - conj(Z[-k])) / 2j,
+   * P[k] = conj(X[k]) * Y[k] and P[-k] = conj(P[k]) */
+  for (uint32_t k = 0; k <= m / 2; k++) {
+    uint32_t mk = (m - k) & (m - 1);
+    float a = re[k], b = im[k];
+    float c = re[mk], d = im[mk];
+    float xr = (a + c) * 0.5f, xi = (b - d) * 0.5f;
+    float yr = (b + d) * 0.5f, yi = (c - a) * 0.5f;
+    float pr = xr * yr + xi * yi;
+    float pi = xr * yi - xi * yr;
+    re[k] = pr;
+    im[k] = pi;
+    re[mk] = pr;
+    im[mk] = -pi;
+  }
+  fft.inverse(re.data(), im.data());
+
+  for (int32_t k = minLag; k <= maxLag; k++) {
+    out[k - minLag] = re[((int64_t)k + m) % m];
+  }
+}
+
+auto xcorrDelay(const float *x, const float *y, uint32_t n,
+                const XcorrSettings &settings, XcorrResult *result) -> bool {
+  if (n < 2) {
+    return false;
+  }
+  std::vector<float> xm, ym;
+  if (settings.removeMean) {
+    removeMean(x, n, &xm);
+    removeMean(y, n, &ym);
+    x = xm.data();
+    y = ym.data();
+  }
+
+  int32_t maxLag = n - 1;
+  if (settings.maxLag > 0 && settings.maxLag < n) {
+    maxLag = settings.maxLag;
+  }
+  std::vector<float> r(2 * maxLag + 1);
+
+  bool useFft = settings.method == XcorrMethod::FFT;
+  if (settings.method == XcorrMethod::AUTO) {
+    double m = Fft::nextPow2((uint64_t)n + maxLag);
+    double fftCost = 6.0 * m * log2(m);
+    double directCost = (2.0 * maxLag + 1) * n;
+    useFft = fftCost < directCost;
+  }
+  if (useFft) {
+    xcorrFft(x, y, n, -maxLag, maxLag, r.data());
+  } else {
+    xcorrDirect(x, y, n, -maxLag, maxLag, r.data());
+  }
+
+  int32_t peak = 0;
+  for (int32_t i = 1; i < (int32_t)r.size(); i++) {
+    if (r[i] > r[peak]) {
+      peak = i;
+    }
+  }
+
+  double delta = 0;
+  double value = r[peak];
+  if (settings.refine == XcorrRefine::PARABOLIC) {
+    delta = refineParabolic(r, peak);
+  } else if (settings.refine == XcorrRefine::SINC) {
+    delta = refineSinc(r, peak);
+    value = interpolate(r, peak, delta);
+  }
+
+  double energy = sqrt(dot(x, x, n) * dot(y, y, n));
+  result->coarseLag = peak - maxLag;
+  result->lag = result->coarseLag + delta;
+  double coefficient = energy > 0 ? value / energy : 0;
+  /* Interpolation may overshoot slightly */
+  coefficient = coefficient > 1 ? 1 : (coefficient < -1 ? -1 : coefficient);
+  result->coefficient = coefficient;
+  result->usedFft = useFft;
+  return true;
+}
+
+auto xcorrStartOffset(uint32_t posX, uint32_t posY, uint32_t bufferSize)
+    -> int64_t {
+  int64_t d = ((int64_t)posY - (int64_t)posX) % (int64_t)bufferSize;
+  if (d >= (int64_t)bufferSize / 2) {
+    d -= bufferSize;
+  } else if (d < -(int64_t)bufferSize / 2) {
+    d += bufferSize;
+  }
+  return d;
+}
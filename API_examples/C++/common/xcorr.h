@@ -0,0 +1,56 @@
+/* Red Pitaya C++ examples - cross-channel time delay estimation
+ *
+ * Finds the lag d maximizing r[d] = sum x[n] * y[n + d], i.e. a positive lag
+ * means y is a delayed copy of x. Short lag ranges are computed directly
+ * with lane-parallel dot products, long ones with one packed complex FFT
+ * (x and y share a transform). The integer peak is refined to sub-sample
+ * resolution with a parabolic fit or band-limited (windowed sinc)
+ * interpolation. */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+enum class XcorrRefine { NONE, PARABOLIC, SINC };
+
+enum class XcorrMethod { AUTO, DIRECT, FFT };
+
+struct XcorrSettings {
+  /* Lags searched are [-maxLag, maxLag]; 0 searches every possible lag */
+  uint32_t maxLag = 0;
+  XcorrRefine refine = XcorrRefine::SINC;
+  XcorrMethod method = XcorrMethod::AUTO;
+  bool removeMean = true;
+};
+
+struct XcorrResult {
+  /* Refined lag in samples */
+  double lag = 0;
+  int32_t coarseLag = 0;
+  /* Normalized correlation at the peak (-1..1) */
+  double coefficient = 0;
+  bool usedFft = false;
+};
+
+/* Correlation for lags [minLag, maxLag] computed directly.
+ * out[k - minLag] = sum x[n] * y[n + k] */
+auto xcorrDirect(const float *x, const float *y, uint32_t n, int32_t minLag,
+                 int32_t maxLag, float *out) -> void;
+
+/* Same result as xcorrDirect() through an FFT of at least n + max(|lag|)
+ * points. */
+auto xcorrFft(const float *x, const float *y, uint32_t n, int32_t minLag,
+              int32_t maxLag, float *out) -> void;
+
+/* Estimates the delay of y relative to x. x and y hold n samples each. */
+auto xcorrDelay(const float *x, const float *y, uint32_t n,
+                const XcorrSettings &settings, XcorrResult *result) -> bool;
+
+/* Offset in samples between two buffers that were read starting at their
+ * channel's write pointer at trigger (posX, posY) from circular buffers of
+ * bufferSize samples whose write pointers run in lockstep (same decimation,
+ * started together). Add it to a lag measured between the buffers to get
+ * the delay between the signals. */
+auto xcorrStartOffset(uint32_t posX, uint32_t posY, uint32_t bufferSize)
+    -> int64_t;
@@ -13,6 +13,7 @@
 #include <vector>
 
 #include "common/common.h"
+#include "common/gen_config.h"
 #include "rp.h"
 #include "rp_hw-profiles.h"
 #include "rp_hw.h"
@@ -26,6 +27,7 @@
 using namespace std;
 
 list<string> g_result;
+GenConfig g_gen;
 
 struct testStep {
   rp_channel_t channel;
@@ -43,13 +45,14 @@ struct settings {
   bool testTrigSettingNow = false;
   bool testKeepArm = false;
   bool testNoise = false;
+  bool testGenSync = false;
   bool verbose = false;
   bool stopOnFail = false;
 };
 
 auto printHelp(char *prog) -> void {
   std::cout << prog
-            << "[-t1] [-t2] [-t3] [-t4] [-t5] [-a] [-d] [-b] [-v] [-s]\n";
+            << "[-t1] [-t2] [-t3] [-t4] [-t5] [-t6] [-a] [-d] [-b] [-v] [-s]\n";
 
   auto dac = getDACChannels() >= 2;
 
@@ -66,6 +69,7 @@ auto printHelp(char *prog) -> void {
                   "\t-t3 : Start test trigger setting now\n"
                   "\t-t4 : Start test keep arm\n"
                   "\t-t5 : Start a noise test on a channels\n"
+                  "\t-t6 : Start test synchronous start of both generators\n"
                   "\t-a : Start all test\n"
                   "\t-d : Enable debug register mode\n"
                   "\t-b : Show captured buffer\n"
@@ -113,12 +117,17 @@ auto parseOptions(int argc, char **argv) -> settings {
       s.testNoise = true;
     }
 
+    if (strcmp(argv[i], "-t6") == 0) {
+      s.testGenSync = true;
+    }
+
     if (strcmp(argv[i], "-a") == 0) {
       s.testTrigDelay = true;
       s.testTrig = true;
       s.testTrigSettingNow = true;
       s.testKeepArm = true;
       s.testNoise = true;
+      s.testGenSync = true;
     }
 
     if (strcmp(argv[i], "-v") == 0) {
@@ -137,14 +146,15 @@ auto startGenerator(rp_channel_t _channel, rp_waveform_t _wave, uint32_t _rate,
   Color::Modifier red(Color::FG_RED);
   Color::Modifier green(Color::FG_GREEN);
 
-  int ret = 0;
-  ret |= rp_GenReset();
-  ret |= rp_GenOffset(_channel, _offset);
-  ret |= rp_GenAmp(_channel, _volt);
-  ret |= rp_GenWaveform(_channel, _wave);
-  ret |= rp_GenFreq(_channel, _rate);
-  ret |= rp_GenOutEnable(_channel);
-  ret |= rp_GenTriggerOnly(_channel);
+  // Only the settings that differ from the previous test point are written,
+  // a running output keeps running
+  GenChannelConfig &gen = g_gen.channel(_channel);
+  gen.offset = _offset;
+  gen.amplitude = _volt;
+  gen.waveform = _wave;
+  gen.frequency = _rate;
+  gen.enabled = true;
+  int ret = g_gen.commit(_channel);
 
   if (_verbose) {
     string wave = "";
@@ -919,6 +929,96 @@ auto testNoise(settings s) -> int {
   return result;
 }
 
+auto testGenSync(settings s) -> int {
+
+  auto old_calib = rp_GetCalibrationSettings();
+  auto def_calib = rp_GetDefaultCalibrationSettings();
+  rp_CalibrationSetParams(def_calib);
+  uint32_t adcRate = getADCRate();
+  int result = 0;
+  vector<uint32_t> freq_list = {100000, 1000000, 5000000};
+
+  auto buffer =
+      rp_createBuffer(getADCChannels(), ADC_BUFFER_SIZE, true, false, false);
+  if (!buffer) {
+    printf("Can't allocate buffer\n");
+    exit(-1);
+  }
+
+  for (auto freq : freq_list) {
+    int testResult = 0;
+    string testName =
+        "Synchronous generator start. Signal freq: " + to_string(freq);
+    if (s.verbose) {
+      std::cout << testName << "\n";
+    }
+
+    // Both outputs staged, then enabled and triggered together
+    for (int ch = 0; ch < GEN_CONFIG_CHANNELS; ch++) {
+      GenChannelConfig &gen = g_gen.channel((rp_channel_t)ch);
+      gen.waveform = RP_WAVEFORM_SINE;
+      gen.frequency = freq;
+      gen.amplitude = getDACGainCh1() * 0.9;
+      gen.offset = 0;
+      gen.enabled = true;
+    }
+    testResult |= g_gen.commitSync();
+    for (int ch = 0; ch < GEN_CONFIG_CHANNELS; ch++) {
+      bool enabled = false;
+      testResult |= rp_GenOutIsEnabled((rp_channel_t)ch, &enabled);
+      if (!enabled) {
+        printf("OUT%d is not enabled after the synchronous commit\n", ch + 1);
+        testResult |= 1;
+      }
+    }
+
+    // Unchanged settings write nothing and do not restart the outputs
+    auto writes = g_gen.writes();
+    testResult |= g_gen.commitSync();
+    if (g_gen.writes() != writes) {
+      printf("Unchanged synchronous commit wrote %llu settings\n",
+             (unsigned long long)(g_gen.writes() - writes));
+      testResult |= 1;
+    }
+
+    // OUT1 runs: the same trigger check as the trigger position test, at
+    // about 32 samples a period
+    uint32_t dec = 1;
+    while (dec * 2 <= adcRate / (freq * 32)) {
+      dec *= 2;
+    }
+    testResult |= getData(RP_T_CH_1, dec, ADC_BUFFER_SIZE / 2.0, 0,
+                          RP_TRIG_SRC_CHA_PE, s.verbose, buffer);
+    auto end = buffer->size - 1;
+    bool bufferIsOk = buffer->ch_i[0][0] > buffer->ch_i[0][end] &&
+                      buffer->ch_i[0][0] >= 0 && buffer->ch_i[0][end] < 0;
+    if (s.showBuffer || !bufferIsOk) {
+      if (!bufferIsOk) {
+        printf("Fail in CHA_PE trigger after the synchronous start\n");
+      }
+      printBuffer(buffer, -5, 10);
+    }
+    testResult |= !bufferIsOk;
+
+    result |= testResult;
+    if (s.verbose || testResult) {
+      printTestResult(g_result, testName, testResult == 0);
+    }
+
+    if (s.stopOnFail && result) {
+      exit(-1);
+    }
+  }
+
+  // The other tests only drive OUT1
+  g_gen.channel(RP_CH_2).enabled = false;
+  result |= g_gen.commit(RP_CH_2);
+
+  rp_deleteBuffer(buffer);
+  rp_CalibrationSetParams(old_calib);
+  return result;
+}
+
 int main(int argc, char **argv) {
 
   int result = 0;
@@ -943,6 +1043,13 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  // The generator state is unknown after rp_InitReset(false), start from
+  // reset once; the test points then only write what changes
+  if (g_gen.reset() != RP_OK) {
+    fprintf(stderr, "Generator reset failed\n");
+    return 1;
+  }
+
   g_result.clear();
 
   if (s.testTrig && !s.noDAC) {
@@ -965,7 +1072,16 @@ int main(int argc, char **argv) {
     result |= testNoise(s);
   }
 
+  if (s.testGenSync && !s.noDAC) {
+    result |= testGenSync(s);
+  }
+
   printAllResult(g_result);
+  if (s.verbose) {
+    printf("Generator setter calls: %llu made, %llu skipped\n",
+           (unsigned long long)g_gen.writes(),
+           (unsigned long long)g_gen.skipped());
+  }
 
   rp_Release();
   return result;
@@ -0,0 +1,93 @@
+#include "gen_config.h"
+
+auto GenConfig::channel(rp_channel_t ch) -> GenChannelConfig & {
+  return m_want[ch];
+}
+
+/* Writes the fields that changed and sets *changed when anything was
+ * written. With trigger false an output that gets enabled is not triggered,
+ * the caller starts it. */
+auto GenConfig::apply(rp_channel_t ch, bool trigger, bool *changed) -> int {
+  const GenChannelConfig &w = m_want[ch];
+  GenChannelConfig &h = m_have[ch];
+  bool all = !m_known[ch];
+  int ret = RP_OK;
+  *changed = false;
+
+  auto update = [&](bool differs, auto write) {
+    if (all || differs) {
+      ret |= write();
+      m_writes++;
+      *changed = true;
+    } else {
+      m_skipped++;
+    }
+  };
+  update(w.mode != h.mode, [&] { return rp_GenMode(ch, w.mode); });
+  update(w.waveform != h.waveform,
+         [&] { return rp_GenWaveform(ch, w.waveform); });
+  update(w.frequency != h.frequency,
+         [&] { return rp_GenFreq(ch, w.frequency); });
+  update(w.amplitude != h.amplitude,
+         [&] { return rp_GenAmp(ch, w.amplitude); });
+  update(w.offset != h.offset, [&] { return rp_GenOffset(ch, w.offset); });
+  if (all || w.enabled != h.enabled) {
+    if (!w.enabled) {
+      ret |= rp_GenOutDisable(ch);
+      m_writes++;
+    } else if (trigger) {
+      ret |= rp_GenOutEnable(ch);
+      ret |= rp_GenTriggerOnly(ch);
+      m_writes += 2;
+    } else {
+      ret |= rp_GenOutEnable(ch);
+      m_writes++;
+    }
+    *changed = true;
+  } else {
+    m_skipped++;
+  }
+
+  if (ret == RP_OK) {
+    h = w;
+    m_known[ch] = true;
+  } else {
+    /* Unknown which of the writes went through */
+    m_known[ch] = false;
+  }
+  return ret;
+}
+
+auto GenConfig::commit(rp_channel_t ch) -> int {
+  bool changed;
+  return apply(ch, true, &changed);
+}
+
+auto GenConfig::commitSync() -> int {
+  int ret = RP_OK;
+  bool restart = false;
+  for (int ch = 0; ch < GEN_CONFIG_CHANNELS; ch++) {
+    bool changed;
+    ret |= apply((rp_channel_t)ch, false, &changed);
+    restart = restart || (changed && m_want[ch].enabled);
+  }
+  if (restart) {
+    ret |= rp_GenSynchronise();
+    m_writes++;
+  }
+  if (ret != RP_OK) {
+    invalidate();
+  }
+  return ret;
+}
+
+auto GenConfig::reset() -> int {
+  invalidate();
+  return rp_GenReset();
+}
+
+auto GenConfig::invalidate() -> void {
+  for (int ch = 0; ch < GEN_CONFIG_CHANNELS; ch++) {
+    m_known[ch] = false;
+  }
+}
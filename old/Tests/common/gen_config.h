@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "rp.h"
+
+#define GEN_CONFIG_CHANNELS 2
+
+/* Settings of one generator output */
+struct GenChannelConfig {
+  rp_waveform_t waveform = RP_WAVEFORM_SINE;
+  float frequency = 1000;
+  float amplitude = 1;
+  float offset = 0;
+  rp_gen_mode_t mode = RP_GEN_MODE_CONTINUOUS;
+  bool enabled = false;
+};
+
+/* Shadow of the generator settings. Changes are staged on the wanted
+ * configuration and commit() writes only the fields that differ from what
+ * the generator was last set to, each one a single register round trip.
+ * Fields are written in a fixed order (mode, waveform, frequency,
+ * amplitude, offset) and the output is enabled last and triggered once,
+ * so a running output only sees the settings that really change.
+ *
+ * Anything that changes the generator behind the shadow's back must call
+ * invalidate(); the next commit then writes every field. */
+class GenConfig {
+public:
+  /* Wanted configuration of a channel, applied by the next commit */
+  auto channel(rp_channel_t ch) -> GenChannelConfig &;
+
+  /* Applies the staged changes of one channel. A channel that gets enabled
+   * is triggered. Returns RP_OK or the first error. */
+  auto commit(rp_channel_t ch) -> int;
+
+  /* Applies the staged changes of both channels. Outputs that get enabled
+   * are only enabled, then rp_GenSynchronise() triggers both channels
+   * together when anything on an enabled channel changed, so they start
+   * with aligned phase. Returns RP_OK or the first error. */
+  auto commitSync() -> int;
+
+  /* rp_GenReset() and forget the shadow */
+  auto reset() -> int;
+  auto invalidate() -> void;
+
+  /* Setter calls made and avoided by the change detection */
+  auto writes() const -> uint64_t { return m_writes; }
+  auto skipped() const -> uint64_t { return m_skipped; }
+
+private:
+  auto apply(rp_channel_t ch, bool trigger, bool *changed) -> int;
+
+  GenChannelConfig m_want[GEN_CONFIG_CHANNELS];
+  GenChannelConfig m_have[GEN_CONFIG_CHANNELS];
+  bool m_known[GEN_CONFIG_CHANNELS] = {};
+  uint64_t m_writes = 0;
+  uint64_t m_skipped = 0;
+};
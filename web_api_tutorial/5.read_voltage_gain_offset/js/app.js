@@ -5,6 +5,10 @@
     APP.config.app_id = '5.read_voltage_gain_offset';
     APP.config.app_url = '/bazaar?start=' + APP.config.app_id + '?' + location.search.substr(1);
     APP.config.socket_url = 'ws://' + window.location.hostname + ':9002';
+    APP.config.signal_size = 1024;
+    // 0 JSON signals, binary frames of 1 float32, 2 int16, 3 int16 delta,
+    // 4 float16 values
+    APP.config.frame_format = 3;
 
     // WebSocket
     APP.ws = null;
@@ -12,8 +16,14 @@
     // Plot
     APP.plot = {};
 
-    // Signal stack
-    APP.signalStack = [];
+    // Last signal_size values of each signal and whether they changed
+    // since the plot was drawn
+    APP.signalHistory = {};
+    APP.signalsChanged = false;
+
+    // Last binary frame merged and frames missed
+    APP.frameSequence = -1;
+    APP.lostFrames = 0;
 
     // Parameters
     APP.processing = false;
@@ -72,6 +82,9 @@
 
                 //Set initial offset
                 APP.setOffset();
+
+                //Choose how signals are sent
+                APP.setFrameFormat();
             };
 
             APP.ws.onclose = function() {
@@ -100,11 +113,12 @@
                     var receive = JSON.parse(text);
 
                     if (receive.parameters) {
-                        
+                        if (receive.parameters['VOLTAGE_FRAME'])
+                            APP.mergeFrame('VOLTAGE', receive.parameters['VOLTAGE_FRAME'].value);
                     }
 
                     if (receive.signals) {
-                        APP.signalStack.push(receive.signals);
+                        APP.mergeSignals(receive.signals);
                     }
                     APP.processing = false;
                 } catch (e) {
@@ -155,6 +169,139 @@
 
 
 
+    //Set signal frame format
+    APP.setFrameFormat = function() {
+
+        var local = {};
+        local['FRAME_FORMAT'] = { value: APP.config.frame_format };
+        APP.ws.send(JSON.stringify({ parameters: local }));
+
+    };
+
+
+
+
+    // Merges values into the history of a signal: a full frame replaces
+    // it, otherwise the values are the newest ones. The controller sends a
+    // full frame first and after a gain or offset change and otherwise only
+    // the values added since its last frame, so none may be skipped.
+    APP.mergeValues = function(sig_name, values, full) {
+
+        var history = APP.signalHistory[sig_name];
+        if (full) {
+            history = values.slice(Math.max(values.length - APP.config.signal_size, 0));
+        } else {
+            if (!history) {
+                history = new Array(APP.config.signal_size).fill(0);
+            }
+            history = history.concat(values);
+            history.splice(0, history.length - APP.config.signal_size);
+        }
+
+        APP.signalHistory[sig_name] = history;
+        APP.signalsChanged = true;
+    };
+
+
+
+
+    // Merges JSON signals, a frame of signal_size values is a full one
+    APP.mergeSignals = function(new_signals) {
+
+        for (sig_name in new_signals) {
+
+            var signal = new_signals[sig_name];
+            if (signal.size == 0) continue;
+
+            APP.mergeValues(sig_name, signal.value, signal.size >= APP.config.signal_size);
+        }
+    };
+
+
+
+
+    // Merges a binary frame, see src/signal_frame.h for the layout. The
+    // same frame may arrive again with the next parameters, a gap in the
+    // sequence means values are missing until the next full frame.
+    APP.mergeFrame = function(sig_name, text) {
+
+        var frame = APP.decodeFrame(text);
+        if (frame.sequence == APP.frameSequence) return;
+
+        if (!frame.full && APP.frameSequence >= 0 &&
+            frame.sequence != ((APP.frameSequence + 1) >>> 0)) {
+            APP.lostFrames++;
+            console.log('Lost signal frames: ' + APP.lostFrames);
+        }
+        APP.frameSequence = frame.sequence;
+
+        APP.mergeValues(sig_name, frame.values, frame.full);
+    };
+
+
+
+
+    // Decodes a base64 binary frame to its sequence, full flag and values
+    APP.decodeFrame = function(text) {
+
+        var binary = atob(text);
+        var bytes = new Uint8Array(binary.length);
+        for (var i = 0; i < binary.length; i++) {
+            bytes[i] = binary.charCodeAt(i);
+        }
+
+        var view = new DataView(bytes.buffer);
+        var format = view.getUint8(1);
+        var flags = view.getUint8(2);
+        var count = view.getUint32(8, true);
+        var scale = view.getFloat32(12, true);
+        var offset = view.getFloat32(16, true);
+
+        var values = new Array(count);
+        if (format == 1) {
+            for (var i = 0; i < count; i++) {
+                values[i] = view.getFloat32(20 + 4 * i, true);
+            }
+        } else if (format == 2) {
+            var code = 0;
+            for (var i = 0; i < count; i++) {
+                var word = view.getUint16(20 + 2 * i, true);
+                code = flags & 2 ? (code + word) & 0xffff : word;
+                values[i] = (code << 16 >> 16) * scale + offset;
+            }
+        } else if (format == 4) {
+            for (var i = 0; i < count; i++) {
+                values[i] = APP.halfToFloat(view.getUint16(20 + 2 * i, true));
+            }
+        }
+
+        return {
+            sequence: view.getUint32(4, true),
+            full: (flags & 1) != 0,
+            values: values
+        };
+    };
+
+
+
+
+    // IEEE half precision to number
+    APP.halfToFloat = function(h) {
+
+        var sign = h & 0x8000 ? -1 : 1;
+        var exponent = (h >> 10) & 0x1f;
+        var mantissa = h & 0x3ff;
+
+        if (exponent == 0)
+            return sign * mantissa * Math.pow(2, -24);
+        if (exponent == 31)
+            return mantissa ? NaN : sign * Infinity;
+        return sign * (1 + mantissa / 1024) * Math.pow(2, exponent - 15);
+    };
+
+
+
+
     // Processes newly received data for signals
     APP.processSignals = function(new_signals) {
 
@@ -165,17 +312,16 @@
         // Draw signals
         for (sig_name in new_signals) {
 
-            // Ignore empty signals
-            if (new_signals[sig_name].size == 0) continue;
+            var values = new_signals[sig_name];
 
             var points = [];
-            for (var i = 0; i < new_signals[sig_name].size; i++) {
-                    points.push([i, new_signals[sig_name].value[i]]);
+            for (var i = 0; i < values.length; i++) {
+                    points.push([i, values[i]]);
             }
 
             pointArr.push(points);
 
-            voltage = new_signals[sig_name].value[new_signals[sig_name].size - 1];
+            voltage = values[values.length - 1];
         }
 
         //Update value
@@ -193,12 +339,10 @@
 
     //Handler
     APP.signalHandler = function() {
-        if (APP.signalStack.length > 0) {
-            APP.processSignals(APP.signalStack[0]);
-            APP.signalStack.splice(0, 1);
+        if (APP.signalsChanged) {
+            APP.signalsChanged = false;
+            APP.processSignals(APP.signalHistory);
         }
-        if (APP.signalStack.length > 2)
-            APP.signalStack.length = [];
     }
     setInterval(APP.signalHandler, 15);
 
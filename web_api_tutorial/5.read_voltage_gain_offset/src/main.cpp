@@ -8,6 +8,9 @@
 #include <vector>
 
 #include "main.h"
+#include "acquisition_thread.h"
+#include "ring_signal.h"
+#include "signal_frame.h"
 
 
 
@@ -16,10 +19,26 @@
 #define SIGNAL_SIZE_DEFAULT      1024
 #define SIGNAL_UPDATE_INTERVAL      10
 
+//Acquisition, read period and values per frame handed to UpdateSignals
+#define ACQUISITION_PERIOD_US    10000
+#define ACQUISITION_FRAME_SAMPLES   4
+
 
 //Signal
 CFloatSignal VOLTAGE("VOLTAGE", SIGNAL_SIZE_DEFAULT, 0.0f);
-std::vector<float> g_data(SIGNAL_SIZE_DEFAULT);
+RingSignal g_data(SIGNAL_SIZE_DEFAULT);
+
+//Binary frames of the signal, sent instead of it unless FRAME_FORMAT is JSON
+CIntParameter FRAME_FORMAT("FRAME_FORMAT", CBaseParameter::RW, FRAME_JSON, 0, FRAME_JSON, FRAME_FLOAT16);
+CStringParameter VOLTAGE_FRAME("VOLTAGE_FRAME", CBaseParameter::RO, "", 0);
+SignalFrameEncoder g_encoder;
+std::vector<float> g_frame;
+
+//Acquisition statistics, updated once a second
+CFloatParameter ACQ_RATE("ACQ_RATE", CBaseParameter::RO, 0, 0, 0, 1e6);
+CFloatParameter UI_RATE("UI_RATE", CBaseParameter::RO, 0, 0, 0, 1e6);
+CIntParameter DROPPED_FRAMES("DROPPED_FRAMES", CBaseParameter::RO, 0, 0, 0, INT_MAX);
+double g_stats_time = 1;
 
 
 //Parameter
@@ -31,6 +50,22 @@ CFloatParameter OFFSET("OFFSET", CBaseParameter::RW, 0.0, 0, 0.0, 5.0);
 
 
 
+// Reads the voltage on the acquisition thread
+bool read_voltage(float *value)
+{
+    uint32_t raw;
+    return rp_AIpinGetValue(0, value, &raw) == RP_OK;
+}
+
+AcquisitionThread g_acquisition(read_voltage, ACQUISITION_PERIOD_US, ACQUISITION_FRAME_SAMPLES);
+
+
+
+
+
+
+
+
 const char *rp_app_desc(void)
 {
     return (const char *)"Red Pitaya read voltage.\n";
@@ -52,6 +87,9 @@ int rp_app_init(void)
     //Set signal update interval
     CDataManager::GetInstance()->SetSignalInterval(SIGNAL_UPDATE_INTERVAL);
 
+    //Start reading in the background
+    g_acquisition.start();
+
     return 0;
 }
 
@@ -60,6 +98,22 @@ int rp_app_exit(void)
 {
     fprintf(stderr, "Unloading read voltage application\n");
 
+    //Stop reading before the API goes away
+    g_acquisition.stop();
+    AcquisitionStats acq = g_acquisition.stats();
+    fprintf(stderr, "Acquisition: %llu frames in %.1f s, %llu taken, %llu dropped, %llu read errors\n",
+            (unsigned long long)acq.frames, acq.seconds,
+            (unsigned long long)acq.taken,
+            (unsigned long long)acq.dropped,
+            (unsigned long long)acq.read_errors);
+    fprintf(stderr, "Signal frames: %llu full, %llu incremental, %llu values sent\n",
+            (unsigned long long)g_data.full_frames(),
+            (unsigned long long)g_data.new_frames(),
+            (unsigned long long)g_data.samples_sent());
+    fprintf(stderr, "Binary frames: %llu, %llu bytes\n",
+            (unsigned long long)g_encoder.frames(),
+            (unsigned long long)g_encoder.bytes());
+
     rpApp_Release();
 
     return 0;
@@ -92,31 +146,65 @@ int rp_get_signals(float ***s, int *sig_num, int *sig_len)
 
 void UpdateSignals(void)
 {
-    float val;
-    uint32_t raw;
-
-    //Read data from pin
-    rp_AIpinGetValue(0, &val,&raw);
-
-    //Push it to vector
-    g_data.erase(g_data.begin());
-    g_data.push_back(val);
+    //Push every frame the acquisition thread queued to the history, the
+    //oldest values are dropped
+    while (const AcquisitionFrame *frame = g_acquisition.take())
+    {
+        for (size_t i = 0; i < frame->values.size(); i++)
+            g_data.push(frame->values[i]);
+    }
 
-    //Write data to signal
-    for(int i = 0; i < SIGNAL_SIZE_DEFAULT; i++)
+    //Write the new values to signal, or leave it empty for binary frames
+    if (FRAME_FORMAT.Value() == FRAME_JSON)
     {
-        VOLTAGE[i] = g_data[i] * GAIN.Value() + OFFSET.Value();
+        g_data.publish_new(VOLTAGE, GAIN.Value(), OFFSET.Value());
+    }
+    else if (VOLTAGE.GetSize() != 0)
+    {
+        VOLTAGE.Resize(0);
     }
 }
 
 
-void UpdateParams(void){}
+void UpdateParams(void)
+{
+    //Acquisition statistics
+    if (g_acquisition.seconds() >= g_stats_time)
+    {
+        AcquisitionStats acq = g_acquisition.stats();
+        ACQ_RATE.Set(acq.producer_rate);
+        UI_RATE.Set(acq.consumer_rate);
+        DROPPED_FRAMES.Set(acq.dropped);
+        //The whole history once a second, so a client that connected
+        //after the first frame does not keep a zeroed history
+        g_data.resend();
+        g_stats_time = acq.seconds + 1;
+    }
+
+    //Values since the last frame as one binary frame
+    if (FRAME_FORMAT.Value() != FRAME_JSON)
+    {
+        bool full = g_data.next_frame(g_frame, GAIN.Value(), OFFSET.Value());
+        if (!g_frame.empty())
+        {
+            VOLTAGE_FRAME.Set(g_encoder.encode(g_frame.data(), g_frame.size(),
+                                               FRAME_FORMAT.Value(), full));
+        }
+    }
+}
 
 
 void OnNewParams(void)
 {
     GAIN.Update();
     OFFSET.Update();
+
+    //A client switching formats starts from the whole history
+    if (IS_NEW(FRAME_FORMAT))
+    {
+        g_data.resend();
+    }
+    FRAME_FORMAT.Update();
 }
 
 
@@ -8,6 +8,10 @@
 #include <vector>
 
 #include "main.h"
+#include "acquisition_thread.h"
+#include "ring_signal.h"
+#include "signal_frame.h"
+#include "param_pipeline.h"
 
 
 
@@ -15,10 +19,31 @@
 #define SIGNAL_SIZE_DEFAULT      1024
 #define SIGNAL_UPDATE_INTERVAL      1
 
+//Acquisition, read period and values per frame handed to UpdateSignals
+#define ACQUISITION_PERIOD_US    1000
+#define ACQUISITION_FRAME_SAMPLES   20
+
+//Generator settings are applied once they were unchanged for
+//PARAM_QUIET_MS, but at most PARAM_MAX_DELAY_MS after a change
+#define PARAM_QUIET_MS             30
+#define PARAM_MAX_DELAY_MS        100
+
 
 //Signal
 CFloatSignal VOLTAGE("VOLTAGE", SIGNAL_SIZE_DEFAULT, 0.0f);
-std::vector<float> g_data(SIGNAL_SIZE_DEFAULT);
+RingSignal g_data(SIGNAL_SIZE_DEFAULT);
+
+//Binary frames of the signal, sent instead of it unless FRAME_FORMAT is JSON
+CIntParameter FRAME_FORMAT("FRAME_FORMAT", CBaseParameter::RW, FRAME_JSON, 0, FRAME_JSON, FRAME_FLOAT16);
+CStringParameter VOLTAGE_FRAME("VOLTAGE_FRAME", CBaseParameter::RO, "", 0);
+SignalFrameEncoder g_encoder;
+std::vector<float> g_frame;
+
+//Acquisition statistics, updated once a second
+CFloatParameter ACQ_RATE("ACQ_RATE", CBaseParameter::RO, 0, 0, 0, 1e6);
+CFloatParameter UI_RATE("UI_RATE", CBaseParameter::RO, 0, 0, 0, 1e6);
+CIntParameter DROPPED_FRAMES("DROPPED_FRAMES", CBaseParameter::RO, 0, 0, 0, INT_MAX);
+double g_stats_time = 1;
 
 
 // Parameters
@@ -27,6 +52,9 @@ CFloatParameter AMPLITUDE("AMPLITUDE", CBaseParameter::RW, 0.5, 0, 0, 0.5);
 CIntParameter WAVEFORM("WAVEFORM", CBaseParameter::RW, 0, 0, 0, 2);
 CIntParameter GAIN("GAIN", CBaseParameter::RW, 1, 0, 1, 5);
 
+//Generator settings received and applied, updated once a second
+CIntParameter PARAMS_RECEIVED("PARAMS_RECEIVED", CBaseParameter::RO, 0, 0, 0, INT_MAX);
+CIntParameter PARAMS_APPLIED("PARAMS_APPLIED", CBaseParameter::RO, 0, 0, 0, INT_MAX);
 
 
 
@@ -34,33 +62,112 @@ CIntParameter GAIN("GAIN", CBaseParameter::RW, 1, 0, 1, 5);
 
 
 
-// Generator config
-void set_generator_config()
+
+// Generator settings
+struct GeneratorSettings
 {
-    //Set frequency
-    rp_GenFreq(RP_CH_1, FREQUENCY.Value());
+    int frequency;
+    float amplitude;
+    int waveform;
+};
 
-    //Set offset
-    rp_GenOffset(RP_CH_1, 0.5);
 
-    //Set amplitude
-    rp_GenAmp(RP_CH_1, AMPLITUDE.Value());
+// Generator settings last written, so that only changed ones are written again
+struct GeneratorState
+{
+    bool valid;
+    int frequency;
+    float amplitude;
+    int waveform;
+};
+GeneratorState g_generator = {false, 0, 0, 0};
+uint64_t g_generator_writes = 0;
+uint64_t g_generator_skipped = 0;
+
+
+// The settings of the parameters
+GeneratorSettings generator_settings()
+{
+    GeneratorSettings settings;
+    settings.frequency = FREQUENCY.Value();
+    settings.amplitude = AMPLITUDE.Value();
+    settings.waveform = WAVEFORM.Value();
+    return settings;
+}
 
-    //Set waveform
-    if (WAVEFORM.Value() == 0)
+
+// Generator config, on the pipeline thread once it runs
+void set_generator_config(const GeneratorSettings &settings)
+{
+    // Nothing is known about the generator before the first call
+    const bool all = !g_generator.valid;
+    int writes = 0;
+
+    //Set frequency
+    if (all || settings.frequency != g_generator.frequency)
     {
-        rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+        rp_GenFreq(RP_CH_1, settings.frequency);
+        g_generator.frequency = settings.frequency;
+        writes++;
     }
-    else if (WAVEFORM.Value() == 1)
+
+    //Set offset, it never changes
+    if (all)
     {
-        rp_GenWaveform(RP_CH_1, RP_WAVEFORM_RAMP_UP);
+        rp_GenOffset(RP_CH_1, 0.5);
+        writes++;
     }
-    else if (WAVEFORM.Value() == 2)
+
+    //Set amplitude
+    if (all || settings.amplitude != g_generator.amplitude)
+    {
+        rp_GenAmp(RP_CH_1, settings.amplitude);
+        g_generator.amplitude = settings.amplitude;
+        writes++;
+    }
+
+    //Set waveform
+    if (all || settings.waveform != g_generator.waveform)
     {
-        rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SQUARE);
+        if (settings.waveform == 0)
+        {
+            rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SINE);
+        }
+        else if (settings.waveform == 1)
+        {
+            rp_GenWaveform(RP_CH_1, RP_WAVEFORM_RAMP_UP);
+        }
+        else if (settings.waveform == 2)
+        {
+            rp_GenWaveform(RP_CH_1, RP_WAVEFORM_SQUARE);
+        }
+        g_generator.waveform = settings.waveform;
+        writes++;
     }
+
+    g_generator.valid = true;
+    g_generator_writes += writes;
+    g_generator_skipped += 4 - writes;
 }
 
+ParamPipeline<GeneratorSettings> g_params(set_generator_config, PARAM_QUIET_MS, PARAM_MAX_DELAY_MS);
+
+
+
+
+
+
+
+
+// Reads the voltage on the acquisition thread
+bool read_voltage(float *value)
+{
+    uint32_t raw;
+    return rp_AIpinGetValue(0, value, &raw) == RP_OK;
+}
+
+AcquisitionThread g_acquisition(read_voltage, ACQUISITION_PERIOD_US, ACQUISITION_FRAME_SAMPLES);
+
 
 
 
@@ -89,10 +196,14 @@ int rp_app_init(void)
     //Set signal update interval
     CDataManager::GetInstance()->SetSignalInterval(SIGNAL_UPDATE_INTERVAL);
 
-    // Init generator
-    set_generator_config();
+    //Start reading in the background
+    g_acquisition.start();
+
+    // Init generator, later changes go through the pipeline
+    set_generator_config(generator_settings());
     rp_GenOutEnable(RP_CH_1);
     rp_GenResetTrigger(RP_CH_1);
+    g_params.start();
     return 0;
 }
 
@@ -101,6 +212,33 @@ int rp_app_exit(void)
 {
     fprintf(stderr, "Unloading generator application\n");
 
+    //Stop reading before the API goes away
+    g_acquisition.stop();
+    AcquisitionStats acq = g_acquisition.stats();
+    fprintf(stderr, "Acquisition: %llu frames in %.1f s, %llu taken, %llu dropped, %llu read errors\n",
+            (unsigned long long)acq.frames, acq.seconds,
+            (unsigned long long)acq.taken,
+            (unsigned long long)acq.dropped,
+            (unsigned long long)acq.read_errors);
+    //Apply the last settings before the generator is disabled
+    g_params.stop();
+    ParamPipelineStats params = g_params.stats();
+    fprintf(stderr, "Generator settings: %llu received, %llu applied, %llu coalesced, %.1f ms mean and %.1f ms longest delay\n",
+            (unsigned long long)params.received,
+            (unsigned long long)params.applied,
+            (unsigned long long)params.coalesced,
+            params.mean_delay_ms, params.max_delay_ms);
+    fprintf(stderr, "Generator setters: %llu written, %llu skipped\n",
+            (unsigned long long)g_generator_writes,
+            (unsigned long long)g_generator_skipped);
+    fprintf(stderr, "Signal frames: %llu full, %llu incremental, %llu values sent\n",
+            (unsigned long long)g_data.full_frames(),
+            (unsigned long long)g_data.new_frames(),
+            (unsigned long long)g_data.samples_sent());
+    fprintf(stderr, "Binary frames: %llu, %llu bytes\n",
+            (unsigned long long)g_encoder.frames(),
+            (unsigned long long)g_encoder.bytes());
+
     // Disabe generator
     rp_GenOutDisable(RP_CH_1);
 
@@ -136,37 +274,79 @@ int rp_get_signals(float ***s, int *sig_num, int *sig_len)
 
 void UpdateSignals(void)
 {
-    float val;
-    uint32_t raw;
-
-    //Read data from pin
-    rp_AIpinGetValue(0, &val,&raw);
-
-    //Push it to vector
-    g_data.erase(g_data.begin());
-    g_data.push_back(val * GAIN.Value());
+    //Push every frame the acquisition thread queued to the history, the
+    //oldest values are dropped
+    while (const AcquisitionFrame *frame = g_acquisition.take())
+    {
+        for (size_t i = 0; i < frame->values.size(); i++)
+            g_data.push(frame->values[i]);
+    }
 
-    //Write data to signal
-    for(int i = 0; i < SIGNAL_SIZE_DEFAULT; i++)
+    //Write the new values to signal, or leave it empty for binary frames
+    if (FRAME_FORMAT.Value() == FRAME_JSON)
     {
-        VOLTAGE[i] = g_data[i];
+        g_data.publish_new(VOLTAGE, GAIN.Value());
+    }
+    else if (VOLTAGE.GetSize() != 0)
+    {
+        VOLTAGE.Resize(0);
     }
 }
 
 
-void UpdateParams(void){}
+void UpdateParams(void)
+{
+    //Acquisition statistics
+    if (g_acquisition.seconds() >= g_stats_time)
+    {
+        AcquisitionStats acq = g_acquisition.stats();
+        ACQ_RATE.Set(acq.producer_rate);
+        UI_RATE.Set(acq.consumer_rate);
+        DROPPED_FRAMES.Set(acq.dropped);
+        //The whole history once a second, so a client that connected
+        //after the first frame does not keep a zeroed history
+        g_data.resend();
+        ParamPipelineStats params = g_params.stats();
+        PARAMS_RECEIVED.Set(params.received);
+        PARAMS_APPLIED.Set(params.applied);
+        g_stats_time = acq.seconds + 1;
+    }
+
+    //Values since the last frame as one binary frame
+    if (FRAME_FORMAT.Value() != FRAME_JSON)
+    {
+        bool full = g_data.next_frame(g_frame, GAIN.Value());
+        if (!g_frame.empty())
+        {
+            VOLTAGE_FRAME.Set(g_encoder.encode(g_frame.data(), g_frame.size(),
+                                               FRAME_FORMAT.Value(), full));
+        }
+    }
+}
 
 
 void OnNewParams(void)
 {
     GAIN.Update();
 
+    //A client switching formats starts from the whole history
+    if (IS_NEW(FRAME_FORMAT))
+    {
+        g_data.resend();
+    }
+    FRAME_FORMAT.Update();
+
+    //Only generator settings that changed go to the pipeline
+    const bool changed = IS_NEW(FREQUENCY) || IS_NEW(AMPLITUDE) || IS_NEW(WAVEFORM);
     FREQUENCY.Update();
     AMPLITUDE.Update();
     WAVEFORM.Update();
 
-    // Set generator config
-    set_generator_config();
+    // Set generator config, coalesced with the changes around it
+    if (changed)
+    {
+        g_params.submit(generator_settings());
+    }
 }
 
 
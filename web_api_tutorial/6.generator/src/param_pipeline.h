@@ -0,0 +1,157 @@
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+
+
+
+
+struct ParamPipelineStats
+{
+    // Settings handed to submit(), and settings applied. Every submit()
+    // that was replaced by a later one before it was applied is coalesced.
+    uint64_t received;
+    uint64_t applied;
+    uint64_t coalesced;
+    // Mean and longest time from the first submit() of a burst until its
+    // settings were applied, in ms
+    double mean_delay_ms;
+    double max_delay_ms;
+};
+
+
+// Applies settings on its own thread, coalescing bursts. submit() only
+// stores the latest settings and returns, so the web SDK thread never waits
+// for the hardware. The thread applies them once no new settings came for
+// quiet_ms, a dragged slider settles, but at the latest max_delay_ms after
+// the first settings of a burst, so a long drag still moves the output.
+// Settings replaced before they were applied are never applied.
+template <typename Settings>
+class ParamPipeline
+{
+public:
+    typedef std::function<void(const Settings &settings)> ApplyFunction;
+
+    ParamPipeline(ApplyFunction apply, int quiet_ms, int max_delay_ms)
+        : m_apply(apply), m_quiet(std::chrono::milliseconds(quiet_ms)),
+          m_max_delay(std::chrono::milliseconds(max_delay_ms)),
+          m_running(false), m_stop(false), m_pending(false), m_received(0),
+          m_applied(0), m_delay_us(0), m_max_delay_us(0)
+    {
+    }
+
+    ~ParamPipeline() { stop(); }
+
+    void start()
+    {
+        if (m_running)
+            return;
+        m_stop = false;
+        m_running = true;
+        m_thread = std::thread(&ParamPipeline::run, this);
+    }
+
+    // Applies pending settings, then stops
+    void stop()
+    {
+        if (!m_running)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+        m_running = false;
+    }
+
+    void submit(const Settings &settings)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const Clock::time_point now = Clock::now();
+            if (!m_pending)
+                m_first = now;
+            m_latest = settings;
+            m_last = now;
+            m_pending = true;
+            m_received++;
+        }
+        m_wake.notify_one();
+    }
+
+    ParamPipelineStats stats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ParamPipelineStats s;
+        s.received = m_received;
+        s.applied = m_applied;
+        s.coalesced = m_received - m_applied - (m_pending ? 1 : 0);
+        s.mean_delay_ms = m_applied ? m_delay_us * 1e-3 / m_applied : 0;
+        s.max_delay_ms = m_max_delay_us * 1e-3;
+        return s;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_wake.wait(lock, [this] { return m_pending || m_stop; });
+            if (!m_pending)
+                break;
+
+            // Wait for the burst to settle, or for its deadline
+            while (!m_stop)
+            {
+                const Clock::time_point due = std::min(m_last + m_quiet, m_first + m_max_delay);
+                if (Clock::now() >= due)
+                    break;
+                m_wake.wait_until(lock, due);
+            }
+
+            const Settings settings = m_latest;
+            const Clock::time_point first = m_first;
+            m_pending = false;
+
+            lock.unlock();
+            m_apply(settings);
+            const int64_t delay = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - first).count();
+            lock.lock();
+
+            m_applied++;
+            m_delay_us += delay;
+            m_max_delay_us = delay > m_max_delay_us ? delay : m_max_delay_us;
+        }
+    }
+
+    ApplyFunction m_apply;
+    const Clock::duration m_quiet;
+    const Clock::duration m_max_delay;
+
+    std::thread m_thread;
+    bool m_running;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop;
+    bool m_pending;
+    Settings m_latest;
+    // First and last submit() of the pending burst
+    Clock::time_point m_first;
+    Clock::time_point m_last;
+
+    uint64_t m_received;
+    uint64_t m_applied;
+    int64_t m_delay_us;
+    int64_t m_max_delay_us;
+};
@@ -91,7 +91,7 @@
 
     APP.openDir = function(dir) {
 
-        $.get('/ngx_app_test?dir=' + dir + '').done(function(msg) {
+        $.get('/ngx_app_test?dir=' + encodeURIComponent(dir)).done(function(msg) {
                     var ngx_files = msg.split("\n"); 
                     APP.printFiles(ngx_files);
                 });
@@ -99,6 +99,15 @@
 
 
 
+    // Downloads a file, streamed by the controller
+    APP.downloadFile = function(file) {
+
+        window.location.href = '/ngx_app_test?file=' + encodeURIComponent(file);
+    }
+
+
+
+    // The first line is the parent directory, directories end with /
     APP.printFiles = function(files) {
 
         //Remove old files
@@ -109,15 +118,23 @@
 
             if (files[i] != ""){
 
+                var directory = files[i].charAt(files[i].length - 1) == "/";
+                var name = directory ? files[i].slice(0, -1).split("/").pop() + "/" : files[i].split("/").pop();
+
                 div = document.createElement('div');
-                div.id = files[i] + "/";
+                div.id = files[i];
                 div.className = 'child';
-                if (i == 0)
-                    div.innerHTML = '<span class="child_desc">..</span>';
-                else
-                    div.innerHTML = '<span class="child_desc">' + files[i].split("/").pop() + '</span>';
-                div.firstElementChild.onclick = function(){            
-                    APP.openDir(this.parentNode.id);
+                div.innerHTML = '<span class="child_desc"></span>';
+                // Text, not markup, file names may contain anything
+                div.firstElementChild.textContent = i == 0 ? '..' : name;
+                if (directory) {
+                    div.firstElementChild.onclick = function(){
+                        APP.openDir(this.parentNode.id);
+                    }
+                } else {
+                    div.firstElementChild.onclick = function(){
+                        APP.downloadFile(this.parentNode.id);
+                    }
                 }
                 file_system.appendChild(div);
             }
@@ -0,0 +1,688 @@
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+
+
+struct FileServerStats
+{
+    uint64_t connections;
+    uint64_t requests;
+    uint64_t listings;
+    uint64_t downloads;
+    // Requests answered with a 4xx or 5xx status
+    uint64_t errors;
+    uint64_t bytes_sent;
+};
+
+
+// Minimal HTTP/1.1 server for the files below one root directory, without
+// a shell and without temporary files. nginx proxies the app location to it.
+//
+//   GET <any path>?dir=/a/b/   lists /a/b/: the parent directory on the
+//                              first line, then one entry per line, sorted,
+//                              directories with a trailing /. Chunked.
+//   GET <any path>?file=/a/f   streams /a/f with sendfile(), honouring a
+//                              single Range: bytes=first-last, first- or
+//                              -suffix. HEAD answers the headers only.
+//
+// Paths are relative to the root and opened one name at a time from an open
+// descriptor of it, without following symbolic links, so anything outside
+// of it, also through .. or links, is refused even when the tree changes
+// meanwhile. Every connection gets its own thread, up to max_connections,
+// and is kept alive between requests.
+class FileServer
+{
+public:
+    FileServer(int port, const std::string &root, int max_connections = 8)
+        : m_port(port), m_root_path(root), m_max_connections(max_connections),
+          m_root_fd(-1), m_listen(-1), m_running(false), m_stop(false), m_active(0),
+          m_connections(0), m_requests(0), m_listings(0), m_downloads(0),
+          m_errors(0), m_bytes_sent(0)
+    {
+    }
+
+    ~FileServer() { stop(); }
+
+    // Returns false when the port cannot be opened
+    bool start()
+    {
+        if (m_running)
+            return true;
+
+        m_root_fd = open(m_root_path.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (m_root_fd < 0)
+            return false;
+
+        m_listen = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (m_listen < 0)
+        {
+            close_root();
+            return false;
+        }
+        int one = 1;
+        setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(m_port);
+        if (bind(m_listen, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+            listen(m_listen, 16) < 0)
+        {
+            close(m_listen);
+            m_listen = -1;
+            close_root();
+            return false;
+        }
+
+        m_stop = false;
+        m_running = true;
+        m_thread = std::thread(&FileServer::run, this);
+        return true;
+    }
+
+    void stop()
+    {
+        if (!m_running)
+            return;
+        m_stop = true;
+        m_thread.join();
+        close(m_listen);
+        m_listen = -1;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::list<Connection>::iterator it = m_threads.begin(); it != m_threads.end(); ++it)
+            it->thread.join();
+        m_threads.clear();
+        close_root();
+        m_running = false;
+    }
+
+    FileServerStats stats() const
+    {
+        FileServerStats s;
+        s.connections = m_connections;
+        s.requests = m_requests;
+        s.listings = m_listings;
+        s.downloads = m_downloads;
+        s.errors = m_errors;
+        s.bytes_sent = m_bytes_sent;
+        return s;
+    }
+
+private:
+    // Idle time before a kept alive connection is closed, and how often
+    // the threads look at m_stop
+    static const int KEEP_ALIVE_MS = 5000;
+    static const int POLL_MS = 200;
+    static const size_t MAX_HEADER = 8192;
+
+    struct Connection
+    {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool> > done;
+    };
+
+    struct Request
+    {
+        std::string method;
+        std::string dir;
+        std::string file;
+        std::string range;
+        bool keep_alive;
+    };
+
+    void run()
+    {
+        while (!m_stop)
+        {
+            reap();
+
+            struct pollfd p = {m_listen, POLLIN, 0};
+            if (poll(&p, 1, POLL_MS) <= 0)
+                continue;
+            const int fd = accept4(m_listen, NULL, NULL, SOCK_CLOEXEC);
+            if (fd < 0)
+                continue;
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            if (m_active >= m_max_connections)
+            {
+                Request request;
+                request.keep_alive = false;
+                send_error(fd, request, 503, "Service Unavailable");
+                close(fd);
+                continue;
+            }
+
+            m_active++;
+            m_connections++;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_threads.push_back(Connection());
+            Connection &connection = m_threads.back();
+            connection.done = std::make_shared<std::atomic<bool> >(false);
+            std::shared_ptr<std::atomic<bool> > done = connection.done;
+            connection.thread = std::thread([this, fd, done] {
+                serve(fd);
+                close(fd);
+                m_active--;
+                *done = true;
+            });
+        }
+    }
+
+    // Joins the threads of closed connections
+    void reap()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::list<Connection>::iterator it = m_threads.begin(); it != m_threads.end();)
+        {
+            if (*it->done)
+            {
+                it->thread.join();
+                it = m_threads.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    void serve(int fd)
+    {
+        std::string buffer;
+        while (!m_stop)
+        {
+            // Read until the end of the header, bodies are not expected
+            size_t end;
+            int idle = 0;
+            while ((end = buffer.find("\r\n\r\n")) == std::string::npos)
+            {
+                if (m_stop || buffer.size() > MAX_HEADER || idle >= KEEP_ALIVE_MS)
+                    return;
+                struct pollfd p = {fd, POLLIN, 0};
+                const int ready = poll(&p, 1, POLL_MS);
+                if (ready == 0)
+                {
+                    idle += POLL_MS;
+                    continue;
+                }
+                char chunk[2048];
+                const ssize_t n = ready > 0 ? recv(fd, chunk, sizeof(chunk), 0) : -1;
+                if (n <= 0)
+                    return;
+                buffer.append(chunk, n);
+            }
+
+            Request request;
+            const bool valid = parse(buffer.substr(0, end), request);
+            buffer.erase(0, end + 4);
+            m_requests++;
+
+            if (!valid)
+            {
+                request.keep_alive = false;
+                send_error(fd, request, 400, "Bad Request");
+            }
+            else if (request.method != "GET" && request.method != "HEAD")
+                send_error(fd, request, 405, "Method Not Allowed");
+            else if (!request.file.empty())
+                send_file(fd, request);
+            else if (!request.dir.empty())
+                send_listing(fd, request);
+            else
+                send_error(fd, request, 400, "Bad Request");
+
+            if (!request.keep_alive)
+                return;
+        }
+    }
+
+    static bool parse(const std::string &header, Request &request)
+    {
+        const size_t line_end = header.find("\r\n");
+        const std::string line = header.substr(0, line_end);
+        const size_t first = line.find(' ');
+        const size_t second = line.find(' ', first + 1);
+        if (first == std::string::npos || second == std::string::npos)
+            return false;
+        request.method = line.substr(0, first);
+        const std::string target = line.substr(first + 1, second - first - 1);
+        const std::string version = line.substr(second + 1);
+        request.keep_alive = version == "HTTP/1.1";
+
+        // Query arguments
+        const size_t query = target.find('?');
+        if (query != std::string::npos)
+        {
+            size_t at = query + 1;
+            while (at < target.size())
+            {
+                size_t next = target.find('&', at);
+                if (next == std::string::npos)
+                    next = target.size();
+                const std::string argument = target.substr(at, next - at);
+                const size_t equals = argument.find('=');
+                if (equals != std::string::npos)
+                {
+                    const std::string name = argument.substr(0, equals);
+                    std::string value;
+                    if (!url_decode(argument.substr(equals + 1), value))
+                        return false;
+                    if (name == "dir")
+                        request.dir = value;
+                    else if (name == "file")
+                        request.file = value;
+                }
+                at = next + 1;
+            }
+        }
+
+        // Headers of interest, names are case insensitive
+        size_t at = line_end;
+        while (at != std::string::npos && at < header.size())
+        {
+            at += 2;
+            size_t next = header.find("\r\n", at);
+            const std::string field = header.substr(at, next == std::string::npos ? std::string::npos : next - at);
+            const size_t colon = field.find(':');
+            if (colon != std::string::npos)
+            {
+                std::string name = field.substr(0, colon);
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                std::string value = field.substr(colon + 1);
+                value.erase(0, value.find_first_not_of(' '));
+                if (name == "range")
+                    request.range = value;
+                else if (name == "connection")
+                {
+                    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+                    if (value == "close")
+                        request.keep_alive = false;
+                    else if (value == "keep-alive")
+                        request.keep_alive = true;
+                }
+            }
+            at = next;
+        }
+        return true;
+    }
+
+    static bool url_decode(const std::string &in, std::string &out)
+    {
+        out.clear();
+        for (size_t i = 0; i < in.size(); i++)
+        {
+            if (in[i] == '%')
+            {
+                if (i + 2 >= in.size() || !isxdigit(in[i + 1]) || !isxdigit(in[i + 2]))
+                    return false;
+                out += (char)strtol(in.substr(i + 1, 2).c_str(), NULL, 16);
+                i += 2;
+            }
+            else
+                out += in[i] == '+' ? ' ' : in[i];
+        }
+        // No NUL bytes in paths
+        return out.find('\0') == std::string::npos;
+    }
+
+    void close_root()
+    {
+        if (m_root_fd >= 0)
+            close(m_root_fd);
+        m_root_fd = -1;
+    }
+
+    // The names of a path relative to the root, with . and .. taken out by
+    // name. Without symbolic links on the way that is where they lead.
+    // False when the path climbs above the root.
+    static bool split_path(const std::string &path, std::vector<std::string> &names)
+    {
+        names.clear();
+        size_t at = 0;
+        while (at <= path.size())
+        {
+            size_t next = path.find('/', at);
+            if (next == std::string::npos)
+                next = path.size();
+            const std::string name = path.substr(at, next - at);
+            if (name == "..")
+            {
+                if (names.empty())
+                    return false;
+                names.pop_back();
+            }
+            else if (!name.empty() && name != ".")
+                names.push_back(name);
+            at = next + 1;
+        }
+        return true;
+    }
+
+    // The path of names relative to the root, starting with /
+    static std::string relative(const std::vector<std::string> &names)
+    {
+        std::string path;
+        for (size_t i = 0; i < names.size(); i++)
+            path += "/" + names[i];
+        return path.empty() ? "/" : path;
+    }
+
+    // Opens names below the root with flags, walking the directories from
+    // the root descriptor with O_NOFOLLOW: a symbolic link anywhere on the
+    // way fails, renaming or linking meanwhile cannot lead outside. Never
+    // blocks on a FIFO or device, check the type with fstat(). -1 on error.
+    int open_beneath(const std::vector<std::string> &names, int flags) const
+    {
+        flags |= O_NOFOLLOW | O_NONBLOCK | O_NOCTTY | O_CLOEXEC;
+        if (names.empty())
+            return openat(m_root_fd, ".", flags);
+
+        int dir = m_root_fd;
+        for (size_t i = 0; i + 1 < names.size(); i++)
+        {
+            const int next = openat(dir, names[i].c_str(), O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (dir != m_root_fd)
+                close(dir);
+            if (next < 0)
+                return -1;
+            dir = next;
+        }
+        const int fd = openat(dir, names.back().c_str(), flags);
+        if (dir != m_root_fd)
+            close(dir);
+        return fd;
+    }
+
+    // Error status for a failed open_beneath()
+    void send_open_error(int fd, const Request &request)
+    {
+        if (errno == EACCES || errno == EPERM)
+            send_error(fd, request, 403, "Forbidden");
+        else
+            send_error(fd, request, 404, "Not Found");
+    }
+
+    bool send_all(int fd, const char *data, size_t size)
+    {
+        while (size)
+        {
+            const ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            data += n;
+            size -= n;
+            m_bytes_sent += n;
+        }
+        return true;
+    }
+
+    bool send_header(int fd, const Request &request, int status, const char *reason,
+                     const std::string &fields)
+    {
+        char line[64];
+        snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", status, reason);
+        const std::string header = std::string(line) + fields +
+                                   (request.keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n") +
+                                   "\r\n";
+        return send_all(fd, header.data(), header.size());
+    }
+
+    void send_error(int fd, const Request &request, int status, const char *reason)
+    {
+        char fields[128];
+        const std::string body = std::string(reason) + "\n";
+        snprintf(fields, sizeof(fields), "Content-Type: text/plain; charset=utf-8\r\nContent-Length: %zu\r\n", body.size());
+        m_errors++;
+        if (send_header(fd, request, status, reason, fields) && request.method != "HEAD")
+            send_all(fd, body.data(), body.size());
+    }
+
+    // One chunk of a chunked body, an empty one ends it
+    bool send_chunk(int fd, const std::string &data)
+    {
+        char size[16];
+        snprintf(size, sizeof(size), "%zx\r\n", data.size());
+        const std::string chunk = size + data + "\r\n";
+        return send_all(fd, chunk.data(), chunk.size());
+    }
+
+    void send_listing(int fd, Request &request)
+    {
+        std::vector<std::string> path_names;
+        if (!split_path(request.dir, path_names))
+        {
+            send_error(fd, request, 404, "Not Found");
+            return;
+        }
+        const int directory_fd = open_beneath(path_names, O_RDONLY | O_DIRECTORY);
+        if (directory_fd < 0)
+        {
+            if (errno == ENOTDIR)
+                send_error(fd, request, 400, "Bad Request");
+            else
+                send_open_error(fd, request);
+            return;
+        }
+        DIR *dir = fdopendir(directory_fd);
+        if (!dir)
+        {
+            close(directory_fd);
+            send_error(fd, request, 500, "Internal Server Error");
+            return;
+        }
+        std::vector<std::string> names;
+        while (struct dirent *entry = readdir(dir))
+        {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+                continue;
+            std::string name = entry->d_name;
+            // Links are not followed, they are never directories here
+            bool directory = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN)
+            {
+                struct stat target;
+                directory = fstatat(dirfd(dir), entry->d_name, &target, AT_SYMLINK_NOFOLLOW) == 0 &&
+                            S_ISDIR(target.st_mode);
+            }
+            names.push_back(directory ? name + "/" : name);
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        m_listings++;
+
+        if (!send_header(fd, request, 200, "OK",
+                         "Content-Type: text/plain; charset=utf-8\r\n"
+                         "Transfer-Encoding: chunked\r\n") ||
+            request.method == "HEAD")
+            return;
+
+        // The parent stays inside the root
+        const std::string path = relative(path_names);
+        const size_t slash = path.find_last_of('/');
+        const std::string parent = slash == 0 ? "/" : path.substr(0, slash);
+        const std::string base = path == "/" ? "/" : path + "/";
+
+        std::string chunk = (parent == "/" ? parent : parent + "/") + "\n";
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            chunk += base + names[i] + "\n";
+            if (chunk.size() >= 4096)
+            {
+                if (!send_chunk(fd, chunk))
+                    return;
+                chunk.clear();
+            }
+        }
+        if (!chunk.empty() && !send_chunk(fd, chunk))
+            return;
+        send_chunk(fd, "");
+    }
+
+    // Parses a single range against the file size, false when it cannot
+    // be satisfied
+    static bool parse_range(const std::string &range, int64_t size, int64_t &first, int64_t &last)
+    {
+        if (range.compare(0, 6, "bytes=") != 0 || range.find(',') != std::string::npos)
+            return false;
+        const std::string spec = range.substr(6);
+        const size_t dash = spec.find('-');
+        if (dash == std::string::npos)
+            return false;
+        const std::string from = spec.substr(0, dash);
+        const std::string to = spec.substr(dash + 1);
+        if (from.empty())
+        {
+            // The last bytes
+            const int64_t suffix = atoll(to.c_str());
+            if (to.empty() || suffix <= 0)
+                return false;
+            first = suffix < size ? size - suffix : 0;
+            last = size - 1;
+        }
+        else
+        {
+            first = atoll(from.c_str());
+            last = to.empty() ? size - 1 : atoll(to.c_str());
+            if (last >= size)
+                last = size - 1;
+        }
+        return first >= 0 && first <= last && first < size;
+    }
+
+    void send_file(int fd, Request &request)
+    {
+        std::vector<std::string> path_names;
+        if (!split_path(request.file, path_names))
+        {
+            send_error(fd, request, 404, "Not Found");
+            return;
+        }
+        const int file = open_beneath(path_names, O_RDONLY);
+        if (file < 0)
+        {
+            send_open_error(fd, request);
+            return;
+        }
+        // The type of what was opened, not of what the name is now
+        struct stat st;
+        if (fstat(file, &st) != 0 || !S_ISREG(st.st_mode))
+        {
+            send_error(fd, request, 400, "Bad Request");
+            close(file);
+            return;
+        }
+
+        const int64_t size = st.st_size;
+        int64_t first = 0;
+        int64_t last = size - 1;
+        const bool partial = !request.range.empty();
+        if (partial && !parse_range(request.range, size, first, last))
+        {
+            char fields[64];
+            snprintf(fields, sizeof(fields), "Content-Range: bytes */%lld\r\nContent-Length: 0\r\n", (long long)size);
+            m_errors++;
+            send_header(fd, request, 416, "Range Not Satisfiable", fields);
+            close(file);
+            return;
+        }
+
+        const std::string name = path_names.empty() ? "" : path_names.back();
+        char fields[512];
+        int length = snprintf(fields, sizeof(fields),
+                              "Content-Type: application/octet-stream\r\n"
+                              "Accept-Ranges: bytes\r\n"
+                              "Content-Length: %lld\r\n",
+                              (long long)(last - first + 1));
+        if (partial)
+            length += snprintf(fields + length, sizeof(fields) - length, "Content-Range: bytes %lld-%lld/%lld\r\n",
+                               (long long)first, (long long)last, (long long)size);
+        std::string header = fields;
+        if (name.find_first_of("\"\r\n") == std::string::npos)
+            header += "Content-Disposition: attachment; filename=\"" + name + "\"\r\n";
+        m_downloads++;
+
+        if (send_header(fd, request, partial ? 206 : 200, partial ? "Partial Content" : "OK", header) &&
+            request.method != "HEAD")
+        {
+            // Straight from the page cache to the socket
+            off_t offset = first;
+            int64_t left = last - first + 1;
+            while (left > 0 && !m_stop)
+            {
+                const ssize_t n = sendfile(fd, file, &offset, left > (1 << 30) ? (1 << 30) : (size_t)left);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0 && errno == EAGAIN)
+                {
+                    struct pollfd p = {fd, POLLOUT, 0};
+                    poll(&p, 1, POLL_MS);
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    request.keep_alive = false;
+                    break;
+                }
+                left -= n;
+                m_bytes_sent += n;
+            }
+            if (left > 0)
+                request.keep_alive = false;
+        }
+        close(file);
+    }
+
+    int m_port;
+    std::string m_root_path;
+    int m_max_connections;
+
+    // O_PATH descriptor of the root, every path is opened from it
+    int m_root_fd;
+
+    int m_listen;
+    std::thread m_thread;
+    bool m_running;
+    std::atomic<bool> m_stop;
+
+    std::mutex m_mutex;
+    std::list<Connection> m_threads;
+    std::atomic<int> m_active;
+
+    std::atomic<uint64_t> m_connections;
+    std::atomic<uint64_t> m_requests;
+    std::atomic<uint64_t> m_listings;
+    std::atomic<uint64_t> m_downloads;
+    std::atomic<uint64_t> m_errors;
+    std::atomic<uint64_t> m_bytes_sent;
+};
@@ -7,6 +7,19 @@
 #include <sys/sysinfo.h>
 
 #include "main.h"
+#include "file_server.h"
+
+
+
+
+//Files listed and downloaded through nginx, see nginx.conf
+#define FILE_SERVER_PORT         9003
+#define FILE_SERVER_ROOT       "/tmp"
+
+
+FileServer g_file_server(FILE_SERVER_PORT, FILE_SERVER_ROOT);
+
+
 
 
 
@@ -22,6 +35,13 @@ const char *rp_app_desc(void)
 int rp_app_init(void)
 {
     fprintf(stderr, "Loading NGINX requests application\n");
+
+    //Serve the files in the background
+    if (!g_file_server.start())
+    {
+        fprintf(stderr, "File server could not listen on port %d\n", FILE_SERVER_PORT);
+        return EXIT_FAILURE;
+    }
     return 0;
 }
 
@@ -29,6 +49,16 @@ int rp_app_init(void)
 int rp_app_exit(void)
 {
     fprintf(stderr, "Unloading NGINX requests application\n");
+
+    g_file_server.stop();
+    FileServerStats stats = g_file_server.stats();
+    fprintf(stderr, "File server: %llu connections, %llu requests, %llu listings, %llu downloads, %llu errors, %llu bytes sent\n",
+            (unsigned long long)stats.connections,
+            (unsigned long long)stats.requests,
+            (unsigned long long)stats.listings,
+            (unsigned long long)stats.downloads,
+            (unsigned long long)stats.errors,
+            (unsigned long long)stats.bytes_sent);
     return 0;
 }
 
@@ -0,0 +1,4 @@
+#!/bin/sh
+
+# DO NOT EDIT
+/opt/redpitaya/sbin/overlay.sh v0.94
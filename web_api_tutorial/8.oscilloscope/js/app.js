@@ -0,0 +1,409 @@
+(function(APP, $, undefined) {
+
+    // App configuration
+    APP.config = {};
+    APP.config.app_id = '8.oscilloscope';
+    APP.config.app_url = '/bazaar?start=' + APP.config.app_id + '?' + location.search.substr(1);
+    APP.config.socket_url = 'ws://' + window.location.hostname + ':9002';
+    // Captures as binary frames, see src/signal_frame.h: 0 JSON signals,
+    // 1 float32, 2 int16, 3 int16 delta, 4 float16
+    APP.config.frame_format = 3;
+
+    // WebSocket
+    APP.ws = null;
+
+    // Plot
+    APP.plot = {};
+
+    // Newest capture, column minima and maxima, and whether it was drawn
+    APP.capture = null;
+    APP.captureChanged = false;
+
+    // Parameters
+    APP.processing = false;
+    APP.timeSpan = 0;
+    APP.decimation = 64;
+    APP.triggerLevel = 0;
+    APP.triggerSource = 0;
+    APP.triggerMode = 0;
+
+    // Sequence number of the newest capture, acknowledged once drawn, and
+    // the id this page acknowledges with, so the controller can tell
+    // clients apart
+    APP.captureSeq = -1;
+    APP.clientId = 1 + Math.floor(Math.random() * 127);
+
+    // Captures drawn in the last second and so far in this one
+    APP.drawn = 0;
+    APP.drawnNow = 0;
+
+
+
+
+    // Starts template application on server
+    APP.startApp = function() {
+
+        $.get(APP.config.app_url)
+            .done(function(dresult) {
+                if (dresult.status == 'OK') {
+                    APP.connectWebSocket();
+                } else if (dresult.status == 'ERROR') {
+                    console.log(dresult.reason ? dresult.reason : 'Could not start the application (ERR1)');
+                    APP.startApp();
+                } else {
+                    console.log('Could not start the application (ERR2)');
+                    APP.startApp();
+                }
+            })
+            .fail(function() {
+                console.log('Could not start the application (ERR3)');
+                APP.startApp();
+            });
+    };
+
+
+
+
+    APP.connectWebSocket = function() {
+
+        //Create WebSocket
+        if (window.WebSocket) {
+            APP.ws = new WebSocket(APP.config.socket_url);
+            APP.ws.binaryType = "arraybuffer";
+        } else if (window.MozWebSocket) {
+            APP.ws = new MozWebSocket(APP.config.socket_url);
+            APP.ws.binaryType = "arraybuffer";
+        } else {
+            console.log('Browser does not support WebSocket');
+        }
+
+
+        // Define WebSocket event listeners
+        if (APP.ws) {
+
+            APP.ws.onopen = function() {
+                $('#hello_message').text("Hello, Red Pitaya!");
+                console.log('Socket opened');
+
+                // Set initial parameters
+                APP.setFrameFormat();
+                APP.setDecimation();
+                APP.setTriggerLevel();
+                APP.setTrigger();
+            };
+
+            APP.ws.onclose = function() {
+                console.log('Socket closed');
+            };
+
+            APP.ws.onerror = function(ev) {
+                $('#hello_message').text("Connection error");
+                console.log('Websocket error: ', ev);
+            };
+
+            APP.ws.onmessage = function(ev) {
+
+                //Capture signals
+                if (APP.processing) {
+                    return;
+                }
+                APP.processing = true;
+
+                try {
+                    var data = new Uint8Array(ev.data);
+                    var inflate = pako.inflate(data);
+                    var text = String.fromCharCode.apply(null, new Uint8Array(inflate));
+                    var receive = JSON.parse(text);
+
+                    if (receive.parameters) {
+                        APP.processParameters(receive.parameters);
+                        if (receive.parameters['CAPTURE_FRAME'] && receive.parameters['CAPTURE_FRAME'].value)
+                            APP.mergeFrame(receive.parameters['CAPTURE_FRAME'].value);
+                    }
+
+                    // Empty signals mean there is no new capture
+                    if (receive.signals && receive.signals['CH1_MAX'] &&
+                        receive.signals['CH1_MAX'].size > 0) {
+                        APP.capture = receive.signals;
+                        APP.captureChanged = true;
+                        if (receive.signals['FRAME_SEQ']) {
+                            APP.captureSeq = receive.signals['FRAME_SEQ'].value[0];
+                        }
+                    }
+                    APP.processing = false;
+                } catch (e) {
+                    APP.processing = false;
+                    console.log(e);
+                } finally {
+                    APP.processing = false;
+                }
+
+
+
+            };
+        }
+    };
+
+
+
+
+    // Sends one parameter
+    APP.sendParameter = function(name, value) {
+
+        var local = {};
+        local[name] = { value: value };
+        APP.ws.send(JSON.stringify({ parameters: local }));
+    };
+
+
+
+
+    // Set the format captures are sent in
+    APP.setFrameFormat = function() {
+
+        APP.sendParameter('FRAME_FORMAT', APP.config.frame_format);
+    };
+
+
+
+
+    // Set decimation, the time span follows from it
+    APP.setDecimation = function() {
+
+        APP.decimation = $('#decimation_set').val();
+        APP.sendParameter('DECIMATION', APP.decimation);
+    };
+
+
+
+
+    // Set trigger level
+    APP.setTriggerLevel = function() {
+
+        APP.triggerLevel = $('#trigger_level_set').val();
+        APP.sendParameter('TRIGGER_LEVEL', APP.triggerLevel);
+
+        $('#trigger_level_value').text(APP.triggerLevel);
+    };
+
+
+
+
+    // Set trigger source and mode
+    APP.setTrigger = function() {
+
+        APP.triggerSource = $('#trigger_source_set').val();
+        APP.triggerMode = $('#trigger_mode_set').val();
+        APP.sendParameter('TRIGGER_SOURCE', APP.triggerSource);
+        APP.sendParameter('TRIGGER_MODE', APP.triggerMode);
+    };
+
+
+
+
+    // Read-only parameters from the controller
+    APP.processParameters = function(parameters) {
+
+        if (parameters['TIME_SPAN']) {
+            APP.timeSpan = parameters['TIME_SPAN'].value;
+            $('#time_span').text(parseFloat(APP.timeSpan).toPrecision(3));
+        }
+
+        if (parameters['REFRESH_RATE']) {
+            $('#status').text('Captures ' + parseFloat(parameters['REFRESH_RATE'].value).toFixed(1) + '/s' +
+                              ', drawn ' + APP.drawn + '/s' +
+                              (parameters['CAPTURE_MS'] ? ', ' + parseFloat(parameters['CAPTURE_MS'].value).toFixed(1) + ' ms each' : '') +
+                              (parameters['TRIGGERED'] && !parameters['TRIGGERED'].value ? ', not triggered' : ''));
+        }
+
+        if (parameters['HARDWARE_FAILED'] && parameters['HARDWARE_FAILED'].value) {
+            $('#status').text('Hardware init failed, no captures');
+        }
+
+        if (parameters['SEND_INTERVAL']) {
+            $('#flow').text('Sent every ' + parseFloat(parameters['SEND_INTERVAL'].value).toFixed(0) + ' ms' +
+                            ' with ' + parameters['FRAME_POINTS'].value + ' points' +
+                            ', acknowledged ' + parseFloat(parameters['CLIENT_RATE'].value).toFixed(1) + '/s' +
+                            ' after ' + parseFloat(parameters['CLIENT_LATENCY'].value).toFixed(0) + ' ms' +
+                            ', ' + parameters['HELD_UPDATES'].value + ' updates held' +
+                            (parameters['FLOW_CLIENTS'] && parameters['FLOW_CLIENTS'].value > 1 ?
+                             ', off for ' + parameters['FLOW_CLIENTS'].value + ' clients' : ''));
+        }
+    };
+
+
+
+
+    // Takes a binary frame as the newest capture, the same frame may arrive
+    // again with the next parameters. The minima come first, then the maxima.
+    APP.mergeFrame = function(text) {
+
+        var frame = APP.decodeFrame(text);
+        if (frame.sequence == APP.captureSeq) return;
+
+        var points = frame.values.length / 2;
+        APP.capture = {
+            CH1_MIN: { value: frame.values.slice(0, points) },
+            CH1_MAX: { value: frame.values.slice(points) }
+        };
+        APP.captureChanged = true;
+        APP.captureSeq = frame.sequence;
+    };
+
+
+
+
+    // Decodes a base64 binary frame to its sequence, full flag and values
+    APP.decodeFrame = function(text) {
+
+        var binary = atob(text);
+        var bytes = new Uint8Array(binary.length);
+        for (var i = 0; i < binary.length; i++) {
+            bytes[i] = binary.charCodeAt(i);
+        }
+
+        var view = new DataView(bytes.buffer);
+        var format = view.getUint8(1);
+        var flags = view.getUint8(2);
+        var count = view.getUint32(8, true);
+        var scale = view.getFloat32(12, true);
+        var offset = view.getFloat32(16, true);
+
+        var values = new Array(count);
+        if (format == 1) {
+            for (var i = 0; i < count; i++) {
+                values[i] = view.getFloat32(20 + 4 * i, true);
+            }
+        } else if (format == 2) {
+            var code = 0;
+            for (var i = 0; i < count; i++) {
+                var word = view.getUint16(20 + 2 * i, true);
+                code = flags & 2 ? (code + word) & 0xffff : word;
+                values[i] = (code << 16 >> 16) * scale + offset;
+            }
+        } else if (format == 4) {
+            for (var i = 0; i < count; i++) {
+                values[i] = APP.halfToFloat(view.getUint16(20 + 2 * i, true));
+            }
+        }
+
+        return {
+            sequence: view.getUint32(4, true),
+            full: (flags & 1) != 0,
+            values: values
+        };
+    };
+
+
+
+
+    // IEEE half precision to number
+    APP.halfToFloat = function(h) {
+
+        var sign = h & 0x8000 ? -1 : 1;
+        var exponent = (h >> 10) & 0x1f;
+        var mantissa = h & 0x3ff;
+
+        if (exponent == 0)
+            return sign * mantissa * Math.pow(2, -24);
+        if (exponent == 31)
+            return mantissa ? NaN : sign * Infinity;
+        return sign * (1 + mantissa / 1024) * Math.pow(2, exponent - 15);
+    };
+
+
+
+
+    // Draws a capture: the column minima and maxima as two lines around
+    // the trigger at time 0
+    APP.processSignals = function(new_signals) {
+
+        var min = new_signals['CH1_MIN'].value;
+        var max = new_signals['CH1_MAX'].value;
+        var step = APP.timeSpan / max.length;
+        var start = -APP.timeSpan / 2;
+
+        var lower = [];
+        var upper = [];
+        for (var i = 0; i < max.length; i++) {
+            var t = start + i * step;
+            lower.push([t, min[i]]);
+            upper.push([t, max[i]]);
+        }
+
+        // Update graph
+        APP.plot.setData([{ data: lower, color: '#f0c000' }, { data: upper, color: '#f0c000' }]);
+        APP.plot.getAxes().xaxis.options.min = start;
+        APP.plot.getAxes().xaxis.options.max = -start;
+        APP.plot.setupGrid();
+        APP.plot.draw();
+    };
+
+
+
+
+    //Handler, draws the newest capture once and acknowledges it, so the
+    //controller only sends as fast as it is drawn
+    APP.signalHandler = function() {
+        if (APP.captureChanged) {
+            APP.captureChanged = false;
+            APP.processSignals(APP.capture);
+            APP.drawnNow++;
+            if (APP.captureSeq >= 0) {
+                APP.sendParameter('FRAME_ACK', APP.clientId * 16777216 + APP.captureSeq);
+            }
+        }
+    }
+    setInterval(APP.signalHandler, 15);
+
+    //Draw rate
+    setInterval(function() {
+        APP.drawn = APP.drawnNow;
+        APP.drawnNow = 0;
+    }, 1000);
+
+
+}(window.APP = window.APP || {}, jQuery));
+
+
+
+
+// Page onload event handler
+$(function() {
+
+    //Init plot
+    APP.plot = $.plot($("#placeholder"), [], {
+                series: {
+                    shadowSize: 0, // Drawing is faster without shadows
+                },
+                yaxis: {
+                    min: -1,
+                    max: 1
+                },
+                xaxis: {
+                    min: -1,
+                    max: 1
+                }
+    });
+
+    // Decimation change
+    $("#decimation_set").on("change", function() {
+
+        APP.setDecimation();
+    });
+
+    // Trigger level change
+    $("#trigger_level_set").on("change input", function() {
+
+        APP.setTriggerLevel();
+    });
+
+    // Trigger source or mode change
+    $("#trigger_source_set, #trigger_mode_set").on("change", function() {
+
+        APP.setTrigger();
+    });
+
+    // Start application
+    APP.startApp();
+});
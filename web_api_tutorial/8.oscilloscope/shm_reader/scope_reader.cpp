@@ -0,0 +1,143 @@
+// Reads the captures the oscilloscope app publishes to shared memory, next
+// to the web UI and without touching the hardware. Prints a line a second,
+// optionally records every capture and reports captures over a level:
+//
+//   scope_reader [-o file] [-a level] [-n captures] [-r ring]
+//
+// -o appends the raw float samples of every capture to file, -a prints
+// every capture with a sample beyond +-level volts, -n stops after that many
+// captures. The app has to run, the reader waits for it otherwise.
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+#include "shm_ring.h"
+
+
+
+
+volatile sig_atomic_t g_stop = 0;
+
+
+void on_signal(int)
+{
+    g_stop = 1;
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *ring = "/rp_scope";
+    const char *output = NULL;
+    double alarm_level = 0;
+    uint64_t limit = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "o:a:n:r:")) != -1)
+    {
+        switch (option)
+        {
+        case 'o': output = optarg; break;
+        case 'a': alarm_level = atof(optarg); break;
+        case 'n': limit = strtoull(optarg, NULL, 10); break;
+        case 'r': ring = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-o file] [-a level] [-n captures] [-r ring]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    FILE *file = NULL;
+    if (output && !(file = fopen(output, "ab")))
+    {
+        perror(output);
+        return 1;
+    }
+
+    ShmRingReader reader;
+    std::vector<float> copy;
+    uint64_t captures = 0;
+    uint64_t alarms = 0;
+    while (!g_stop && (!limit || captures < limit))
+    {
+        // Wait for the app, and for it again after it restarted
+        if (!reader.writer_open())
+        {
+            if (!reader.open(ring))
+            {
+                sleep(1);
+                continue;
+            }
+            fprintf(stderr, "Reading %s, %u samples a capture\n", ring, reader.capacity());
+            copy.resize(reader.capacity());
+        }
+
+        // Per second: captures, lost captures, peak and RMS of the last one
+        int64_t second = shm_ring_now_ns() + 1000000000LL;
+        uint64_t count = 0;
+        double peak = 0, rms = 0, latency_ms = 0;
+        ShmFrameInfo info;
+        while (!g_stop && (!limit || captures < limit) && shm_ring_now_ns() < second)
+        {
+            // Recorded captures are copied, the rest is read in place
+            const float *values = NULL;
+            if (file)
+            {
+                if (reader.copy_next(copy.data(), &info, 100))
+                    values = copy.data();
+            }
+            else values = reader.next(&info, 100);
+            if (!values)
+            {
+                if (!reader.writer_open())
+                    break;
+                continue;
+            }
+
+            double p = 0, sum = 0;
+            for (uint32_t i = 0; i < info.count; i++)
+            {
+                p = fabs(values[i]) > p ? fabs(values[i]) : p;
+                sum += values[i] * values[i];
+            }
+            if (!file && !reader.still_valid())
+                continue;
+
+            latency_ms = (shm_ring_now_ns() - info.time_ns) * 1e-6;
+            peak = p;
+            rms = info.count ? sqrt(sum / info.count) : 0;
+            count++;
+            captures++;
+
+            if (file)
+                fwrite(values, sizeof(float), info.count, file);
+            if (alarm_level > 0 && p > alarm_level)
+            {
+                alarms++;
+                printf("capture %llu: peak %.3f V over %.3f V%s\n",
+                       (unsigned long long)info.number, p, alarm_level,
+                       info.flags & SHM_FRAME_TRIGGERED ? "" : " (not triggered)");
+            }
+        }
+        if (count)
+        {
+            printf("%llu captures/s, %llu lost, %.0f S/s, peak %.3f V, rms %.3f V, %.2f ms after publishing\n",
+                   (unsigned long long)count, (unsigned long long)reader.lost(),
+                   info.sample_rate, peak, rms, latency_ms);
+            fflush(stdout);
+        }
+    }
+
+    fprintf(stderr, "%llu captures read, %llu lost, %llu alarms\n",
+            (unsigned long long)captures, (unsigned long long)reader.lost(),
+            (unsigned long long)alarms);
+    if (file)
+        fclose(file);
+    return 0;
+}
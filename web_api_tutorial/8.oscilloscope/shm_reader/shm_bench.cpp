@@ -0,0 +1,233 @@
+// Throughput and latency of the shared memory ring with several reader
+// processes. The parent publishes captures of the size the oscilloscope app
+// publishes, once at the app's capture rate and once as fast as it can; the
+// readers are forked processes that read every value of every capture in
+// place. No hardware is needed.
+//
+//   shm_bench [-s seconds] [-c samples] [-k slots] [-f captures/s]
+//
+// Latency is from the start of publishing a capture to a reader having
+// checked it, captures a reader was lapped on are counted as lost.
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "shm_ring.h"
+
+
+
+
+#define BENCH_RING "/rp_scope_bench"
+#define MAX_READERS 8
+
+
+struct ReaderResult
+{
+    uint64_t captures;
+    uint64_t lost;
+    uint64_t torn;
+    double seconds;
+    double p50_us;
+    double p99_us;
+    double max_us;
+};
+
+
+// One reader process: reads until the writer closes the ring, then writes
+// its result to fd
+void run_reader(int ready_fd, int result_fd)
+{
+    ShmRingReader reader;
+    ReaderResult result;
+    memset(&result, 0, sizeof(result));
+    const bool opened = reader.open(BENCH_RING);
+    const char ready = opened ? 1 : 0;
+    if (write(ready_fd, &ready, 1) != 1 || !opened)
+        _exit(1);
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(1 << 20);
+    int64_t first = 0, last = 0;
+    volatile float sink = 0;
+    ShmFrameInfo info;
+    while (true)
+    {
+        const float *values = reader.next(&info, 1000);
+        if (!values)
+        {
+            if (!reader.writer_open())
+                break;
+            continue;
+        }
+        float sum = 0;
+        for (uint32_t i = 0; i < info.count; i++)
+            sum += values[i];
+        if (!reader.still_valid())
+        {
+            result.torn++;
+            continue;
+        }
+        sink = sum;
+        const int64_t now = shm_ring_now_ns();
+        if (!first)
+            first = now;
+        last = now;
+        latencies.push_back(now - info.time_ns);
+    }
+    (void)sink;
+
+    result.captures = latencies.size();
+    result.lost = reader.lost();
+    result.seconds = (last - first) * 1e-9;
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        result.p50_us = latencies[latencies.size() / 2] * 1e-3;
+        result.p99_us = latencies[latencies.size() * 99 / 100] * 1e-3;
+        result.max_us = latencies.back() * 1e-3;
+    }
+    if (write(result_fd, &result, sizeof(result)) != sizeof(result))
+        _exit(1);
+    _exit(0);
+}
+
+
+// One run, rate 0 publishes as fast as possible
+bool run(int readers, double seconds, uint32_t samples, uint32_t slots, double rate)
+{
+    ShmRingWriter writer;
+    if (!writer.create(BENCH_RING, slots, samples))
+    {
+        perror("shm_open");
+        return false;
+    }
+
+    int ready_pipe[2], result_pipe[2];
+    if (pipe(ready_pipe) || pipe(result_pipe))
+        return false;
+    std::vector<pid_t> children;
+    for (int i = 0; i < readers; i++)
+    {
+        const pid_t pid = fork();
+        if (pid == 0)
+            run_reader(ready_pipe[1], result_pipe[1]);
+        children.push_back(pid);
+    }
+    for (int i = 0; i < readers; i++)
+    {
+        char ready = 0;
+        if (read(ready_pipe[0], &ready, 1) != 1 || !ready)
+            return false;
+    }
+
+    std::vector<float> capture(samples);
+    for (uint32_t i = 0; i < samples; i++)
+        capture[i] = (float)i / samples;
+    ShmFrameInfo info;
+    memset(&info, 0, sizeof(info));
+    info.sample_rate = 125e6;
+    info.trigger_index = samples / 2;
+
+    const int64_t period = rate > 0 ? (int64_t)(1e9 / rate) : 0;
+    const int64_t start = shm_ring_now_ns();
+    const int64_t end = start + (int64_t)(seconds * 1e9);
+    int64_t next = start;
+    int64_t publish_ns = 0;
+    while (true)
+    {
+        if (period)
+        {
+            struct timespec ts;
+            ts.tv_sec = next / 1000000000LL;
+            ts.tv_nsec = next % 1000000000LL;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+            next += period;
+        }
+        const int64_t now = shm_ring_now_ns();
+        if (now >= end)
+            break;
+        capture[0] = (float)writer.frames();
+        writer.publish(capture.data(), samples, info);
+        publish_ns += shm_ring_now_ns() - now;
+    }
+    const double elapsed = (shm_ring_now_ns() - start) * 1e-9;
+    const uint64_t published = writer.frames();
+    writer.close();
+
+    ReaderResult total;
+    memset(&total, 0, sizeof(total));
+    double rate_sum = 0;
+    for (int i = 0; i < readers; i++)
+    {
+        ReaderResult r;
+        if (read(result_pipe[0], &r, sizeof(r)) != sizeof(r))
+            return false;
+        total.captures += r.captures;
+        total.lost += r.lost;
+        total.torn += r.torn;
+        total.p50_us = std::max(total.p50_us, r.p50_us);
+        total.p99_us = std::max(total.p99_us, r.p99_us);
+        total.max_us = std::max(total.max_us, r.max_us);
+        rate_sum += r.seconds > 0 ? r.captures / r.seconds : 0;
+    }
+    for (size_t i = 0; i < children.size(); i++)
+        waitpid(children[i], NULL, 0);
+    close(ready_pipe[0]);
+    close(ready_pipe[1]);
+    close(result_pipe[0]);
+    close(result_pipe[1]);
+
+    const double mb = (double)samples * sizeof(float) / 1e6;
+    printf("%-8s %7d %10.0f %8.1f %7.1f %8.0f %8llu %6llu %8.1f %8.1f %9.1f\n",
+           rate > 0 ? "paced" : "flat out", readers,
+           published / elapsed, published * mb / elapsed,
+           publish_ns * 1e-3 / (published ? published : 1),
+           rate_sum / readers,
+           (unsigned long long)(total.lost / readers),
+           (unsigned long long)total.torn,
+           total.p50_us, total.p99_us, total.max_us);
+    fflush(stdout);
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    double seconds = 3;
+    uint32_t samples = 16384;
+    uint32_t slots = 32;
+    double rate = 50;
+
+    int option;
+    while ((option = getopt(argc, argv, "s:c:k:f:")) != -1)
+    {
+        switch (option)
+        {
+        case 's': seconds = atof(optarg); break;
+        case 'c': samples = strtoul(optarg, NULL, 10); break;
+        case 'k': slots = strtoul(optarg, NULL, 10); break;
+        case 'f': rate = atof(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-s seconds] [-c samples] [-k slots] [-f captures/s]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%u samples a capture, %u slots, %.0f s a run\n", samples, slots, seconds);
+    printf("%-8s %7s %10s %8s %7s %8s %8s %6s %8s %8s %9s\n",
+           "writer", "readers", "captures/s", "MB/s", "pub us",
+           "read/s", "lost", "torn", "p50 us", "p99 us", "max us");
+    const double rates[] = {rate, 0};
+    for (int r = 0; r < 2; r++)
+    {
+        for (int readers = 1; readers <= MAX_READERS; readers *= 2)
+        {
+            if (!run(readers, seconds, samples, slots, rates[r]))
+                return 1;
+        }
+    }
+    return 0;
+}
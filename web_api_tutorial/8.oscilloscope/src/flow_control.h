@@ -0,0 +1,289 @@
+#pragma once
+
+
+#include <mutex>
+#include <stdint.h>
+#include <time.h>
+
+
+
+
+struct FlowStats
+{
+    // Current send interval in ms and points per frame
+    double interval_ms;
+    int points;
+    // Frames sent and acknowledged per second, and points acknowledged per
+    // second, since the previous call of stats()
+    double send_rate;
+    double client_rate;
+    double client_points;
+    // Mean time from sending a frame to its acknowledgement, in ms
+    double latency_ms;
+    // Updates held back because the client was behind, and frames never
+    // acknowledged in time
+    uint64_t held;
+    uint64_t timeouts;
+    // Clients that acknowledged frames lately, flow control is off for
+    // more than one
+    int clients;
+};
+
+
+// Flow control of signal frames to one client. The client acknowledges the
+// sequence number of each frame once it has drawn it. At most window frames
+// are in flight; an update while the client is behind is held back, and the
+// capture it would have sent is replaced by a newer one instead of queued.
+//
+// The send interval and the points per frame adapt to the client: when the
+// window was full before an acknowledgement came, the client or the link is
+// too slow. The interval then grows by half up to points_interval_ms, after
+// that the points are halved down to min_points, and only then the interval
+// grows further. Each acknowledgement without the window filling up takes
+// the same steps back, the interval by an eighth and the points doubled
+// after good_acks of them. A client that acknowledges nothing for
+// timeout_ms, such as an old one, is sent frames at the longest interval.
+//
+// All clients share the signals and the acknowledgement parameter, so
+// this only works for one client. Each client acknowledges with its own
+// id in the bits above the sequence. While acknowledgements of more than
+// one id came in within twice timeout_ms, flow control is off: frames of
+// max_points go out every points_interval_ms whatever the clients ack.
+class FlowControl
+{
+public:
+    // Sequence numbers travel as float signal values, exact up to 2^24
+    static const uint32_t SEQUENCE_MASK = 0xffffff;
+    // Acknowledgements are client << CLIENT_SHIFT | sequence, 0 for a
+    // client that sends no id
+    static const int CLIENT_SHIFT = 24;
+    static const int MAX_CLIENTS = 128;
+
+    FlowControl(int min_interval_ms, int points_interval_ms,
+                int max_interval_ms, int min_points, int max_points,
+                int window, int timeout_ms = 1000, int good_acks = 10)
+        : m_min_interval(min_interval_ms * 1e-3),
+          m_points_interval(points_interval_ms * 1e-3),
+          m_max_interval(max_interval_ms * 1e-3), m_min_points(min_points),
+          m_max_points(max_points), m_window(window),
+          m_timeout(timeout_ms * 1e-3), m_good_acks(good_acks),
+          m_interval(min_interval_ms * 1e-3), m_points(max_points),
+          m_sent(0), m_acked(0), m_good(0), m_blocked(false),
+          m_last_send(-1e9), m_last_ack(0), m_held(0), m_timeouts(0),
+          m_sends(0), m_acks(0), m_acked_points(0), m_latency(0),
+          m_last_stats(0), m_last_sends(0), m_last_acks(0),
+          m_last_acked_points(0), m_last_latency(0), m_clients(0)
+    {
+        m_start_ns = now_ns();
+        for (int i = 0; i < HISTORY; i++)
+        {
+            m_send_time[i] = 0;
+            m_send_points[i] = 0;
+        }
+        for (int i = 0; i < MAX_CLIENTS; i++)
+            m_client_ack[i] = -1e9;
+    }
+
+    // True when a frame may be sent now
+    bool ready()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const double now = seconds();
+        if (update_clients(now) > 1)
+            return now - m_last_send >= m_points_interval;
+        if (now - m_last_send < m_interval)
+            return false;
+
+        if (in_flight() >= (uint32_t)m_window)
+        {
+            // Frames lost or a client that never acknowledges
+            if (now - m_last_ack < m_timeout || now - m_last_send < m_timeout)
+            {
+                m_held++;
+                m_blocked = true;
+                return false;
+            }
+            m_timeouts++;
+            m_acked = m_sent;
+            m_interval = m_max_interval;
+            m_good = 0;
+        }
+        return true;
+    }
+
+    // Points the next frame should have
+    int points()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_clients > 1 ? m_max_points : m_points;
+    }
+
+    // Records a frame of the given points as sent, returns its sequence
+    uint32_t sent(int points)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sent = (m_sent + 1) & SEQUENCE_MASK;
+        m_last_send = seconds();
+        m_send_time[m_sent % HISTORY] = m_last_send;
+        m_send_points[m_sent % HISTORY] = points;
+        m_sends++;
+        return m_sent;
+    }
+
+    // A client drew the frame with this sequence and all before it
+    void ack(uint32_t value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const double now = seconds();
+        m_client_ack[(value >> CLIENT_SHIFT) % MAX_CLIENTS] = now;
+        if (update_clients(now) > 1)
+            return;
+
+        const uint32_t sequence = value & SEQUENCE_MASK;
+        const uint32_t advance = (sequence - m_acked) & SEQUENCE_MASK;
+        // A stale acknowledgement, or one from before a reconnect
+        if (advance == 0 || advance > ((m_sent - m_acked) & SEQUENCE_MASK))
+            return;
+
+        for (uint32_t i = 1; i <= advance && i <= (uint32_t)HISTORY; i++)
+            m_acked_points += m_send_points[(sequence - advance + i) % HISTORY];
+        m_latency += now - m_send_time[sequence % HISTORY];
+        m_acks++;
+        m_acked = sequence;
+        m_last_ack = now;
+
+        if (m_blocked)
+        {
+            // Slow down to the points interval, then send fewer points,
+            // then slow down further
+            m_blocked = false;
+            m_good = 0;
+            if (m_interval < m_points_interval)
+                m_interval = min(m_interval * 1.5, m_points_interval);
+            else if (m_points > m_min_points)
+                m_points /= 2;
+            else
+                m_interval = min(m_interval * 1.5, m_max_interval);
+        }
+        else if (m_interval > m_points_interval)
+        {
+            m_interval = max(m_interval * 7 / 8, m_points_interval);
+        }
+        else if (m_points < m_max_points)
+        {
+            // A frame of twice the points has to be drawn in the same time,
+            // so only after a run of acknowledgements
+            if (++m_good >= m_good_acks)
+            {
+                m_good = 0;
+                m_points *= 2;
+            }
+        }
+        else
+        {
+            m_interval = max(m_interval * 7 / 8, m_min_interval);
+        }
+    }
+
+    // Seconds since construction
+    double seconds() const { return (now_ns() - m_start_ns) * 1e-9; }
+
+    FlowStats stats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        FlowStats s;
+        const double now = seconds();
+        const double window = now - m_last_stats;
+        const uint64_t acks = m_acks - m_last_acks;
+        s.interval_ms = m_interval * 1e3;
+        s.points = m_points;
+        s.send_rate = window > 0 ? (m_sends - m_last_sends) / window : 0;
+        s.client_rate = window > 0 ? acks / window : 0;
+        s.client_points = window > 0 ? (m_acked_points - m_last_acked_points) / window : 0;
+        s.latency_ms = acks ? (m_latency - m_last_latency) * 1e3 / acks : 0;
+        s.held = m_held;
+        s.timeouts = m_timeouts;
+        s.clients = update_clients(now);
+        m_last_stats = now;
+        m_last_sends = m_sends;
+        m_last_acks = m_acks;
+        m_last_acked_points = m_acked_points;
+        m_last_latency = m_latency;
+        return s;
+    }
+
+private:
+    // Send times kept for the latency, more than any sensible window
+    static const int HISTORY = 64;
+
+    static int64_t now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    static double min(double a, double b) { return a < b ? a : b; }
+    static double max(double a, double b) { return a > b ? a : b; }
+
+    uint32_t in_flight() const { return (m_sent - m_acked) & SEQUENCE_MASK; }
+
+    // Counts the clients that acknowledged lately. Back to one client, the
+    // frames sent meanwhile count as acknowledged.
+    int update_clients(double now)
+    {
+        int clients = 0;
+        for (int i = 0; i < MAX_CLIENTS; i++)
+            clients += now - m_client_ack[i] < 2 * m_timeout;
+        if (m_clients > 1 && clients <= 1)
+        {
+            m_acked = m_sent;
+            m_last_ack = now;
+            m_blocked = false;
+        }
+        m_clients = clients;
+        return clients;
+    }
+
+    const double m_min_interval;
+    const double m_points_interval;
+    const double m_max_interval;
+    const int m_min_points;
+    const int m_max_points;
+    const int m_window;
+    const double m_timeout;
+    const int m_good_acks;
+
+    std::mutex m_mutex;
+    int64_t m_start_ns;
+    double m_interval;
+    int m_points;
+
+    uint32_t m_sent;
+    uint32_t m_acked;
+    int m_good;
+    // The window filled up since the last acknowledgement
+    bool m_blocked;
+    double m_last_send;
+    double m_last_ack;
+    double m_send_time[HISTORY];
+    int m_send_points[HISTORY];
+
+    uint64_t m_held;
+    uint64_t m_timeouts;
+    uint64_t m_sends;
+    uint64_t m_acks;
+    uint64_t m_acked_points;
+    double m_latency;
+
+    // Totals at the previous stats() call
+    double m_last_stats;
+    uint64_t m_last_sends;
+    uint64_t m_last_acks;
+    uint64_t m_last_acked_points;
+    double m_last_latency;
+
+    // When each client id last acknowledged, and how many did lately
+    double m_client_ack[MAX_CLIENTS];
+    int m_clients;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+
+#include <stdint.h>
+#include <string>
+#include <time.h>
+
+#include "signal_frame.h"
+
+
+
+
+// Encode-once cache of the binary frame of one signal snapshot. Every
+// snapshot gets a new version; the first get() for a version encodes it,
+// every later one returns the same text without touching the values. A
+// new version or format invalidates the cached text.
+//
+// UpdateParams runs once per parameter tick, not once per client, so the
+// reuses are the ticks on which the snapshot had not changed yet, as when
+// flow control holds frames back. The frame parameter is still set on
+// those ticks; only the encoding is skipped. Only binary frames go through
+// the cache; JSON signals are written by the SDK from the signal values.
+class FrameCache
+{
+public:
+    FrameCache()
+        : m_text(NULL), m_version(0), m_format(-1), m_encodes(0),
+          m_reuses(0), m_encode_ns(0)
+    {
+    }
+
+    // The frame of snapshot version in format, values and count are only
+    // read when it is not cached. Valid until the next call.
+    const std::string &get(uint32_t version, int format, const float *values,
+                           int count)
+    {
+        if (m_text && version == m_version && format == m_format)
+        {
+            m_reuses++;
+            return *m_text;
+        }
+
+        const int64_t start = now_ns();
+        m_encoder.set_sequence(version);
+        m_text = &m_encoder.encode(values, count, format, true);
+        m_encode_ns += now_ns() - start;
+        m_version = version;
+        m_format = format;
+        m_encodes++;
+        return *m_text;
+    }
+
+    uint64_t encodes() const { return m_encodes; }
+    uint64_t reuses() const { return m_reuses; }
+    // Total encoding time in ms
+    double encode_ms() const { return m_encode_ns * 1e-6; }
+
+private:
+    static int64_t now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    SignalFrameEncoder m_encoder;
+    const std::string *m_text;
+    uint32_t m_version;
+    int m_format;
+
+    uint64_t m_encodes;
+    uint64_t m_reuses;
+    int64_t m_encode_ns;
+};
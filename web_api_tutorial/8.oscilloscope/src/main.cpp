@@ -0,0 +1,527 @@
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/sysinfo.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "main.h"
+#include "scope_capture.h"
+#include "flow_control.h"
+#include "frame_cache.h"
+#include "startup_profile.h"
+#include "shm_ring.h"
+
+
+
+
+//Signal size, one point per plot column
+#define SIGNAL_SIZE_DEFAULT      1024
+#define SIGNAL_UPDATE_INTERVAL     20
+
+//Captures per second at most, bounds the controller CPU
+#define CAPTURE_MAX_RATE           50
+
+//Flow control: send interval in ms before fewer points are sent, slowest
+//send interval, fewest points per frame and frames sent but not yet
+//acknowledged by the client
+#define FLOW_POINTS_INTERVAL      100
+#define FLOW_MAX_INTERVAL         500
+#define FLOW_MIN_POINTS           128
+#define FLOW_WINDOW                 2
+
+//Lazy initialization: rp_app_init returns at once and the hardware is set
+//up on its own thread at the first callback of the web SDK
+#define LAZY_INIT                   1
+
+//Every capture is published to a ring in shared memory, /dev/shm/rp_scope,
+//for local processes to read with shm_ring.h. SHM_RING_SLOTS captures of
+//ADC_BUFFER_SIZE samples each, 64 kB a capture.
+#define SHM_RING_NAME        "/rp_scope"
+#define SHM_RING_SLOTS             32
+
+
+//Signals, smallest and largest sample of each column
+CFloatSignal CH1_MIN("CH1_MIN", SIGNAL_SIZE_DEFAULT, 0.0f);
+CFloatSignal CH1_MAX("CH1_MAX", SIGNAL_SIZE_DEFAULT, 0.0f);
+//Sequence number of the frame, acknowledged by the client once drawn
+CFloatSignal FRAME_SEQ("FRAME_SEQ", 1, 0.0f);
+
+
+//Parameters
+CIntParameter DECIMATION("DECIMATION", CBaseParameter::RW, 64, 0, 1, 65536);
+CFloatParameter TRIGGER_LEVEL("TRIGGER_LEVEL", CBaseParameter::RW, 0.0, 0, -1.0, 1.0);
+CIntParameter TRIGGER_SOURCE("TRIGGER_SOURCE", CBaseParameter::RW, 0, 0, 0, 2);
+CIntParameter TRIGGER_MODE("TRIGGER_MODE", CBaseParameter::RW, 0, 0, 0, 1);
+CIntParameter FRAME_ACK("FRAME_ACK", CBaseParameter::RW, 0, 0, 0, INT_MAX);
+
+//Binary frame of the capture, the minima then the maxima, sent instead of
+//the signals unless FRAME_FORMAT is JSON
+CIntParameter FRAME_FORMAT("FRAME_FORMAT", CBaseParameter::RW, FRAME_JSON, 0, FRAME_JSON, FRAME_FLOAT16);
+CStringParameter CAPTURE_FRAME("CAPTURE_FRAME", CBaseParameter::RO, "", 0);
+
+//Capture length in ms and statistics, updated once a second
+CFloatParameter TIME_SPAN("TIME_SPAN", CBaseParameter::RO, 0, 0, 0, 1e6);
+CFloatParameter REFRESH_RATE("REFRESH_RATE", CBaseParameter::RO, 0, 0, 0, 1e3);
+CFloatParameter CAPTURE_MS("CAPTURE_MS", CBaseParameter::RO, 0, 0, 0, 1e6);
+CIntParameter DROPPED_FRAMES("DROPPED_FRAMES", CBaseParameter::RO, 0, 0, 0, INT_MAX);
+CBooleanParameter TRIGGERED("TRIGGERED", CBaseParameter::RO, false, 0);
+
+//Flow control state, updated once a second
+CFloatParameter SEND_INTERVAL("SEND_INTERVAL", CBaseParameter::RO, SIGNAL_UPDATE_INTERVAL, 0, 0, 1e6);
+CIntParameter FRAME_POINTS("FRAME_POINTS", CBaseParameter::RO, SIGNAL_SIZE_DEFAULT, 0, 0, SIGNAL_SIZE_DEFAULT);
+CFloatParameter CLIENT_RATE("CLIENT_RATE", CBaseParameter::RO, 0, 0, 0, 1e3);
+CFloatParameter CLIENT_LATENCY("CLIENT_LATENCY", CBaseParameter::RO, 0, 0, 0, 1e6);
+CIntParameter HELD_UPDATES("HELD_UPDATES", CBaseParameter::RO, 0, 0, 0, INT_MAX);
+CIntParameter FLOW_CLIENTS("FLOW_CLIENTS", CBaseParameter::RO, 0, 0, 0, FlowControl::MAX_CLIENTS);
+
+//Binary frames encoded and answered from the cache, updated once a second
+CIntParameter FRAME_ENCODES("FRAME_ENCODES", CBaseParameter::RO, 0, 0, 0, INT_MAX);
+CIntParameter FRAME_REUSES("FRAME_REUSES", CBaseParameter::RO, 0, 0, 0, INT_MAX);
+
+//Startup, time of the init stages and from the load to the first frame, ms
+CFloatParameter STARTUP_MS("STARTUP_MS", CBaseParameter::RO, 0, 0, 0, 1e6);
+CFloatParameter FIRST_FRAME_MS("FIRST_FRAME_MS", CBaseParameter::RO, 0, 0, 0, 1e6);
+
+//Set when the hardware init failed, nothing is captured then
+CBooleanParameter HARDWARE_FAILED("HARDWARE_FAILED", CBaseParameter::RO, false, 0);
+
+//Captures published to shared memory, updated once a second
+CIntParameter SHM_FRAMES("SHM_FRAMES", CBaseParameter::RO, 0, 0, 0, INT_MAX);
+
+
+ScopeCapture g_capture(SIGNAL_SIZE_DEFAULT, CAPTURE_MAX_RATE);
+FlowControl g_flow(SIGNAL_UPDATE_INTERVAL, FLOW_POINTS_INTERVAL, FLOW_MAX_INTERVAL, FLOW_MIN_POINTS, SIGNAL_SIZE_DEFAULT, FLOW_WINDOW);
+int g_sdk_interval = SIGNAL_UPDATE_INTERVAL;
+
+//Last capture sent, the minima then the maxima, and its sequence number as
+//the version of the cached frame. UpdateSignals builds the next one in
+//g_snapshot_next and swaps it in under the mutex, UpdateParams encodes it
+//under the mutex. UpdateSignals is the only writer and reads without it
+std::vector<float> g_snapshot;
+std::vector<float> g_snapshot_next;
+uint32_t g_snapshot_version = 0;
+std::mutex g_snapshot_mutex;
+FrameCache g_frame_cache;
+ShmRingWriter g_shm;
+
+//Hardware state. The first callback goes from HW_NONE to HW_STARTING and
+//its init thread on to HW_INITIALIZED or HW_FAILED; the first callback after
+//that from HW_INITIALIZED over HW_CAPTURE_STARTING to HW_RUNNING.
+enum HardwareState
+{
+    HW_NONE,
+    HW_STARTING,
+    HW_INITIALIZED,
+    HW_CAPTURE_STARTING,
+    HW_RUNNING,
+    HW_FAILED
+};
+std::atomic<int> g_hardware(HW_NONE);
+std::thread g_init_thread;
+StartupProfile g_startup;
+double g_stats_time = 1;
+
+
+
+
+
+
+
+
+// Hands the parameters to the capture thread
+void set_capture_config()
+{
+    ScopeSettings settings;
+    settings.decimation = DECIMATION.Value();
+    settings.trigger_level = TRIGGER_LEVEL.Value();
+    settings.trigger_source = TRIGGER_SOURCE.Value();
+    settings.trigger_auto = TRIGGER_MODE.Value() == 0;
+    settings.trigger_timeout_ms = 100;
+    g_capture.configure(settings);
+}
+
+
+// Hardware and calibration, everything that does not need the web SDK
+bool init_hardware()
+{
+    // Initialization of API
+    if (rpApp_Init() != RP_OK)
+    {
+        fprintf(stderr, "Red Pitaya API init failed!\n");
+        return false;
+    }
+    else fprintf(stderr, "Red Pitaya API init success!\n");
+    g_startup.mark("rpApp_Init");
+
+    rp_AcqReset();
+    g_startup.mark("acquisition reset");
+    return true;
+}
+
+
+// Publishes a capture to the shared memory ring. On the capture thread.
+void publish_capture(const float *samples, uint32_t count, const ScopeFrame &frame)
+{
+    ShmFrameInfo info;
+    memset(&info, 0, sizeof(info));
+    info.sample_rate = count / frame.span;
+    info.trigger_index = count / 2;
+    info.flags = frame.triggered ? SHM_FRAME_TRIGGERED : 0;
+    g_shm.publish(samples, count, info);
+}
+
+
+// True once the capture runs. In lazy mode the first call starts the
+// hardware init, the first call after it is done starts the capture. The
+// web SDK calls it from UpdateSignals, UpdateParams and OnNewParams, which
+// may run at the same time: only the caller that wins the state change
+// does either step, the others return false meanwhile.
+bool hardware_running()
+{
+    int state = g_hardware;
+    if (state == HW_RUNNING)
+    {
+        return true;
+    }
+    if (state == HW_NONE)
+    {
+        if (g_hardware.compare_exchange_strong(state, HW_STARTING))
+        {
+            g_startup.skip();
+            g_init_thread = std::thread([] {
+                g_hardware = init_hardware() ? HW_INITIALIZED : HW_FAILED;
+            });
+        }
+        return false;
+    }
+    if (state != HW_INITIALIZED || !g_hardware.compare_exchange_strong(state, HW_CAPTURE_STARTING))
+    {
+        return false;
+    }
+
+    //Start capturing in the background
+    if (g_init_thread.joinable())
+    {
+        g_init_thread.join();
+    }
+    set_capture_config();
+    if (g_shm.create(SHM_RING_NAME, SHM_RING_SLOTS, ADC_BUFFER_SIZE))
+    {
+        g_capture.set_sink(publish_capture);
+    }
+    else fprintf(stderr, "Shared memory ring %s failed: %s\n", SHM_RING_NAME, strerror(errno));
+    g_startup.mark("shared memory");
+    g_capture.start();
+    g_startup.mark("capture start");
+    g_hardware = HW_RUNNING;
+    return true;
+}
+
+
+// Writes a capture to the next snapshot with the given points, each the min
+// and max of a group of columns
+void write_snapshot(const ScopeFrame *frame, int points)
+{
+    const int group = SIGNAL_SIZE_DEFAULT / points;
+    g_snapshot_next.resize(2 * points);
+    for (int i = 0; i < points; i++)
+    {
+        float lo = frame->min[i * group];
+        float hi = frame->max[i * group];
+        for (int j = i * group + 1; j < (i + 1) * group; j++)
+        {
+            lo = frame->min[j] < lo ? frame->min[j] : lo;
+            hi = frame->max[j] > hi ? frame->max[j] : hi;
+        }
+        g_snapshot_next[i] = lo;
+        g_snapshot_next[points + i] = hi;
+    }
+}
+
+
+// Copies the snapshot to the signals, for JSON clients
+void write_signals()
+{
+    const int points = g_snapshot.size() / 2;
+    if (CH1_MIN.GetSize() != points)
+    {
+        CH1_MIN.Resize(points);
+        CH1_MAX.Resize(points);
+    }
+    for (int i = 0; i < points; i++)
+    {
+        CH1_MIN[i] = g_snapshot[i];
+        CH1_MAX[i] = g_snapshot[points + i];
+    }
+}
+
+
+// Leaves the signals empty, so nothing is sent
+void clear_signals()
+{
+    if (CH1_MIN.GetSize() != 0)
+    {
+        CH1_MIN.Resize(0);
+        CH1_MAX.Resize(0);
+        FRAME_SEQ.Resize(0);
+    }
+}
+
+
+
+
+
+
+
+
+const char *rp_app_desc(void)
+{
+    return (const char *)"Red Pitaya oscilloscope.\n";
+}
+
+
+int rp_app_init(void)
+{
+    fprintf(stderr, "Loading oscilloscope application\n");
+
+    g_startup.restart();
+
+    //Set signal update interval
+    CDataManager::GetInstance()->SetSignalInterval(SIGNAL_UPDATE_INTERVAL);
+    g_startup.mark("web SDK");
+
+    //Hardware now, or at the first callback
+    if (!LAZY_INIT)
+    {
+        if (!init_hardware())
+        {
+            return EXIT_FAILURE;
+        }
+        g_hardware = HW_INITIALIZED;
+        hardware_running();
+    }
+
+    return 0;
+}
+
+
+int rp_app_exit(void)
+{
+    fprintf(stderr, "Unloading oscilloscope application\n");
+
+    //Stop capturing before the API goes away
+    if (g_init_thread.joinable())
+    {
+        g_init_thread.join();
+    }
+    g_capture.stop();
+    g_shm.close();
+    g_startup.log("Oscilloscope");
+    ScopeStats stats = g_capture.stats();
+    fprintf(stderr, "Captures: %llu, %llu taken, %llu dropped, %llu auto triggered, %llu errors\n",
+            (unsigned long long)stats.frames,
+            (unsigned long long)stats.taken,
+            (unsigned long long)stats.dropped,
+            (unsigned long long)stats.auto_triggers,
+            (unsigned long long)stats.errors);
+    FlowStats flow = g_flow.stats();
+    fprintf(stderr, "Flow: %.0f ms interval, %d points, %llu updates held, %llu timeouts\n",
+            flow.interval_ms, flow.points,
+            (unsigned long long)flow.held,
+            (unsigned long long)flow.timeouts);
+    fprintf(stderr, "Frames: %llu encoded in %.1f ms, %llu answered from the cache\n",
+            (unsigned long long)g_frame_cache.encodes(),
+            g_frame_cache.encode_ms(),
+            (unsigned long long)g_frame_cache.reuses());
+    fprintf(stderr, "Shared memory: %llu captures published\n",
+            (unsigned long long)g_shm.frames());
+
+    if (g_hardware != HW_NONE && g_hardware != HW_FAILED)
+    {
+        rpApp_Release();
+    }
+    g_hardware = HW_NONE;
+    HARDWARE_FAILED.Set(false);
+
+    return 0;
+}
+
+
+int rp_set_params(rp_app_params_t *p, int len)
+{
+    return 0;
+}
+
+
+int rp_get_params(rp_app_params_t **p)
+{
+    return 0;
+}
+
+
+int rp_get_signals(float ***s, int *sig_num, int *sig_len)
+{
+    return 0;
+}
+
+
+
+
+
+
+
+
+void UpdateSignals(void)
+{
+    //Nothing before the capture runs
+    if (!hardware_running())
+    {
+        clear_signals();
+        return;
+    }
+
+    //Nothing while the client is behind: the capture stays with the
+    //capture thread and is replaced by newer ones, not queued
+    if (!g_flow.ready())
+    {
+        clear_signals();
+        return;
+    }
+
+    //Write the newest capture to the signals, or leave them empty so an
+    //unchanged capture is not sent again
+    const ScopeFrame *frame = g_capture.take();
+    if (!frame)
+    {
+        clear_signals();
+        return;
+    }
+
+    //A new snapshot, binary clients get it as a frame with the parameters
+    const int points = g_flow.points();
+    write_snapshot(frame, points);
+    {
+        std::lock_guard<std::mutex> lock(g_snapshot_mutex);
+        g_snapshot.swap(g_snapshot_next);
+        g_snapshot_version = g_flow.sent(points);
+    }
+    if (FRAME_FORMAT.Value() == FRAME_JSON)
+    {
+        write_signals();
+        if (FRAME_SEQ.GetSize() != 1)
+        {
+            FRAME_SEQ.Resize(1);
+        }
+        FRAME_SEQ[0] = g_snapshot_version;
+    }
+    else
+    {
+        clear_signals();
+    }
+    TIME_SPAN.Set(frame->span * 1e3);
+    g_startup.first_frame();
+    TRIGGERED.Set(frame->triggered);
+}
+
+
+void UpdateParams(void)
+{
+    if (!hardware_running())
+    {
+        //Report a failed init once, only from here
+        if (g_hardware == HW_FAILED && !HARDWARE_FAILED.Value())
+        {
+            fprintf(stderr, "Hardware init failed, no captures until the app is loaded again\n");
+            HARDWARE_FAILED.Set(true);
+        }
+        return;
+    }
+
+    //Capture statistics, once a second
+    if (g_capture.seconds() >= g_stats_time)
+    {
+        ScopeStats stats = g_capture.stats();
+        REFRESH_RATE.Set(stats.refresh_rate);
+        CAPTURE_MS.Set(stats.capture_ms);
+        DROPPED_FRAMES.Set(stats.dropped);
+
+        FlowStats flow = g_flow.stats();
+        SEND_INTERVAL.Set(flow.interval_ms);
+        FRAME_POINTS.Set(flow.points);
+        CLIENT_RATE.Set(flow.client_rate);
+        CLIENT_LATENCY.Set(flow.latency_ms);
+        HELD_UPDATES.Set(flow.held);
+        //Flow control only works for one client
+        if ((flow.clients > 1) != (FLOW_CLIENTS.Value() > 1))
+        {
+            if (flow.clients > 1)
+                fprintf(stderr, "%d clients acknowledge frames, flow control off\n", flow.clients);
+            else
+                fprintf(stderr, "One client left, flow control on\n");
+        }
+        FLOW_CLIENTS.Set(flow.clients);
+        FRAME_ENCODES.Set(g_frame_cache.encodes());
+        FRAME_REUSES.Set(g_frame_cache.reuses());
+        STARTUP_MS.Set(g_startup.total_ms());
+        FIRST_FRAME_MS.Set(g_startup.first_frame_ms());
+        SHM_FRAMES.Set(g_shm.frames());
+
+        //Wake up the data manager about as often as frames go out
+        const int interval = (int)flow.interval_ms / 2 > SIGNAL_UPDATE_INTERVAL ? (int)flow.interval_ms / 2 : SIGNAL_UPDATE_INTERVAL;
+        if (interval != g_sdk_interval)
+        {
+            CDataManager::GetInstance()->SetSignalInterval(interval);
+            g_sdk_interval = interval;
+        }
+        g_stats_time = g_capture.seconds() + 1;
+    }
+
+    //The last snapshot as a binary frame, encoded once and reused on the
+    //ticks until the next snapshot. The parameter is still set every tick
+    if (FRAME_FORMAT.Value() != FRAME_JSON)
+    {
+        std::lock_guard<std::mutex> lock(g_snapshot_mutex);
+        if (g_snapshot_version != 0)
+        {
+            CAPTURE_FRAME.Set(g_frame_cache.get(g_snapshot_version, FRAME_FORMAT.Value(),
+                                                g_snapshot.data(), g_snapshot.size()));
+        }
+    }
+}
+
+
+void OnNewParams(void)
+{
+    //The client drew a frame
+    if (IS_NEW(FRAME_ACK))
+    {
+        FRAME_ACK.Update();
+        g_flow.ack(FRAME_ACK.Value());
+    }
+    FRAME_FORMAT.Update();
+
+    DECIMATION.Update();
+    TRIGGER_LEVEL.Update();
+    TRIGGER_SOURCE.Update();
+    TRIGGER_MODE.Update();
+
+    //Applied when the capture thread next arms, or when it starts
+    if (hardware_running())
+    {
+        set_capture_config();
+    }
+}
+
+
+void OnNewSignals(void){}
+
+
+void PostUpdateSignals(void){}
\ No newline at end of file
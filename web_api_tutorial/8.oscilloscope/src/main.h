@@ -0,0 +1,42 @@
+#pragma once
+
+
+#include <DataManager.h>
+#include <CustomParameters.h>
+#include "rpApp.h"
+
+
+
+
+#define IS_NEW(X) X.Value() != X.NewValue()
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Parameters description structure - must be the same for all RP controllers */
+typedef struct rp_app_params_s {
+    char  *name;
+    float  value;
+    int    fpga_update;
+    int    read_only;
+    float  min_val;
+    float  max_val;
+} rp_app_params_t;
+
+
+
+/* module entry points */
+const char *rp_app_desc(void);
+int rp_app_init(void);
+int rp_app_exit(void);
+int rp_set_params(rp_app_params_t *p, int len);
+int rp_get_params(rp_app_params_t **p);
+int rp_get_signals(float ***s, int *sig_num, int *sig_len);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,405 @@
+#pragma once
+
+
+#include <atomic>
+#include <errno.h>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#include "rp.h"
+#include "rp_hw-profiles.h"
+#include "triple_buffer.h"
+
+
+
+
+// Capture settings, applied when the acquisition is next armed
+struct ScopeSettings
+{
+    uint32_t decimation;
+    float trigger_level;
+    // 0 rising edge of IN1, 1 falling edge, 2 free running
+    int trigger_source;
+    // Auto mode captures without a trigger after trigger_timeout_ms
+    bool trigger_auto;
+    int trigger_timeout_ms;
+};
+
+
+// One capture reduced to the plot width: the smallest and largest sample of
+// each column, so peaks shorter than a column still show
+struct ScopeFrame
+{
+    uint64_t sequence;
+    bool triggered;
+    // Capture length in seconds, trigger in the middle
+    double span;
+    std::vector<float> min;
+    std::vector<float> max;
+};
+
+
+struct ScopeStats
+{
+    uint64_t frames;
+    uint64_t taken;
+    uint64_t dropped;
+    // Captures made without a trigger in auto mode
+    uint64_t auto_triggers;
+    uint64_t errors;
+    // Frames per second and mean arm to reduced frame time in ms since the
+    // previous call of stats()
+    double refresh_rate;
+    double capture_ms;
+};
+
+
+// Called on the capture thread with every capture before it is reduced:
+// all samples around the trigger and the frame they are reduced to
+typedef std::function<void(const float *samples, uint32_t count, const ScopeFrame &frame)> CaptureSink;
+
+
+// Min and max of every column of in, columns of equal width
+inline void downsample_min_max(const float *in, int n, float *min, float *max, int columns)
+{
+    for (int c = 0; c < columns; c++)
+    {
+        const int begin = (int)((int64_t)n * c / columns);
+        const int end = (int)((int64_t)n * (c + 1) / columns);
+        float lo = in[begin];
+        float hi = in[begin];
+        for (int i = begin + 1; i < end; i++)
+        {
+            lo = in[i] < lo ? in[i] : lo;
+            hi = in[i] > hi ? in[i] : hi;
+        }
+        min[c] = lo;
+        max[c] = hi;
+    }
+}
+
+
+// Captures IN1 over and over on its own thread: arms the acquisition, waits
+// for the pre-trigger half of the buffer and the trigger, reads the buffer
+// around the trigger and reduces it to columns. It re-arms right after the
+// read, at most max_rate times a second, and polls instead of spinning, so
+// its CPU use stays bounded at any decimation. The SDK callbacks only take
+// the newest frame.
+class ScopeCapture
+{
+public:
+    ScopeCapture(int columns, int max_rate)
+        : m_columns(columns), m_min_period_ns(1000000000LL / max_rate),
+          m_settings_version(0), m_running(false), m_stop(false),
+          m_frames(0), m_taken(0), m_dropped(0), m_auto_triggers(0),
+          m_errors(0), m_capture_ns(0), m_start_ns(0), m_last_ns(0),
+          m_last_frames(0), m_last_capture_ns(0)
+    {
+        m_settings.decimation = 64;
+        m_settings.trigger_level = 0;
+        m_settings.trigger_source = 0;
+        m_settings.trigger_auto = true;
+        m_settings.trigger_timeout_ms = 100;
+    }
+
+    ~ScopeCapture() { stop(); }
+
+    // Receives every capture, such as a shared memory ring. Before start().
+    void set_sink(CaptureSink sink) { m_sink = sink; }
+
+    // Only changed settings abandon the capture in progress, the app passes
+    // the same ones on every parameter update
+    void configure(const ScopeSettings &settings)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (settings.decimation == m_settings.decimation &&
+            settings.trigger_level == m_settings.trigger_level &&
+            settings.trigger_source == m_settings.trigger_source &&
+            settings.trigger_auto == m_settings.trigger_auto &&
+            settings.trigger_timeout_ms == m_settings.trigger_timeout_ms)
+            return;
+        m_settings = settings;
+        m_settings_version++;
+    }
+
+    void start()
+    {
+        if (m_running)
+            return;
+        m_stop = false;
+        m_start_ns = now_ns();
+        m_last_ns = m_start_ns;
+        m_running = true;
+        m_thread = std::thread(&ScopeCapture::run, this);
+    }
+
+    void stop()
+    {
+        if (!m_running)
+            return;
+        m_stop = true;
+        m_thread.join();
+        m_running = false;
+        rp_AcqStop();
+    }
+
+    // Consumer side: the newest frame not taken yet, else NULL. Valid until
+    // the next call.
+    const ScopeFrame *take()
+    {
+        if (!m_buffer.update())
+            return NULL;
+        m_taken++;
+        return &m_buffer.front();
+    }
+
+    // Seconds since start()
+    double seconds() const { return (now_ns() - m_start_ns) * 1e-9; }
+
+    ScopeStats stats()
+    {
+        ScopeStats s;
+        const int64_t now = now_ns();
+        s.frames = m_frames;
+        s.taken = m_taken;
+        s.dropped = m_dropped;
+        s.auto_triggers = m_auto_triggers;
+        s.errors = m_errors;
+
+        const int64_t capture_ns = m_capture_ns;
+        const uint64_t frames = s.frames - m_last_frames;
+        const double window = (now - m_last_ns) * 1e-9;
+        s.refresh_rate = window > 0 ? frames / window : 0;
+        s.capture_ms = frames ? (capture_ns - m_last_capture_ns) * 1e-6 / frames : 0;
+        m_last_ns = now;
+        m_last_frames = s.frames;
+        m_last_capture_ns = capture_ns;
+        return s;
+    }
+
+private:
+    static int64_t now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    static void sleep_until(int64_t ns)
+    {
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000LL;
+        ts.tv_nsec = ns % 1000000000LL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+               EINTR)
+        {
+        }
+    }
+
+    // Applies new settings, returns the capture length in seconds at the
+    // decimation the acquisition really runs at. A factor it refuses falls
+    // back to the power of two below, which it always takes.
+    double apply(const ScopeSettings &s)
+    {
+        uint32_t decimation = s.decimation;
+        if (rp_AcqSetDecimationFactor(decimation) != RP_OK)
+        {
+            uint32_t fallback = 1;
+            while (fallback * 2 <= decimation && fallback < 65536)
+                fallback *= 2;
+            fprintf(stderr, "Decimation %u refused, using %u\n", decimation, fallback);
+            decimation = fallback;
+            if (rp_AcqSetDecimationFactor(decimation) != RP_OK)
+                m_errors++;
+        }
+        uint32_t actual = 0;
+        if (rp_AcqGetDecimationFactor(&actual) == RP_OK && actual)
+            decimation = actual;
+        if (rp_AcqSetTriggerLevel(RP_T_CH_1, s.trigger_level) != RP_OK)
+        {
+            fprintf(stderr, "Trigger level %.3f refused\n", s.trigger_level);
+            m_errors++;
+        }
+        // Trigger in the middle of the buffer
+        rp_AcqSetTriggerDelay(0);
+        return (double)ADC_BUFFER_SIZE * decimation /
+               rp_HPGetBaseFastADCSpeedHzOrDefault();
+    }
+
+    // False once the capture should be abandoned: stopped, or settings
+    // newer than applied were configured
+    bool keep_capturing(uint64_t applied) const
+    {
+        return !m_stop && m_settings_version.load() == applied;
+    }
+
+    // Sleeps until ns in steps of poll_ns, false if the capture was
+    // abandoned meanwhile
+    bool wait_until(int64_t ns, int64_t poll_ns, uint64_t applied)
+    {
+        for (int64_t now = now_ns(); now < ns; now = now_ns())
+        {
+            if (!keep_capturing(applied))
+                return false;
+            sleep_until(now + poll_ns < ns ? now + poll_ns : ns);
+        }
+        return keep_capturing(applied);
+    }
+
+    // One capture into m_samples. Returns false on an API error, on stop
+    // and when settings newer than applied came in, which a normal trigger
+    // that never comes would otherwise hold up forever.
+    bool capture(const ScopeSettings &s, double span, uint64_t applied, bool *triggered)
+    {
+        if (rp_AcqStart() != RP_OK)
+            return false;
+
+        // Poll every 10th of the capture but at least every 200 us and at
+        // most every 5 ms
+        int64_t poll_ns = (int64_t)(span / 10 * 1e9);
+        poll_ns = poll_ns < 200000 ? 200000 : poll_ns > 5000000 ? 5000000 : poll_ns;
+
+        // The half of the buffer before the trigger has to be written first
+        if (!wait_until(now_ns() + (int64_t)(span / 2 * 1e9), poll_ns, applied))
+            return false;
+
+        const rp_acq_trig_src_t source =
+            s.trigger_source == 0 ? RP_TRIG_SRC_CHA_PE :
+            s.trigger_source == 1 ? RP_TRIG_SRC_CHA_NE : RP_TRIG_SRC_NOW;
+        rp_AcqSetTriggerSrc(source);
+        *triggered = source != RP_TRIG_SRC_NOW;
+
+        const int64_t timeout = now_ns() + (int64_t)s.trigger_timeout_ms * 1000000;
+        rp_acq_trig_state_t state = RP_TRIG_STATE_WAITING;
+        bool forced = false;
+        while (keep_capturing(applied))
+        {
+            if (rp_AcqGetTriggerState(&state) != RP_OK)
+                return false;
+            if (state == RP_TRIG_STATE_TRIGGERED)
+                break;
+            if (s.trigger_auto && !forced && now_ns() >= timeout)
+            {
+                rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
+                forced = true;
+                *triggered = false;
+            }
+            sleep_until(now_ns() + poll_ns);
+        }
+
+        // The half after the trigger
+        bool filled = false;
+        while (keep_capturing(applied))
+        {
+            if (rp_AcqGetBufferFillState(&filled) != RP_OK)
+                return false;
+            if (filled)
+                break;
+            sleep_until(now_ns() + poll_ns);
+        }
+        if (!keep_capturing(applied))
+            return false;
+
+        uint32_t trigger = 0;
+        uint32_t size = ADC_BUFFER_SIZE;
+        if (rp_AcqGetWritePointerAtTrig(&trigger) != RP_OK)
+            return false;
+        const uint32_t first = (trigger + ADC_BUFFER_SIZE - ADC_BUFFER_SIZE / 2) % ADC_BUFFER_SIZE;
+        if (rp_AcqGetDataV(RP_CH_1, first, &size, m_samples.data()) != RP_OK)
+            return false;
+        if (forced)
+            m_auto_triggers++;
+        return true;
+    }
+
+    void run()
+    {
+        m_samples.resize(ADC_BUFFER_SIZE);
+        uint64_t applied = (uint64_t)-1;
+        ScopeSettings settings;
+        double span = 0;
+        int64_t next = now_ns();
+
+        while (!m_stop)
+        {
+            sleep_until(next);
+            const int64_t start = now_ns();
+            next = start + m_min_period_ns;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (applied != m_settings_version)
+                {
+                    settings = m_settings;
+                    applied = m_settings_version;
+                    span = -1;
+                }
+            }
+            if (span < 0)
+            {
+                rp_AcqStop();
+                span = apply(settings);
+            }
+
+            bool triggered = false;
+            if (!capture(settings, span, applied, &triggered))
+            {
+                // Abandoned for new settings, apply them right away
+                if (keep_capturing(applied))
+                {
+                    m_errors++;
+                    // Do not hammer a failing API
+                    next = now_ns() + 100000000LL;
+                }
+                continue;
+            }
+
+            ScopeFrame &frame = m_buffer.back();
+            frame.min.resize(m_columns);
+            frame.max.resize(m_columns);
+            downsample_min_max(m_samples.data(), ADC_BUFFER_SIZE,
+                               frame.min.data(), frame.max.data(), m_columns);
+            frame.sequence = m_frames;
+            frame.triggered = triggered;
+            frame.span = span;
+            if (m_sink)
+                m_sink(m_samples.data(), ADC_BUFFER_SIZE, frame);
+            if (!m_buffer.publish())
+                m_dropped++;
+            m_frames++;
+            m_capture_ns += now_ns() - start;
+        }
+    }
+
+    int m_columns;
+    int64_t m_min_period_ns;
+    CaptureSink m_sink;
+
+    std::mutex m_mutex;
+    ScopeSettings m_settings;
+    std::atomic<uint64_t> m_settings_version;
+
+    std::thread m_thread;
+    bool m_running;
+    std::atomic<bool> m_stop;
+    std::vector<float> m_samples;
+    TripleBuffer<ScopeFrame> m_buffer;
+
+    std::atomic<uint64_t> m_frames;
+    std::atomic<uint64_t> m_taken;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_auto_triggers;
+    std::atomic<uint64_t> m_errors;
+    std::atomic<int64_t> m_capture_ns;
+
+    // Start and the previous stats() call
+    int64_t m_start_ns;
+    int64_t m_last_ns;
+    uint64_t m_last_frames;
+    int64_t m_last_capture_ns;
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+
+#include <atomic>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+
+
+
+// Ring of signal frames in POSIX shared memory, written by one process and
+// read by any number of others without copies and without locks. Readers
+// only map it read-only and never slow the writer down; a reader that falls
+// more than a ring behind loses the oldest frames.
+//
+// Every slot is guarded by a sequence lock: the writer makes its sequence
+// odd, writes the frame, then makes it even again. A reader that sees the
+// same even sequence before and after reading a slot read a whole frame.
+// Frame n lives in slot n % slots, written under sequence 2n + 1, complete
+// under 2n + 2.
+//
+//   ShmRingHeader   magic, layout, frames published, futex word
+//   slots times:
+//     ShmRingSlot   sequence and metadata of the frame
+//     float[]       capacity values
+#define SHM_RING_MAGIC   0x52535052  // "RPSR"
+#define SHM_RING_VERSION 1
+
+
+struct ShmRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t capacity;
+    // Bytes from one slot to the next
+    uint64_t slot_size;
+    // Cleared when the writer goes away
+    std::atomic<uint32_t> open;
+    // Bumped after every frame, readers wait on it with a futex
+    std::atomic<uint32_t> wake;
+    // Frames published so far
+    alignas(64) std::atomic<uint64_t> published;
+};
+
+
+// What a frame is, besides its values
+struct ShmFrameInfo
+{
+    uint64_t number;
+    // CLOCK_MONOTONIC when the frame was published, ns
+    int64_t time_ns;
+    // Samples per second of the values and index of the trigger among them
+    double sample_rate;
+    uint32_t count;
+    uint32_t trigger_index;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+#define SHM_FRAME_TRIGGERED 0x01
+
+
+struct ShmRingSlot
+{
+    alignas(64) std::atomic<uint64_t> sequence;
+    ShmFrameInfo info;
+    // Values follow, 64 byte aligned
+    alignas(64) float values[1];
+};
+
+
+inline int64_t shm_ring_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+// Creates the ring and publishes frames into it
+class ShmRingWriter
+{
+public:
+    ShmRingWriter() : m_header(NULL), m_size(0), m_frames(0) {}
+
+    ~ShmRingWriter() { close(); }
+
+    // Replaces a ring of the same name left behind. Returns false on error.
+    bool create(const std::string &name, uint32_t slots, uint32_t capacity)
+    {
+        close();
+        m_name = name;
+        const uint64_t slot_size = ((offsetof(ShmRingSlot, values) + (uint64_t)capacity * sizeof(float)) + 63) / 64 * 64;
+        m_size = slot_offset() + slots * slot_size;
+
+        shm_unlink(name.c_str());
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return false;
+        void *memory = MAP_FAILED;
+        if (ftruncate(fd, m_size) == 0)
+            memory = mmap(NULL, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED)
+        {
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        // Fresh memory is zero: every slot sequence says empty
+        m_header = (ShmRingHeader *)memory;
+        m_header->slots = slots;
+        m_header->capacity = capacity;
+        m_header->slot_size = slot_size;
+        m_header->version = SHM_RING_VERSION;
+        m_header->open.store(1, std::memory_order_relaxed);
+        // The magic last, a reader checks it first
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->magic = SHM_RING_MAGIC;
+        return true;
+    }
+
+    // Marks the ring closed for readers and removes its name. Readers that
+    // still have it mapped keep the last frames.
+    void close()
+    {
+        if (!m_header)
+            return;
+        m_header->open.store(0, std::memory_order_release);
+        wake();
+        munmap(m_header, m_size);
+        shm_unlink(m_name.c_str());
+        m_header = NULL;
+    }
+
+    bool is_open() const { return m_header != NULL; }
+
+    // Publishes count values, at most capacity of them
+    void publish(const float *values, uint32_t count, const ShmFrameInfo &info)
+    {
+        if (!m_header)
+            return;
+        if (count > m_header->capacity)
+            count = m_header->capacity;
+
+        const uint64_t n = m_header->published.load(std::memory_order_relaxed);
+        ShmRingSlot *slot = (ShmRingSlot *)((char *)m_header + slot_offset() + (n % m_header->slots) * m_header->slot_size);
+
+        slot->sequence.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot->info = info;
+        slot->info.number = n;
+        slot->info.count = count;
+        slot->info.time_ns = shm_ring_now_ns();
+        memcpy(slot->values, values, count * sizeof(float));
+        slot->sequence.store(2 * n + 2, std::memory_order_release);
+
+        m_header->published.store(n + 1, std::memory_order_release);
+        m_header->wake.fetch_add(1, std::memory_order_release);
+        wake();
+        m_frames++;
+    }
+
+    uint64_t frames() const { return m_frames; }
+
+    static uint64_t slot_offset() { return (sizeof(ShmRingHeader) + 63) / 64 * 64; }
+
+private:
+    void wake()
+    {
+        syscall(SYS_futex, &m_header->wake, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+    }
+
+    std::string m_name;
+    ShmRingHeader *m_header;
+    uint64_t m_size;
+    uint64_t m_frames;
+};
+
+
+// Reads frames of a ring in order. Not thread safe, one per reading thread.
+//
+//   ShmRingReader reader;
+//   reader.open("/rp_scope");
+//   ShmFrameInfo info;
+//   while (const float *values = reader.next(&info, 1000))
+//   {
+//       ... use info.count values ...
+//       if (!reader.still_valid())
+//           ... the writer overwrote them meanwhile, drop the result ...
+//   }
+class ShmRingReader
+{
+public:
+    ShmRingReader() : m_header(NULL), m_size(0), m_next(0), m_current(0), m_lost(0) {}
+
+    ~ShmRingReader() { close(); }
+
+    // Starts at the newest frame. Returns false while there is no ring.
+    bool open(const std::string &name)
+    {
+        close();
+        const int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        void *memory = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= ShmRingWriter::slot_offset())
+            memory = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED)
+            return false;
+
+        m_header = (const ShmRingHeader *)memory;
+        m_size = st.st_size;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_header->magic != SHM_RING_MAGIC || m_header->version != SHM_RING_VERSION ||
+            ShmRingWriter::slot_offset() + m_header->slots * m_header->slot_size > m_size)
+        {
+            close();
+            return false;
+        }
+        const uint64_t published = m_header->published.load(std::memory_order_acquire);
+        m_next = published ? published - 1 : 0;
+        m_lost = 0;
+        return true;
+    }
+
+    void close()
+    {
+        if (m_header)
+            munmap((void *)m_header, m_size);
+        m_header = NULL;
+    }
+
+    // False once the writer closed the ring
+    bool writer_open() const
+    {
+        return m_header && m_header->open.load(std::memory_order_acquire);
+    }
+
+    uint32_t capacity() const { return m_header ? m_header->capacity : 0; }
+
+    // The values of the next frame in the shared memory, waiting up to
+    // timeout_ms for it. NULL on timeout or when the writer closed the ring.
+    // Frames the writer overwrote before they were read are skipped and
+    // counted as lost.
+    const float *next(ShmFrameInfo *info, int timeout_ms)
+    {
+        if (!m_header)
+            return NULL;
+        const int64_t deadline = shm_ring_now_ns() + (int64_t)timeout_ms * 1000000;
+        while (true)
+        {
+            const uint32_t wake = m_header->wake.load(std::memory_order_acquire);
+            const uint64_t published = m_header->published.load(std::memory_order_acquire);
+            if (published > m_next)
+            {
+                // Lapped: the oldest slot still in the ring
+                if (published - m_next > m_header->slots)
+                {
+                    m_lost += published - m_header->slots - m_next;
+                    m_next = published - m_header->slots;
+                }
+                const ShmRingSlot *s = slot(m_next);
+                const uint64_t sequence = s->sequence.load(std::memory_order_acquire);
+                if (sequence == 2 * m_next + 2)
+                {
+                    *info = s->info;
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (s->sequence.load(std::memory_order_relaxed) == sequence)
+                    {
+                        m_current = m_next++;
+                        return s->values;
+                    }
+                }
+                // Overwritten while looking at it
+                m_lost++;
+                m_next++;
+                continue;
+            }
+            if (!m_header->open.load(std::memory_order_acquire))
+                return NULL;
+
+            const int64_t left = deadline - shm_ring_now_ns();
+            if (left <= 0)
+                return NULL;
+            struct timespec timeout;
+            timeout.tv_sec = left / 1000000000LL;
+            timeout.tv_nsec = left % 1000000000LL;
+            syscall(SYS_futex, &m_header->wake, FUTEX_WAIT, wake, &timeout, NULL, 0);
+        }
+    }
+
+    // True while the values last returned by next() were not overwritten.
+    // Check it after using them.
+    bool still_valid() const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot(m_current)->sequence.load(std::memory_order_relaxed) == 2 * m_current + 2;
+    }
+
+    // next() and a checked copy, for readers that keep frames
+    bool copy_next(float *values, ShmFrameInfo *info, int timeout_ms)
+    {
+        while (const float *shared = next(info, timeout_ms))
+        {
+            memcpy(values, shared, info->count * sizeof(float));
+            if (still_valid())
+                return true;
+            m_lost++;
+        }
+        return false;
+    }
+
+    // Frames skipped because the writer overwrote them first
+    uint64_t lost() const { return m_lost; }
+
+private:
+    const ShmRingSlot *slot(uint64_t n) const
+    {
+        return (const ShmRingSlot *)((const char *)m_header + ShmRingWriter::slot_offset() + (n % m_header->slots) * m_header->slot_size);
+    }
+
+    const ShmRingHeader *m_header;
+    uint64_t m_size;
+    uint64_t m_next;
+    uint64_t m_current;
+    uint64_t m_lost;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+
+
+
+// Times the stages of the startup of an app from the moment it is loaded,
+// for the log and for read-only parameters. mark() closes the stage that
+// began with the previous mark, or with the load.
+class StartupProfile
+{
+public:
+    StartupProfile() : m_start_ns(now_ns()), m_last_ns(m_start_ns), m_first_frame_ns(0) {}
+
+    // Restarts the clock, for an app loaded again in the same process
+    void restart()
+    {
+        m_start_ns = now_ns();
+        m_last_ns = m_start_ns;
+        m_first_frame_ns = 0;
+        m_stages.clear();
+    }
+
+    // Ends a stage, returns its time in ms
+    double mark(const std::string &name)
+    {
+        const int64_t now = now_ns();
+        const double ms = (now - m_last_ns) * 1e-6;
+        m_stages.push_back(Stage(name, ms));
+        m_last_ns = now;
+        return ms;
+    }
+
+    // Skips the time since the last mark, such as waiting for a client
+    void skip() { m_last_ns = now_ns(); }
+
+    // Records the first frame handed to the web SDK, only the first call
+    // counts
+    void first_frame()
+    {
+        if (!m_first_frame_ns)
+            m_first_frame_ns = now_ns();
+    }
+
+    // Sum of the stages, ms
+    double total_ms() const
+    {
+        double total = 0;
+        for (size_t i = 0; i < m_stages.size(); i++)
+            total += m_stages[i].ms;
+        return total;
+    }
+
+    // From the load to the first frame, ms, 0 before it
+    double first_frame_ms() const
+    {
+        return m_first_frame_ns ? (m_first_frame_ns - m_start_ns) * 1e-6 : 0;
+    }
+
+    void log(const char *app) const
+    {
+        fprintf(stderr, "%s startup:", app);
+        for (size_t i = 0; i < m_stages.size(); i++)
+            fprintf(stderr, "%s %s %.1f ms", i ? "," : "", m_stages[i].name.c_str(), m_stages[i].ms);
+        fprintf(stderr, "; %.1f ms in total, first frame after %.1f ms\n", total_ms(), first_frame_ms());
+    }
+
+private:
+    struct Stage
+    {
+        Stage(const std::string &n, double t) : name(n), ms(t) {}
+        std::string name;
+        double ms;
+    };
+
+    static int64_t now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    int64_t m_start_ns;
+    int64_t m_last_ns;
+    int64_t m_first_frame_ns;
+    std::vector<Stage> m_stages;
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+
+#include <atomic>
+#include <errno.h>
+#include <functional>
+#include <stdint.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#include "frame_queue.h"
+
+
+
+
+struct AcquisitionFrame
+{
+    uint64_t sequence;
+    std::vector<float> values;
+};
+
+
+struct AcquisitionStats
+{
+    // Frames completed by the producer, taken by the consumer and lost
+    // because the queue was full
+    uint64_t frames;
+    uint64_t taken;
+    uint64_t dropped;
+    uint64_t read_errors;
+    // Seconds since start()
+    double seconds;
+    // Frames per second since the previous call of stats()
+    double producer_rate;
+    double consumer_rate;
+};
+
+
+// Reads one value every period_us on its own thread, whatever the web SDK
+// is doing, and hands them over in frames of frame_samples values through
+// a queue of queue_frames frames. A slow read never delays the websocket
+// and the update interval never limits the acquisition. The consumer takes
+// every frame in order, so the values form one contiguous stream; only
+// when the consumer falls behind by a whole queue are the newest frames
+// dropped, and the stream has a gap there.
+class AcquisitionThread
+{
+public:
+    typedef std::function<bool(float *value)> ReadFunction;
+
+    AcquisitionThread(ReadFunction read, int period_us, int frame_samples,
+                      int queue_frames = 64)
+        : m_read(read), m_period_ns((int64_t)period_us * 1000),
+          m_frame_samples(frame_samples), m_running(false), m_stop(false),
+          m_queue(queue_frames), m_holding(false),
+          m_frames(0), m_taken(0), m_dropped(0), m_read_errors(0),
+          m_start_ns(0), m_last_ns(0), m_last_frames(0), m_last_taken(0)
+    {
+    }
+
+    ~AcquisitionThread() { stop(); }
+
+    void start()
+    {
+        if (m_running)
+            return;
+        m_stop = false;
+        m_start_ns = now_ns();
+        m_last_ns = m_start_ns;
+        m_running = true;
+        m_thread = std::thread(&AcquisitionThread::run, this);
+    }
+
+    void stop()
+    {
+        if (!m_running)
+            return;
+        m_stop = true;
+        m_thread.join();
+        m_running = false;
+    }
+
+    // Consumer side: the oldest frame that was not taken yet, else NULL.
+    // Valid until the next call.
+    const AcquisitionFrame *take()
+    {
+        if (m_holding)
+            m_queue.pop();
+        const AcquisitionFrame *frame = m_queue.front();
+        m_holding = frame != NULL;
+        if (frame)
+            m_taken++;
+        return frame;
+    }
+
+    // Seconds since start()
+    double seconds() const { return (now_ns() - m_start_ns) * 1e-9; }
+
+    AcquisitionStats stats()
+    {
+        AcquisitionStats s;
+        const int64_t now = now_ns();
+        s.frames = m_frames;
+        s.taken = m_taken;
+        s.dropped = m_dropped;
+        s.read_errors = m_read_errors;
+        s.seconds = (now - m_start_ns) * 1e-9;
+
+        const double window = (now - m_last_ns) * 1e-9;
+        s.producer_rate = window > 0 ? (s.frames - m_last_frames) / window : 0;
+        s.consumer_rate = window > 0 ? (s.taken - m_last_taken) / window : 0;
+        m_last_ns = now;
+        m_last_frames = s.frames;
+        m_last_taken = s.taken;
+        return s;
+    }
+
+private:
+    static int64_t now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    static void sleep_until(int64_t ns)
+    {
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000LL;
+        ts.tv_nsec = ns % 1000000000LL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+               EINTR)
+        {
+        }
+    }
+
+    void run()
+    {
+        int64_t deadline = now_ns();
+        float last = 0.0f;
+        while (!m_stop)
+        {
+            AcquisitionFrame &frame = m_queue.back();
+            frame.values.resize(m_frame_samples);
+            for (int i = 0; i < m_frame_samples && !m_stop; i++)
+            {
+                sleep_until(deadline);
+                // A read that overran its period moves the schedule instead
+                // of reading back to back to catch up
+                deadline += m_period_ns;
+                const int64_t now = now_ns();
+                if (deadline < now)
+                    deadline = now;
+
+                float value;
+                if (m_read(&value))
+                    last = value;
+                else
+                    m_read_errors++;
+                frame.values[i] = last;
+            }
+            if (m_stop)
+                break;
+
+            frame.sequence = m_frames;
+            if (!m_queue.push())
+                m_dropped++;
+            m_frames++;
+        }
+    }
+
+    ReadFunction m_read;
+    int64_t m_period_ns;
+    int m_frame_samples;
+
+    std::thread m_thread;
+    bool m_running;
+    std::atomic<bool> m_stop;
+    FrameQueue<AcquisitionFrame> m_queue;
+    // take() returned the front frame, pop it on the next call
+    bool m_holding;
+
+    std::atomic<uint64_t> m_frames;
+    std::atomic<uint64_t> m_taken;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_read_errors;
+
+    // Start and the previous stats() call
+    int64_t m_start_ns;
+    int64_t m_last_ns;
+    uint64_t m_last_frames;
+    uint64_t m_last_taken;
+};
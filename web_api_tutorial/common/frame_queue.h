@@ -0,0 +1,62 @@
+#pragma once
+
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+
+
+
+// Bounded queue of frames from one producer thread to one consumer, in
+// order and without locks. Frames are filled and read in place, so frames
+// that own memory are not copied. One slot more than the capacity belongs
+// to the producer: it fills back() and push() hands it over. When the
+// queue is full push() fails and the producer refills the same slot, so
+// the frames that are lost are the newest ones and the consumer sees every
+// frame it gets in order, with a gap only where the queue overflowed.
+template <typename Frame>
+class FrameQueue
+{
+public:
+    explicit FrameQueue(int capacity)
+        : m_slots(capacity + 1), m_head(0), m_tail(0)
+    {
+    }
+
+    int capacity() const { return (int)m_slots.size() - 1; }
+
+    // Producer side: the frame to fill next
+    Frame &back() { return m_slots[m_head.load(std::memory_order_relaxed) % m_slots.size()]; }
+
+    // Queues the back frame. Returns false when the queue is full, the back
+    // frame then stays with the producer.
+    bool push()
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= (uint64_t)capacity())
+            return false;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: the oldest queued frame, NULL when there is none.
+    // Valid until pop().
+    const Frame *front() const
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+            return NULL;
+        return &m_slots[tail % m_slots.size()];
+    }
+
+    // Gives the front frame back to the producer
+    void pop() { m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+    std::vector<Frame> m_slots;
+    // Frames queued and frames taken, free running
+    std::atomic<uint64_t> m_head;
+    std::atomic<uint64_t> m_tail;
+};
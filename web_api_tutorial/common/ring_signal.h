@@ -0,0 +1,110 @@
+#pragma once
+
+
+#include <stdint.h>
+#include <vector>
+
+
+
+
+// Fixed size history of samples behind a signal. Pushing a sample is O(1):
+// it overwrites the oldest one instead of shifting the whole history.
+//
+// publish_new() writes only the samples pushed since the last frame, so the
+// client appends them to its own copy of the history. The whole history,
+// oldest first, is written instead when there are too many new samples,
+// after resend(), and when the gain or offset changed, as they are applied
+// to every sample of the frame and not stored. A client tells the two
+// apart by the size: a full frame holds capacity() samples, an incremental
+// one fewer.
+class RingSignal
+{
+public:
+    RingSignal(int capacity, float value = 0.0f)
+        : m_data(capacity, value), m_head(0), m_pushed(0), m_published(0),
+          m_gain(1.0f), m_offset(0.0f), m_sent(false),
+          m_full_frames(0), m_new_frames(0), m_samples_sent(0)
+    {
+    }
+
+    int capacity() const { return (int)m_data.size(); }
+
+    void push(float value)
+    {
+        m_data[m_head] = value;
+        m_head = m_head + 1 == capacity() ? 0 : m_head + 1;
+        m_pushed++;
+    }
+
+    // Writes the samples pushed since the last frame, or the whole history
+    template <typename Signal>
+    void publish_new(Signal &signal, float gain = 1.0f, float offset = 0.0f)
+    {
+        next_frame(m_frame, gain, offset);
+
+        const int n = (int)m_frame.size();
+        if (signal.GetSize() != n)
+            signal.Resize(n);
+        for (int i = 0; i < n; i++)
+            signal[i] = m_frame[i];
+    }
+
+    // Same as publish_new() into a vector, for frames encoded elsewhere.
+    // Returns true for the whole history, false for only the new samples.
+    bool next_frame(std::vector<float> &out, float gain = 1.0f,
+                    float offset = 0.0f)
+    {
+        const uint64_t fresh = m_pushed - m_published;
+        const bool full = !m_sent || gain != m_gain || offset != m_offset ||
+                          fresh >= (uint64_t)capacity();
+        const int n = full ? capacity() : (int)fresh;
+        out.resize(n);
+
+        // Oldest sample is at the head when the whole history is written
+        int index = m_head - n;
+        if (index < 0)
+            index += capacity();
+        for (int i = 0; i < n; i++)
+        {
+            out[i] = m_data[index] * gain + offset;
+            index = index + 1 == capacity() ? 0 : index + 1;
+        }
+
+        m_published = m_pushed;
+        m_gain = gain;
+        m_offset = offset;
+        m_sent = true;
+        m_samples_sent += n;
+        if (full)
+            m_full_frames++;
+        else if (n)
+            m_new_frames++;
+        return full;
+    }
+
+    // Makes the next frame hold the whole history, for a client that lost
+    // track of it or joined late
+    void resend() { m_sent = false; }
+
+    uint64_t full_frames() const { return m_full_frames; }
+    uint64_t new_frames() const { return m_new_frames; }
+    uint64_t samples_sent() const { return m_samples_sent; }
+
+private:
+    std::vector<float> m_data;
+    // Next sample to overwrite, the oldest one
+    int m_head;
+    uint64_t m_pushed;
+    uint64_t m_published;
+
+    // What the last frame was written with
+    float m_gain;
+    float m_offset;
+    bool m_sent;
+
+    uint64_t m_full_frames;
+    uint64_t m_new_frames;
+    uint64_t m_samples_sent;
+
+    std::vector<float> m_frame;
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+
+
+
+// Binary signal frames. The web SDK turns every signal value into JSON text
+// and deflates it; a frame instead packs the values of one signal update
+// into a small typed header and a raw payload, encoded base64 so that it
+// can travel as the value of a string parameter. Parameters stay JSON.
+//
+// Frame layout, little endian:
+//   0  uint8    version, 1
+//   1  uint8    format, FRAME_FLOAT32, FRAME_INT16 or FRAME_FLOAT16
+//   2  uint8    flags, FRAME_FULL and FRAME_DELTA
+//   3  uint8    reserved
+//   4  uint32   sequence, +1 per frame
+//   8  uint32   count of values
+//   12 float32  scale, int16 only
+//   16 float32  offset, int16 only
+//   20          count values: float32, int16 codes or float16
+//
+// An int16 value is code * scale + offset, with scale and offset chosen per
+// frame so the codes span the values. With FRAME_DELTA the codes after the
+// first are differences to the one before, modulo 2^16.
+enum FrameFormat
+{
+    FRAME_JSON = 0,
+    FRAME_FLOAT32 = 1,
+    FRAME_INT16 = 2,
+    FRAME_INT16_DELTA = 3,
+    FRAME_FLOAT16 = 4
+};
+
+#define FRAME_VERSION       1
+#define FRAME_HEADER_SIZE   20
+#define FRAME_FULL          0x01
+#define FRAME_DELTA         0x02
+
+
+class SignalFrameEncoder
+{
+public:
+    SignalFrameEncoder() : m_sequence(0), m_frames(0), m_bytes(0) {}
+
+    // Encodes values as a base64 frame of the given format, FRAME_FLOAT32
+    // to FRAME_FLOAT16. The result stays valid until the next call.
+    const std::string &encode(const float *values, int count, int format,
+                              bool full)
+    {
+        const bool delta = format == FRAME_INT16_DELTA;
+        const int type = delta ? FRAME_INT16 : format;
+        const int width = type == FRAME_FLOAT32 ? 4 : 2;
+
+        m_binary.resize(FRAME_HEADER_SIZE + count * width);
+        uint8_t *p = m_binary.data();
+        p[0] = FRAME_VERSION;
+        p[1] = type;
+        p[2] = (full ? FRAME_FULL : 0) | (delta ? FRAME_DELTA : 0);
+        p[3] = 0;
+        put32(p + 4, m_sequence++);
+        put32(p + 8, count);
+
+        float scale = 1.0f;
+        float offset = 0.0f;
+        uint8_t *out = p + FRAME_HEADER_SIZE;
+        if (type == FRAME_FLOAT32)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                uint32_t bits;
+                memcpy(&bits, &values[i], 4);
+                put32(out + 4 * i, bits);
+            }
+        }
+        else if (type == FRAME_INT16)
+        {
+            // Codes -32767 to 32767 over the range of the values
+            float lo = count ? values[0] : 0.0f;
+            float hi = lo;
+            for (int i = 1; i < count; i++)
+            {
+                lo = values[i] < lo ? values[i] : lo;
+                hi = values[i] > hi ? values[i] : hi;
+            }
+            offset = (lo + hi) / 2;
+            scale = hi > lo ? (hi - lo) / 65534 : 1.0f;
+
+            uint16_t last = 0;
+            for (int i = 0; i < count; i++)
+            {
+                uint16_t code =
+                    (uint16_t)(int16_t)lrintf((values[i] - offset) / scale);
+                put16(out + 2 * i, delta ? (uint16_t)(code - last) : code);
+                last = code;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < count; i++)
+                put16(out + 2 * i, half(values[i]));
+        }
+
+        uint32_t bits;
+        memcpy(&bits, &scale, 4);
+        put32(p + 12, bits);
+        memcpy(&bits, &offset, 4);
+        put32(p + 16, bits);
+
+        base64(m_binary, m_text);
+        m_frames++;
+        m_bytes += m_text.size();
+        return m_text;
+    }
+
+    // Sequence number of the next frame
+    void set_sequence(uint32_t sequence) { m_sequence = sequence; }
+
+    uint64_t frames() const { return m_frames; }
+    // Base64 characters produced
+    uint64_t bytes() const { return m_bytes; }
+
+private:
+    static void put16(uint8_t *p, uint16_t v)
+    {
+        p[0] = v;
+        p[1] = v >> 8;
+    }
+
+    static void put32(uint8_t *p, uint32_t v)
+    {
+        p[0] = v;
+        p[1] = v >> 8;
+        p[2] = v >> 16;
+        p[3] = v >> 24;
+    }
+
+    // IEEE half precision, rounded to nearest, no subnormals (flushed to 0)
+    static uint16_t half(float value)
+    {
+        uint32_t f;
+        memcpy(&f, &value, 4);
+        const uint16_t sign = (f >> 16) & 0x8000;
+        const int exponent = (int)((f >> 23) & 0xff) - 127 + 15;
+        const uint32_t mantissa = f & 0x7fffff;
+
+        if (((f >> 23) & 0xff) == 0xff)
+            return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+        if (exponent >= 31)
+            return sign | 0x7c00;
+        if (exponent <= 0)
+            return sign;
+
+        uint32_t h = ((uint32_t)exponent << 10) | (mantissa >> 13);
+        // Round to nearest even, a carry into the exponent is correct
+        const uint32_t rest = mantissa & 0x1fff;
+        if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+            h++;
+        return sign | (h > 0x7c00 ? 0x7c00 : h);
+    }
+
+    static void base64(const std::vector<uint8_t> &in, std::string &out)
+    {
+        static const char digits[] =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        const size_t n = in.size();
+        out.resize((n + 2) / 3 * 4);
+        char *o = &out[0];
+        size_t i = 0;
+        for (; i + 3 <= n; i += 3)
+        {
+            const uint32_t v = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+            *o++ = digits[v >> 18];
+            *o++ = digits[(v >> 12) & 63];
+            *o++ = digits[(v >> 6) & 63];
+            *o++ = digits[v & 63];
+        }
+        if (i < n)
+        {
+            const uint32_t v =
+                (in[i] << 16) | (i + 1 < n ? in[i + 1] << 8 : 0);
+            *o++ = digits[v >> 18];
+            *o++ = digits[(v >> 12) & 63];
+            *o++ = i + 1 < n ? digits[(v >> 6) & 63] : '=';
+            *o++ = '=';
+        }
+    }
+
+    uint32_t m_sequence;
+    std::vector<uint8_t> m_binary;
+    std::string m_text;
+
+    uint64_t m_frames;
+    uint64_t m_bytes;
+};
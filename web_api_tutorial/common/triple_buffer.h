@@ -0,0 +1,56 @@
+#pragma once
+
+
+#include <atomic>
+
+
+
+
+// Hands the latest complete frame from one producer thread to one consumer
+// without locks and without either side waiting. Of the three frames the
+// producer fills the back one, the consumer reads the front one and the
+// middle one is exchanged between them. A frame published while the
+// previous one was still waiting in the middle replaces it: the consumer
+// only ever sees the newest frame, so use it where only the newest frame
+// matters, not for a stream that has to stay contiguous.
+template <typename Frame>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : m_middle(0), m_back(1), m_front(2) {}
+
+    // Producer side
+    Frame &back() { return m_frames[m_back]; }
+
+    // Makes the back frame the newest one. Returns false when it replaced
+    // a frame the consumer never took.
+    bool publish()
+    {
+        unsigned old = m_middle.exchange(m_back | FRESH);
+        m_back = old & INDEX;
+        return !(old & FRESH);
+    }
+
+    // Consumer side: moves the newest frame to the front, if there is one
+    // the consumer has not taken yet
+    bool update()
+    {
+        if (!(m_middle.load() & FRESH))
+            return false;
+        unsigned old = m_middle.exchange(m_front);
+        m_front = old & INDEX;
+        return true;
+    }
+
+    const Frame &front() const { return m_frames[m_front]; }
+
+private:
+    static const unsigned INDEX = 3;
+    static const unsigned FRESH = 4;
+
+    Frame m_frames[3];
+    // Index of the middle frame, FRESH while the consumer has not taken it
+    std::atomic<unsigned> m_middle;
+    int m_back;
+    int m_front;
+};